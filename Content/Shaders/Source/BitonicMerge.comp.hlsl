@@ -0,0 +1,22 @@
+// One step of a bitonic merge whose elements are too far apart for one
+// block, J >= SORT_BLOCK_SIZE. Each thread compares and swaps one pair.
+#include "SpriteSort.hlsli"
+
+[numthreads(SORT_GROUP_SIZE, 1, 1)]
+void main(uint3 id : SV_DispatchThreadID)
+{
+    uint i = PairFirst(id.x, J);
+    if (i + J >= PaddedCount)
+    {
+        return;
+    }
+
+    bool ascending = (i & K) == 0;
+    uint2 a = SortKeys[i];
+    uint2 b = SortKeys[i + J];
+    if (Greater(a, b) == ascending)
+    {
+        SortKeys[i] = b;
+        SortKeys[i + J] = a;
+    }
+}
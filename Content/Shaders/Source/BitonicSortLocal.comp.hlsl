@@ -0,0 +1,38 @@
+// The steps of the bitonic sort that stay within one block, done in group
+// shared memory. With K = 0 it sorts every block from scratch, alternating
+// direction, otherwise it finishes merge K from J = SORT_BLOCK_SIZE / 2 down.
+#include "SpriteSort.hlsli"
+
+groupshared uint2 Block[SORT_BLOCK_SIZE];
+
+[numthreads(SORT_GROUP_SIZE, 1, 1)]
+void main(uint3 group : SV_GroupID, uint3 thread : SV_GroupThreadID)
+{
+    uint base = group.x * SORT_BLOCK_SIZE;
+    uint t = thread.x;
+    Block[t] = SortKeys[base + t];
+    Block[t + SORT_GROUP_SIZE] = SortKeys[base + t + SORT_GROUP_SIZE];
+    GroupMemoryBarrierWithGroupSync();
+
+    uint firstK = K == 0 ? 2 : K;
+    uint lastK = K == 0 ? SORT_BLOCK_SIZE : K;
+    for (uint k = firstK; k <= lastK; k *= 2)
+    {
+        for (uint j = min(k, SORT_BLOCK_SIZE) / 2; j > 0; j /= 2)
+        {
+            uint i = PairFirst(t, j);
+            bool ascending = ((base + i) & k) == 0;
+            uint2 a = Block[i];
+            uint2 b = Block[i + j];
+            if (Greater(a, b) == ascending)
+            {
+                Block[i] = b;
+                Block[i + j] = a;
+            }
+            GroupMemoryBarrierWithGroupSync();
+        }
+    }
+
+    SortKeys[base + t] = Block[t];
+    SortKeys[base + t + SORT_GROUP_SIZE] = Block[t + SORT_GROUP_SIZE];
+}
@@ -0,0 +1,63 @@
+// Same output as PullSpriteBatch.vert, but each SpriteInstance arrives as
+// per-instance vertex attributes and a sprite is a 4-vertex triangle strip.
+struct Input
+{
+    float3 Position : TEXCOORD0;
+    float Rotation : TEXCOORD1;
+    float2 Scale : TEXCOORD2;
+    uint Animation : TEXCOORD3;
+    float AnimationStart : TEXCOORD4;
+    float4 TexRect : TEXCOORD5;
+    float4 Color : TEXCOORD6;
+    uint VertexID : SV_VertexID;
+};
+
+struct Output
+{
+    float2 Texcoord : TEXCOORD0;
+    float4 Color : TEXCOORD1;
+    float4 Position : SV_Position;
+};
+
+// The instance data is not a storage buffer here, so the frame table moves to the first slot
+#define FRAME_TABLE_REGISTER t0
+#include "SpriteFlipbook.hlsli"
+
+cbuffer UniformBlock : register(b0, space1)
+{
+    float4x4 ViewProjectionMatrix : packoffset(c0);
+    float Time : packoffset(c4);
+};
+
+static const float2 vertexPos[4] = {
+    {0.0f, 0.0f},
+    {1.0f, 0.0f},
+    {0.0f, 1.0f},
+    {1.0f, 1.0f}
+};
+
+Output main(Input input)
+{
+    uint vert = input.VertexID % 4;
+
+    float4 texRect = AnimatedTexRect(input.Animation, input.AnimationStart, input.TexRect, Time);
+    float2 texcoord = texRect.xy + vertexPos[vert] * texRect.zw;
+
+    float c = cos(input.Rotation);
+    float s = sin(input.Rotation);
+
+    float2 coord = vertexPos[vert];
+    coord *= input.Scale;
+    float2x2 rotation = {c, s, -s, c};
+    coord = mul(coord, rotation);
+
+    float3 coordWithDepth = float3(coord + input.Position.xy, input.Position.z);
+
+    Output output;
+
+    output.Position = mul(ViewProjectionMatrix, float4(coordWithDepth, 1.0f));
+    output.Texcoord = texcoord;
+    output.Color = input.Color;
+
+    return output;
+}
@@ -0,0 +1,89 @@
+// Bins the point lights into screen tiles, one group per tile. The group's
+// threads test a batch of lights at a time against the tile and append the
+// ones that reach it to the tile's list, which the lit sprite shaders then
+// walk. Lights are appended in index order, so a tile reached by more than
+// MaxPerTile lights keeps the same ones every frame.
+#include "SpriteLighting.hlsli"
+
+// Mirrors LIGHT_CULL_GROUP_SIZE in lighting.h
+#define LIGHT_CULL_GROUP_SIZE 64
+
+StructuredBuffer<PointLight> Lights : register(t0, space0);
+RWStructuredBuffer<uint> TileLights : register(u0, space1);
+
+// Mirrors LightGridUniforms in lighting.h
+cbuffer LightGridBlock : register(b0, space2)
+{
+    uint LightCount : packoffset(c0.x);
+    uint TilesX : packoffset(c0.y);
+    uint TilesY : packoffset(c0.z);
+    uint MaxPerTile : packoffset(c0.w);
+    float3 Ambient : packoffset(c1);
+};
+
+groupshared uint TileCount;
+groupshared uint BatchHits[LIGHT_CULL_GROUP_SIZE / 32];  // a bit per light of the batch that reaches the tile
+
+[numthreads(LIGHT_CULL_GROUP_SIZE, 1, 1)]
+void main(uint3 group : SV_GroupID, uint thread : SV_GroupIndex)
+{
+    uint tile = group.x;
+    if (thread == 0)
+    {
+        TileCount = 0;
+    }
+    if (thread < LIGHT_CULL_GROUP_SIZE / 32)
+    {
+        BatchHits[thread] = 0;
+    }
+
+    float2 tileMin = float2(tile % TilesX, tile / TilesX) * LIGHT_TILE_SIZE;
+    float2 tileMax = tileMin + LIGHT_TILE_SIZE;
+    uint base = tile * (MaxPerTile + 1);
+    for (uint first = 0; first < LightCount; first += LIGHT_CULL_GROUP_SIZE)
+    {
+        GroupMemoryBarrierWithGroupSync();
+
+        // A light reaches the tile if the nearest point of the tile is within its radius
+        uint i = first + thread;
+        bool hit = false;
+        if (i < LightCount)
+        {
+            PointLight light = Lights[i];
+            float2 offset = light.Position - clamp(light.Position, tileMin, tileMax);
+            hit = dot(offset, offset) < light.Radius * light.Radius;
+        }
+        if (hit)
+        {
+            InterlockedOr(BatchHits[thread / 32], 1u << (thread % 32));
+        }
+        GroupMemoryBarrierWithGroupSync();
+
+        // Each light's slot follows the lights before it, in this batch and the ones before
+        uint slot = TileCount + countbits(BatchHits[thread / 32] & ((1u << (thread % 32)) - 1));
+        for (uint word = 0; word < thread / 32; word++)
+        {
+            slot += countbits(BatchHits[word]);
+        }
+        if (hit && slot < MaxPerTile)
+        {
+            TileLights[base + 1 + slot] = i;
+        }
+        GroupMemoryBarrierWithGroupSync();
+
+        if (thread == 0)
+        {
+            for (uint hitWord = 0; hitWord < LIGHT_CULL_GROUP_SIZE / 32; hitWord++)
+            {
+                TileCount += countbits(BatchHits[hitWord]);
+                BatchHits[hitWord] = 0;
+            }
+        }
+    }
+
+    GroupMemoryBarrierWithGroupSync();
+    if (thread == 0)
+    {
+        TileLights[base] = min(TileCount, MaxPerTile);
+    }
+}
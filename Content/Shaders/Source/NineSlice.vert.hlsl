@@ -0,0 +1,56 @@
+struct PanelData
+{
+    float2 Position;
+    float2 Size;
+    float4 Border;      // left, top, right, bottom in pixels
+    float4 TexRect;     // u, v, w, h
+    float4 TexBorder;   // left, top, right, bottom in UV units
+    float4 Color;
+};
+
+struct Output
+{
+    float2 Texcoord : TEXCOORD0;
+    float4 Color : TEXCOORD1;
+    float4 Position : SV_Position;
+};
+
+StructuredBuffer<PanelData> DataBuffer : register(t0, space0);
+
+cbuffer UniformBlock : register(b0, space1)
+{
+    float4x4 ViewProjectionMatrix : packoffset(c0);
+};
+
+static const uint triangleIndices[6] = {0, 1, 2, 3, 2, 1};
+static const uint2 vertexCell[4] = {
+    {0, 0},
+    {1, 0},
+    {0, 1},
+    {1, 1}
+};
+
+// Each panel is 9 quads over a 4x4 grid of vertices
+Output main(uint id : SV_VertexID)
+{
+    uint panelIndex = id / 54;
+    uint quad = (id % 54) / 6;
+    uint2 gridVertex = uint2(quad % 3, quad / 3) + vertexCell[triangleIndices[id % 6]];
+    PanelData panel = DataBuffer[panelIndex];
+
+    // Grid lines along each axis: outer edge, inner border, inner border, outer edge
+    float4 xs = float4(0.0f, panel.Border.x, panel.Size.x - panel.Border.z, panel.Size.x);
+    float4 ys = float4(0.0f, panel.Border.y, panel.Size.y - panel.Border.w, panel.Size.y);
+    float4 us = float4(0.0f, panel.TexBorder.x, panel.TexRect.z - panel.TexBorder.z, panel.TexRect.z);
+    float4 vs = float4(0.0f, panel.TexBorder.y, panel.TexRect.w - panel.TexBorder.w, panel.TexRect.w);
+
+    float2 coord = panel.Position + float2(xs[gridVertex.x], ys[gridVertex.y]);
+
+    Output output;
+
+    output.Position = mul(ViewProjectionMatrix, float4(coord, 0.0f, 1.0f));
+    output.Texcoord = panel.TexRect.xy + float2(us[gridVertex.x], vs[gridVertex.y]);
+    output.Color = panel.Color;
+
+    return output;
+}
@@ -1,9 +1,31 @@
+// Feature switches, set per permutation by compile_sprite_variant in CMakeLists.txt (see sprite_permutations.h).
+// Left undefined this is the general shader, which handles every sprite.
+#ifndef SPRITE_ROTATION
+#define SPRITE_ROTATION 1
+#endif
+#ifndef SPRITE_TINT
+#define SPRITE_TINT 1
+#endif
+#ifndef SPRITE_PACKED
+#define SPRITE_PACKED 0
+#endif
+#ifndef SPRITE_PICKING
+#define SPRITE_PICKING 0
+#endif
+#ifndef SPRITE_SORTED
+#define SPRITE_SORTED 0
+#endif
+#ifndef SPRITE_LIT
+#define SPRITE_LIT 0
+#endif
+
 struct SpriteData
 {
     float3 Position;
     float Rotation;
     float2 Scale;
-    float2 Padding;
+    uint Animation;
+    float AnimationStart;
     float TexU, TexV, TexW, TexH;
     float4 Color;
 };
@@ -11,16 +33,88 @@ struct SpriteData
 struct Output
 {
     float2 Texcoord : TEXCOORD0;
+#if SPRITE_TINT
     float4 Color : TEXCOORD1;
+#endif
+#if SPRITE_PICKING
+    nointerpolation uint PickId : TEXCOORD2;
+#endif
+#if SPRITE_LIT
+    float2 ScenePosition : TEXCOORD3;
+    nointerpolation float2 NormalRotation : TEXCOORD4;  // cos, sin
+#endif
     float4 Position : SV_Position;
 };
 
+#if SPRITE_PACKED
+// Mirrors PackedSpriteInstance in sprite_permutations.h
+struct PackedSpriteData
+{
+    // Not a float2, whose 8-byte alignment pads the stride to 40 bytes under std430 and MSL
+    float PositionX, PositionY;
+    uint DepthRotation;  // half, half
+    uint Scale;          // half, half
+    uint Animation;
+    float AnimationStart;
+    uint TexPosition;    // unorm16, unorm16
+    uint TexSize;        // unorm16, unorm16
+    uint Color;          // unorm8 x4
+};
+
+StructuredBuffer<PackedSpriteData> DataBuffer : register(t0, space0);
+
+float2 UnpackUnorm16x2(uint value)
+{
+    return float2(value & 0xFFFF, value >> 16) / 65535.0f;
+}
+
+SpriteData LoadSprite(uint index)
+{
+    PackedSpriteData packed = DataBuffer[index];
+    SpriteData sprite;
+    sprite.Position = float3(packed.PositionX, packed.PositionY, f16tof32(packed.DepthRotation));
+    sprite.Rotation = f16tof32(packed.DepthRotation >> 16);
+    sprite.Scale = f16tof32(uint2(packed.Scale, packed.Scale >> 16));
+    sprite.Animation = packed.Animation;
+    sprite.AnimationStart = packed.AnimationStart;
+    float2 texPosition = UnpackUnorm16x2(packed.TexPosition);
+    float2 texSize = UnpackUnorm16x2(packed.TexSize);
+    sprite.TexU = texPosition.x;
+    sprite.TexV = texPosition.y;
+    sprite.TexW = texSize.x;
+    sprite.TexH = texSize.y;
+    sprite.Color = float4(packed.Color & 0xFF, (packed.Color >> 8) & 0xFF, (packed.Color >> 16) & 0xFF, packed.Color >> 24) / 255.0f;
+    return sprite;
+}
+#else
 StructuredBuffer<SpriteData> DataBuffer : register(t0, space0);
 
+SpriteData LoadSprite(uint index)
+{
+    return DataBuffer[index];
+}
+#endif
+
+#include "SpriteFlipbook.hlsli"
+
+#if SPRITE_SORTED
+// Depth keys and sprite indices in drawing order, see gpu_sort.h
+StructuredBuffer<uint2> SortKeys : register(t2, space0);
+#endif
+
 cbuffer UniformBlock : register(b0, space1)
 {
     float4x4 ViewProjectionMatrix : packoffset(c0);
+    float Time : packoffset(c4);
+};
+
+#if SPRITE_PICKING
+// Mirrors SpritePickUniforms in sprite_picking.h
+cbuffer PickBlock : register(b1, space1)
+{
+    uint PickBase : packoffset(c0);
 };
+#endif
 
 static const uint triangleIndices[6] = {0, 1, 2, 3, 2, 1};
 static const float2 vertexPos[4] = {
@@ -33,23 +127,36 @@ static const float2 vertexPos[4] = {
 Output main(uint id : SV_VertexID)
 {
     uint spriteIndex = id / 6;
+#if SPRITE_SORTED
+    spriteIndex = SortKeys[spriteIndex].y;
+#endif
     uint vert = triangleIndices[id % 6];
-    SpriteData sprite = DataBuffer[spriteIndex];
+    SpriteData sprite = LoadSprite(spriteIndex);
 
+    float4 texRect = AnimatedTexRect(
+        sprite.Animation,
+        sprite.AnimationStart,
+        float4(sprite.TexU, sprite.TexV, sprite.TexW, sprite.TexH),
+        Time
+    );
     float2 texcoord[4] = {
-        {sprite.TexU,               sprite.TexV              },
-        {sprite.TexU + sprite.TexW, sprite.TexV              },
-        {sprite.TexU,               sprite.TexV + sprite.TexH},
-        {sprite.TexU + sprite.TexW, sprite.TexV + sprite.TexH}
+        {texRect.x,             texRect.y            },
+        {texRect.x + texRect.z, texRect.y            },
+        {texRect.x,             texRect.y + texRect.w},
+        {texRect.x + texRect.z, texRect.y + texRect.w}
     };
 
-    float c = cos(sprite.Rotation);
-    float s = sin(sprite.Rotation);
-
     float2 coord = vertexPos[vert];
     coord *= sprite.Scale;
+#if SPRITE_ROTATION
+    float c = cos(sprite.Rotation);
+    float s = sin(sprite.Rotation);
     float2x2 rotation = {c, s, -s, c};
     coord = mul(coord, rotation);
+#else
+    float c = 1.0f;
+    float s = 0.0f;
+#endif
 
     float3 coordWithDepth = float3(coord + sprite.Position.xy, sprite.Position.z);
 
@@ -57,7 +164,17 @@ Output main(uint id : SV_VertexID)
 
     output.Position = mul(ViewProjectionMatrix, float4(coordWithDepth, 1.0f));
     output.Texcoord = texcoord[vert];
+#if SPRITE_TINT
     output.Color = sprite.Color;
+#endif
+#if SPRITE_PICKING
+    output.PickId = PickBase + spriteIndex;
+#endif
+#if SPRITE_LIT
+    // Lights are placed in the same coordinates the sprites are
+    output.ScenePosition = coordWithDepth.xy;
+    output.NormalRotation = float2(c, s);
+#endif
 
     return output;
 }
@@ -0,0 +1,47 @@
+// Flipbook frame selection shared by the sprite vertex shaders
+
+// Animation headers followed by frame UV rects, see flipbook.h for the layout.
+// Define FRAME_TABLE_REGISTER before including to move it off t1.
+#ifndef FRAME_TABLE_REGISTER
+#define FRAME_TABLE_REGISTER t1
+#endif
+StructuredBuffer<float4> FrameTable : register(FRAME_TABLE_REGISTER, space0);
+
+// Keep in sync with FlipbookLoopMode in flipbook.h
+static const uint LOOP_REPEAT = 0;
+static const uint LOOP_ONCE = 1;
+static const uint LOOP_PINGPONG = 2;
+
+// Returns the UV rect to sample at `time` for a sprite's packed animation word,
+// or its own rect if it isn't animated.
+float4 AnimatedTexRect(uint packedAnimation, float animationStart, float4 texRect, float time)
+{
+    uint animation = packedAnimation & 0xFFFF;
+    if (animation == 0)
+    {
+        return texRect;
+    }
+
+    uint loopMode = (packedAnimation >> 16) & 0xFF;
+    float fps = (float)(packedAnimation >> 24);
+    uint2 header = asuint(FrameTable[animation - 1].xy);
+    uint frameCount = header.y;
+
+    uint frame = (uint)floor(max(time - animationStart, 0.0f) * fps);
+    if (loopMode == LOOP_ONCE)
+    {
+        frame = min(frame, frameCount - 1);
+    }
+    else if (loopMode == LOOP_PINGPONG && frameCount > 1)
+    {
+        uint period = frameCount * 2 - 2;
+        frame = frame % period;
+        frame = frame < frameCount ? frame : period - frame;
+    }
+    else
+    {
+        frame = frame % frameCount;
+    }
+
+    return FrameTable[header.x + frame];
+}
@@ -0,0 +1,22 @@
+// Shared by the light culling pass and the lit sprite shaders, see lighting.h
+
+// Mirrors LIGHT_TILE_SIZE in lighting.h. Each tile's list is its light count
+// followed by up to MaxPerTile light indices, from LightGridBlock.
+#define LIGHT_TILE_SIZE 32
+
+// Mirrors PointLight in lighting.h
+struct PointLight
+{
+    float2 Position;
+    float Height;     // above the sprites, which lights them from the side
+    float Radius;     // no light at all beyond this
+    float3 Color;
+    float Intensity;
+};
+
+// How much a light adds at a distance, smoothly reaching zero at its radius
+float LightFalloff(PointLight light, float distance)
+{
+    float falloff = saturate(1.0f - distance / light.Radius);
+    return falloff * falloff;
+}
@@ -0,0 +1,29 @@
+// Shared by the depth sort compute shaders, see gpu_sort.h
+
+// Mirrors GPU_SORT_GROUP_SIZE in gpu_sort.h. Each group sorts a block of two elements per thread.
+#define SORT_GROUP_SIZE 128
+#define SORT_BLOCK_SIZE (SORT_GROUP_SIZE * 2)
+
+// A sprite's depth key and its index in the layer
+RWStructuredBuffer<uint2> SortKeys : register(u0, space1);
+
+// Mirrors GpuSortUniforms in gpu_sort.h
+cbuffer SortBlock : register(b0, space2)
+{
+    uint Count : packoffset(c0.x);
+    uint PaddedCount : packoffset(c0.y);
+    uint K : packoffset(c0.z);  // size of the bitonic sequences being merged
+    uint J : packoffset(c0.w);  // distance between the elements compared
+};
+
+// Ties on depth go by index, so the order is the same every frame
+bool Greater(uint2 a, uint2 b)
+{
+    return a.x > b.x || (a.x == b.x && a.y > b.y);
+}
+
+// The position of the first element of compare-exchange `t` at distance j, a power of two
+uint PairFirst(uint t, uint j)
+{
+    return ((t & ~(j - 1)) << 1) | (t & (j - 1));
+}
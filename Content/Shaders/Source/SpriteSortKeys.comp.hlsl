@@ -0,0 +1,38 @@
+// Fills the sort buffer with one key per sprite, farthest first, and pads it
+// to a power of two with keys that sort after every sprite
+#include "SpriteSort.hlsli"
+
+// Mirrors SpriteInstance in sprite_layer.h, only the depth is read
+struct SpriteData
+{
+    float3 Position;
+    float Rotation;
+    float2 Scale;
+    uint Animation;
+    float AnimationStart;
+    float TexU, TexV, TexW, TexH;
+    float4 Color;
+};
+
+StructuredBuffer<SpriteData> Sprites : register(t0, space0);
+
+[numthreads(SORT_GROUP_SIZE, 1, 1)]
+void main(uint3 id : SV_DispatchThreadID)
+{
+    uint index = id.x;
+    if (index >= PaddedCount)
+    {
+        return;
+    }
+    if (index >= Count)
+    {
+        SortKeys[index] = uint2(0xFFFFFFFF, 0xFFFFFFFF);
+        return;
+    }
+
+    // Flipping the sign bit, or every bit of negatives, makes floats order as uints.
+    // Inverting that puts larger depths, the farther ones, first.
+    uint depth = asuint(Sprites[index].Position.z);
+    uint ordered = depth ^ ((depth >> 31) != 0 ? 0xFFFFFFFF : 0x80000000);
+    SortKeys[index] = uint2(~ordered, index);
+}
@@ -1,13 +1,144 @@
+// Feature switches, set per permutation by compile_sprite_variant in CMakeLists.txt (see sprite_permutations.h).
+// Left undefined this is the general shader, also used by the tilemap and panels.
+#ifndef SPRITE_TINT
+#define SPRITE_TINT 1
+#endif
+#ifndef SPRITE_ALPHA_TEST
+#define SPRITE_ALPHA_TEST 0
+#endif
+#ifndef SPRITE_VIRTUAL_TEXTURE
+#define SPRITE_VIRTUAL_TEXTURE 0
+#endif
+#ifndef SPRITE_PICKING
+#define SPRITE_PICKING 0
+#endif
+#ifndef SPRITE_LIT
+#define SPRITE_LIT 0
+#endif
+#ifndef SPRITE_SDF
+#define SPRITE_SDF 0
+#endif
+
+#if SPRITE_VIRTUAL_TEXTURE
+// One texel per virtual page, holding the page's position in the physical
+// cache. Pages that aren't loaded point at a placeholder page. See virtual_texture.h
+Texture2D<float4> PageTable : register(t0, space2);
+SamplerState PageTableSampler : register(s0, space2);
+Texture2D<float4> Texture : register(t1, space2);
+SamplerState Sampler : register(s1, space2);
+
+cbuffer VirtualTextureBlock : register(b0, space3)
+{
+    float2 VirtualPages : packoffset(c0.x);
+    float2 CachePages : packoffset(c0.z);
+};
+
+float2 VirtualToPhysical(float2 uv)
+{
+    float2 physicalPage = round(PageTable.SampleLevel(PageTableSampler, uv, 0).xy * 255.0f);
+    return (physicalPage + frac(uv * VirtualPages)) / CachePages;
+}
+#else
 Texture2D<float4> Texture : register(t0, space2);
 SamplerState Sampler : register(s0, space2);
+#endif
+
+#if SPRITE_LIT
+// Lit sprites only ever come from the atlas, never a virtual texture, so the
+// normal map and the tile lists come right after it. See lighting.h
+#include "SpriteLighting.hlsli"
+
+Texture2D<float4> NormalMap : register(t1, space2);
+SamplerState NormalSampler : register(s1, space2);
+StructuredBuffer<PointLight> Lights : register(t2, space2);
+StructuredBuffer<uint> TileLights : register(t3, space2);
+
+// Mirrors LightGridUniforms in lighting.h
+cbuffer LightGridBlock : register(b0, space3)
+{
+    uint LightCount : packoffset(c0.x);
+    uint TilesX : packoffset(c0.y);
+    uint TilesY : packoffset(c0.z);
+    uint MaxPerTile : packoffset(c0.w);
+    float3 Ambient : packoffset(c1);
+};
+
+// Sums the lights binned into this position's tile, a handful however many there are in total
+float3 ShadeTile(float2 position, float3 normal)
+{
+    uint2 tile = min(uint2(max(position, 0.0f)) / LIGHT_TILE_SIZE, uint2(TilesX - 1, TilesY - 1));
+    uint base = (tile.y * TilesX + tile.x) * (MaxPerTile + 1);
+    uint count = TileLights[base];
+
+    float3 light = Ambient;
+    for (uint i = 0; i < count; i += 1)
+    {
+        PointLight pointLight = Lights[TileLights[base + 1 + i]];
+        float3 toLight = float3(pointLight.Position - position, pointLight.Height);
+        float falloff = LightFalloff(pointLight, length(toLight.xy));
+        light += pointLight.Color * pointLight.Intensity * falloff * saturate(dot(normal, normalize(toLight)));
+    }
+    return light;
+}
+#endif
+
+static const float ALPHA_TEST_THRESHOLD = 0.5f;
+// Where the outline is in a distance field texture, see sdf_font.h
+static const float SDF_EDGE = 0.5f;
 
 struct Input
 {
     float2 TexCoord : TEXCOORD0;
+#if SPRITE_TINT
     float4 Color : TEXCOORD1;
+#endif
+#if SPRITE_PICKING
+    nointerpolation uint PickId : TEXCOORD2;
+#endif
+#if SPRITE_LIT
+    float2 ScenePosition : TEXCOORD3;
+    nointerpolation float2 NormalRotation : TEXCOORD4;  // cos, sin
+#endif
 };
 
+// Picking variants write the sprite's id to an R32_UINT target instead of a color
+#if SPRITE_PICKING
+uint main(Input input) : SV_Target0
+#else
 float4 main(Input input) : SV_Target0
+#endif
 {
-    return input.Color * Texture.Sample(Sampler, input.TexCoord);
+#if SPRITE_VIRTUAL_TEXTURE
+    // No mips in the cache, so sampling at level 0 keeps page seams free of derivative jumps
+    float4 color = Texture.SampleLevel(Sampler, VirtualToPhysical(input.TexCoord), 0);
+#else
+    float4 color = Texture.Sample(Sampler, input.TexCoord);
+#endif
+#if SPRITE_SDF
+    // Alpha holds the distance to the outline. Blending across about one screen
+    // pixel's worth of distance keeps the edge sharp and smooth at any scale.
+    float smoothing = max(fwidth(color.a) * 0.75f, 1e-4f);
+    color.a = smoothstep(SDF_EDGE - smoothing, SDF_EDGE + smoothing, color.a);
+#endif
+#if SPRITE_TINT
+    color *= input.Color;
+#endif
+#if SPRITE_ALPHA_TEST
+    clip(color.a - ALPHA_TEST_THRESHOLD);
+#endif
+#if SPRITE_LIT
+    // The normal map faces the same way as the atlas, so it turns with the sprite
+    float3 normal = NormalMap.Sample(NormalSampler, input.TexCoord).xyz * 2.0f - 1.0f;
+    float c = input.NormalRotation.x;
+    float s = input.NormalRotation.y;
+    normal.xy = float2(normal.x * c - normal.y * s, normal.x * s + normal.y * c);
+    color.rgb *= ShadeTile(input.ScenePosition, normalize(normal));
+#endif
+#if SPRITE_PICKING
+    // Clicks go through transparent texels whether or not the sprite is alpha tested
+    clip(color.a - ALPHA_TEST_THRESHOLD);
+    return input.PickId;
+#else
+    return color;
+#endif
 }
@@ -0,0 +1,61 @@
+struct Output
+{
+    float2 Texcoord : TEXCOORD0;
+    float4 Color : TEXCOORD1;
+    float4 Position : SV_Position;
+};
+
+// 16-bit atlas indices, two per uint, chunk-major. See tilemap.h for the layout.
+StructuredBuffer<uint> TileBuffer : register(t0, space0);
+
+cbuffer UniformBlock : register(b0, space1)
+{
+    float4x4 ViewProjectionMatrix : packoffset(c0);
+    float2 ChunkOrigin : packoffset(c4);
+    float2 TileSize : packoffset(c4.z);
+    uint ChunkOffset : packoffset(c5);
+    uint AtlasColumns : packoffset(c5.y);
+    float2 AtlasCellSize : packoffset(c5.z);
+};
+
+// Keep in sync with TILEMAP_CHUNK_SIZE and TILEMAP_EMPTY_TILE in tilemap.h
+static const uint CHUNK_SIZE = 32;
+static const uint EMPTY_TILE = 0xFFFF;
+
+static const uint triangleIndices[6] = {0, 1, 2, 3, 2, 1};
+static const float2 vertexPos[4] = {
+    {0.0f, 0.0f},
+    {1.0f, 0.0f},
+    {0.0f, 1.0f},
+    {1.0f, 1.0f}
+};
+
+Output main(uint id : SV_VertexID)
+{
+    uint tileIndex = id / 6;
+    uint vert = triangleIndices[id % 6];
+
+    uint packed = TileBuffer[ChunkOffset + tileIndex / 2];
+    uint atlasIndex = (tileIndex & 1) ? (packed >> 16) : (packed & 0xFFFF);
+
+    Output output;
+    output.Color = float4(1.0f, 1.0f, 1.0f, 1.0f);
+
+    if (atlasIndex == EMPTY_TILE)
+    {
+        // Collapse every vertex of an empty tile onto one point so it rasterizes nothing
+        output.Position = float4(0.0f, 0.0f, 0.0f, 1.0f);
+        output.Texcoord = float2(0.0f, 0.0f);
+        return output;
+    }
+
+    float2 tile = float2(tileIndex % CHUNK_SIZE, tileIndex / CHUNK_SIZE);
+    float2 coord = ChunkOrigin + (tile + vertexPos[vert]) * TileSize;
+
+    float2 cell = float2(atlasIndex % AtlasColumns, atlasIndex / AtlasColumns);
+
+    output.Position = mul(ViewProjectionMatrix, float4(coord, 0.0f, 1.0f));
+    output.Texcoord = (cell + vertexPos[vert]) * AtlasCellSize;
+
+    return output;
+}
@@ -0,0 +1,17 @@
+Texture2D<float4> Texture : register(t0, space2);
+SamplerState Sampler : register(s0, space2);
+
+cbuffer UniformBlock : register(b0, space3)
+{
+    float2 RegionScale : packoffset(c0.x);  // the rendered region's size over the texture's
+    float2 RegionMax : packoffset(c0.z);    // the center of the region's last texel
+};
+
+// Linear filtering reaches half a texel past the far edges of the region, into
+// texels that weren't rendered this frame. Stopping at the centers of the last
+// texels repeats the edge instead, as sampling a texture of the region's exact
+// size would.
+float4 main(float2 Texcoord : TEXCOORD0) : SV_Target0
+{
+    return Texture.Sample(Sampler, min(Texcoord * RegionScale, RegionMax));
+}
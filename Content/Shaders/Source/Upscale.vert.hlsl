@@ -0,0 +1,18 @@
+struct Output
+{
+    float2 Texcoord : TEXCOORD0;
+    float4 Position : SV_Position;
+};
+
+// One triangle covering the whole target, its texture coordinates 0 to 1 across the screen
+Output main(uint id : SV_VertexID)
+{
+    float2 corner = float2((id << 1) & 2, id & 2);
+
+    Output output;
+
+    output.Position = float4(corner.x * 2.0f - 1.0f, 1.0f - corner.y * 2.0f, 0.0f, 1.0f);
+    output.Texcoord = corner;
+
+    return output;
+}
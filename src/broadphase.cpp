@@ -0,0 +1,336 @@
+#include "broadphase.h"
+#include "trace.h"
+#include <SDL3/SDL_intrin.h>
+#include <algorithm>
+#include <cfloat>
+
+// The insertion sort gives up and sorts from scratch after this many moves
+// per sprite, e.g. when sprites were teleported rather than moved
+static const Uint32 INSERTION_SORT_MAX_MOVES = 8;
+// Sweeps load four sprites at a time, which can reach four past the last one
+static const Uint32 SWEEP_PADDING = 4;
+
+static void RunChunks(Broadphase* broadphase)
+{
+	Trace_Begin("broadphase job");
+	for (;;)
+	{
+		const Uint32 chunk = (Uint32)SDL_AddAtomicInt(&broadphase->nextChunk, 1);
+		if (chunk >= broadphase->chunkCount)
+		{
+			break;
+		}
+		broadphase->job(broadphase, chunk);
+	}
+	Trace_End();
+}
+
+static int WorkerThread(void* data)
+{
+	BroadphaseWorker* worker = (BroadphaseWorker*)data;
+	Broadphase* broadphase = worker->broadphase;
+	Trace_SetThreadName("broadphase worker");
+	for (;;)
+	{
+		SDL_WaitSemaphore(worker->start);
+		if (broadphase->quit)
+		{
+			return 0;
+		}
+		RunChunks(broadphase);
+		SDL_SignalSemaphore(broadphase->done);
+	}
+}
+
+// Runs the job on every chunk, with as many workers as there are chunks to
+// share, and returns once all chunks are done
+static void RunJob(Broadphase* broadphase, BroadphaseJob job, Uint32 chunkCount)
+{
+	broadphase->job = job;
+	broadphase->chunkCount = chunkCount;
+	SDL_SetAtomicInt(&broadphase->nextChunk, 0);
+
+	const Uint32 helpers = chunkCount > 1 ? SDL_min(broadphase->workerCount, chunkCount - 1) : 0;
+	for (Uint32 i = 0; i < helpers; i += 1)
+	{
+		SDL_SignalSemaphore(broadphase->workers[i].start);
+	}
+	RunChunks(broadphase);
+	Trace_Begin("broadphase barrier");
+	for (Uint32 i = 0; i < helpers; i += 1)
+	{
+		SDL_WaitSemaphore(broadphase->done);
+	}
+	Trace_End();
+}
+
+bool Broadphase_Init(Broadphase* broadphase, Uint32 threadCount)
+{
+	if (threadCount == 0)
+	{
+		threadCount = (Uint32)SDL_max(SDL_GetNumLogicalCPUCores(), 1);
+	}
+	threadCount = SDL_min(threadCount, (Uint32)BROADPHASE_MAX_THREADS);
+
+	broadphase->count = 0;
+	broadphase->sprites = NULL;
+	broadphase->workerCount = 0;
+	broadphase->quit = false;
+	broadphase->done = SDL_CreateSemaphore(0);
+	if (broadphase->done == NULL)
+	{
+		SDL_Log("Failed to create broadphase semaphore: %s", SDL_GetError());
+		return false;
+	}
+
+	// The calling thread works too, so it needs one worker less
+	for (Uint32 i = 0; i + 1 < threadCount; i += 1)
+	{
+		BroadphaseWorker* worker = &broadphase->workers[i];
+		worker->broadphase = broadphase;
+		worker->start = SDL_CreateSemaphore(0);
+		worker->thread = worker->start != NULL ? SDL_CreateThread(WorkerThread, "broadphase", worker) : NULL;
+		if (worker->thread == NULL)
+		{
+			SDL_Log("Failed to start broadphase worker: %s", SDL_GetError());
+			SDL_DestroySemaphore(worker->start);
+			// Stops the workers already started
+			Broadphase_Release(broadphase);
+			return false;
+		}
+		broadphase->workerCount += 1;
+	}
+	return true;
+}
+
+void Broadphase_Release(Broadphase* broadphase)
+{
+	broadphase->quit = true;
+	for (Uint32 i = 0; i < broadphase->workerCount; i += 1)
+	{
+		SDL_SignalSemaphore(broadphase->workers[i].start);
+		SDL_WaitThread(broadphase->workers[i].thread, NULL);
+		SDL_DestroySemaphore(broadphase->workers[i].start);
+	}
+	broadphase->workerCount = 0;
+	SDL_DestroySemaphore(broadphase->done);
+	broadphase->done = NULL;
+
+	broadphase->minX.clear();
+	broadphase->maxX.clear();
+	broadphase->minY.clear();
+	broadphase->maxY.clear();
+	broadphase->order.clear();
+	broadphase->sortedMinX.clear();
+	broadphase->sortedMaxX.clear();
+	broadphase->sortedMinY.clear();
+	broadphase->sortedMaxY.clear();
+	broadphase->chunkPairs.clear();
+	broadphase->pairs.clear();
+}
+
+static void ComputeBoundsChunk(Broadphase* broadphase, Uint32 chunk)
+{
+	const Uint32 first = chunk * BROADPHASE_CHUNK_SIZE;
+	const Uint32 last = SDL_min(first + BROADPHASE_CHUNK_SIZE, broadphase->count);
+	for (Uint32 i = first; i < last; i += 1)
+	{
+		// The quad's edges as the vertex shader rotates them around (x, y).
+		// Each axis of the bounds is the corner plus the negative or positive parts of both edges.
+		const SpriteInstance* sprite = &broadphase->sprites[i];
+		const float c = SDL_cosf(sprite->rotation);
+		const float s = SDL_sinf(sprite->rotation);
+		const float widthX = sprite->w * c;
+		const float widthY = sprite->w * s;
+		const float heightX = -sprite->h * s;
+		const float heightY = sprite->h * c;
+		broadphase->minX[i] = sprite->x + SDL_min(widthX, 0.0f) + SDL_min(heightX, 0.0f);
+		broadphase->maxX[i] = sprite->x + SDL_max(widthX, 0.0f) + SDL_max(heightX, 0.0f);
+		broadphase->minY[i] = sprite->y + SDL_min(widthY, 0.0f) + SDL_min(heightY, 0.0f);
+		broadphase->maxY[i] = sprite->y + SDL_max(widthY, 0.0f) + SDL_max(heightY, 0.0f);
+	}
+}
+
+// Brings last update's order up to date. Sprites that moved a little only
+// move a few places, which insertion sort handles in close to linear time.
+static void SortByLeftEdge(Broadphase* broadphase)
+{
+	std::vector<Uint32>& order = broadphase->order;
+	const float* minX = broadphase->minX.data();
+	const Uint32 count = broadphase->count;
+
+	// Added sprites start at the end, removed ones drop out
+	if (order.size() > count)
+	{
+		order.erase(std::remove_if(order.begin(), order.end(), [count](Uint32 index) { return index >= count; }), order.end());
+	}
+	for (Uint32 index = (Uint32)order.size(); index < count; index += 1)
+	{
+		order.push_back(index);
+	}
+
+	const Uint64 maxMoves = (Uint64)count * INSERTION_SORT_MAX_MOVES;
+	Uint64 moves = 0;
+	for (Uint32 i = 1; i < count; i += 1)
+	{
+		const Uint32 index = order[i];
+		const float key = minX[index];
+		Uint32 j = i;
+		while (j > 0 && minX[order[j - 1]] > key)
+		{
+			order[j] = order[j - 1];
+			j -= 1;
+		}
+		order[j] = index;
+
+		moves += i - j;
+		if (moves > maxMoves)
+		{
+			std::sort(order.begin(), order.end(), [minX](Uint32 a, Uint32 b) { return minX[a] < minX[b]; });
+			return;
+		}
+	}
+}
+
+// Copies the bounds into sorted order, so the sweep reads them front to back
+static void GatherChunk(Broadphase* broadphase, Uint32 chunk)
+{
+	const Uint32 first = chunk * BROADPHASE_CHUNK_SIZE;
+	const Uint32 last = SDL_min(first + BROADPHASE_CHUNK_SIZE, broadphase->count);
+	for (Uint32 k = first; k < last; k += 1)
+	{
+		const Uint32 index = broadphase->order[k];
+		broadphase->sortedMinX[k] = broadphase->minX[index];
+		broadphase->sortedMaxX[k] = broadphase->maxX[index];
+		broadphase->sortedMinY[k] = broadphase->minY[index];
+		broadphase->sortedMaxY[k] = broadphase->maxY[index];
+	}
+}
+
+static void AddPair(std::vector<BroadphasePair>& pairs, Uint32 a, Uint32 b)
+{
+	pairs.push_back(a < b ? BroadphasePair{ a, b } : BroadphasePair{ b, a });
+}
+
+#if defined(SDL_NEON_INTRINSICS) && defined(__aarch64__)
+// One bit per lane, like _mm_movemask_ps
+static int MoveMask(uint32x4_t mask)
+{
+	static const uint32x4_t bits = { 1, 2, 4, 8 };
+	return (int)vaddvq_u32(vandq_u32(mask, bits));
+}
+#endif
+
+static void SweepChunk(Broadphase* broadphase, Uint32 chunk)
+{
+	std::vector<BroadphasePair>& pairs = broadphase->chunkPairs[chunk];
+	pairs.clear();
+
+	const Uint32* order = broadphase->order.data();
+	const float* sortedMinX = broadphase->sortedMinX.data();
+	const float* sortedMaxX = broadphase->sortedMaxX.data();
+	const float* sortedMinY = broadphase->sortedMinY.data();
+	const float* sortedMaxY = broadphase->sortedMaxY.data();
+	const Uint32 first = chunk * BROADPHASE_CHUNK_SIZE;
+	const Uint32 last = SDL_min(first + BROADPHASE_CHUNK_SIZE, broadphase->count);
+	for (Uint32 i = first; i < last; i += 1)
+	{
+		// Everything from i + 1 on starts at or after sprite i along x, so
+		// candidates run until the first one that starts past its right edge
+#if defined(SDL_SSE_INTRINSICS)
+		const __m128 maxX = _mm_set1_ps(sortedMaxX[i]);
+		const __m128 minY = _mm_set1_ps(sortedMinY[i]);
+		const __m128 maxY = _mm_set1_ps(sortedMaxY[i]);
+		for (Uint32 j = i + 1; ; j += 4)
+		{
+			const __m128 startsBefore = _mm_cmple_ps(_mm_loadu_ps(&sortedMinX[j]), maxX);
+			const __m128 overlapsY = _mm_and_ps(
+				_mm_cmple_ps(_mm_loadu_ps(&sortedMinY[j]), maxY),
+				_mm_cmpge_ps(_mm_loadu_ps(&sortedMaxY[j]), minY)
+			);
+			const int startsBeforeMask = _mm_movemask_ps(startsBefore);
+			const int overlapMask = _mm_movemask_ps(_mm_and_ps(startsBefore, overlapsY));
+#elif defined(SDL_NEON_INTRINSICS) && defined(__aarch64__)
+		const float32x4_t maxX = vdupq_n_f32(sortedMaxX[i]);
+		const float32x4_t minY = vdupq_n_f32(sortedMinY[i]);
+		const float32x4_t maxY = vdupq_n_f32(sortedMaxY[i]);
+		for (Uint32 j = i + 1; ; j += 4)
+		{
+			const uint32x4_t startsBefore = vcleq_f32(vld1q_f32(&sortedMinX[j]), maxX);
+			const uint32x4_t overlapsY = vandq_u32(
+				vcleq_f32(vld1q_f32(&sortedMinY[j]), maxY),
+				vcgeq_f32(vld1q_f32(&sortedMaxY[j]), minY)
+			);
+			const int startsBeforeMask = MoveMask(startsBefore);
+			const int overlapMask = MoveMask(vandq_u32(startsBefore, overlapsY));
+#else
+		for (Uint32 j = i + 1; ; j += 4)
+		{
+			int startsBeforeMask = 0;
+			int overlapMask = 0;
+			for (Uint32 lane = 0; lane < 4; lane += 1)
+			{
+				const bool startsBefore = sortedMinX[j + lane] <= sortedMaxX[i];
+				const bool overlapsY = sortedMinY[j + lane] <= sortedMaxY[i] && sortedMaxY[j + lane] >= sortedMinY[i];
+				startsBeforeMask |= startsBefore << lane;
+				overlapMask |= (startsBefore && overlapsY) << lane;
+			}
+#endif
+			// Most candidates miss along y, skip the lanes when all four do
+			for (int mask = overlapMask; mask != 0; mask &= mask - 1)
+			{
+				AddPair(pairs, order[i], order[j + SDL_MostSignificantBitIndex32((Uint32)(mask & -mask))]);
+			}
+			// The padding never starts before anything, so this ends the sweep at the last sprite
+			if (startsBeforeMask != 0xF)
+			{
+				break;
+			}
+		}
+	}
+}
+
+Uint32 Broadphase_Update(Broadphase* broadphase, const SpriteInstance* sprites, Uint32 count)
+{
+	broadphase->sprites = sprites;
+	broadphase->count = count;
+	const Uint32 chunkCount = (count + BROADPHASE_CHUNK_SIZE - 1) / BROADPHASE_CHUNK_SIZE;
+
+	broadphase->minX.resize(count);
+	broadphase->maxX.resize(count);
+	broadphase->minY.resize(count);
+	broadphase->maxY.resize(count);
+	RunJob(broadphase, ComputeBoundsChunk, chunkCount);
+
+	Trace_Begin("broadphase sort");
+	SortByLeftEdge(broadphase);
+	Trace_End();
+
+	broadphase->sortedMinX.resize(count + SWEEP_PADDING);
+	broadphase->sortedMaxX.resize(count + SWEEP_PADDING);
+	broadphase->sortedMinY.resize(count + SWEEP_PADDING);
+	broadphase->sortedMaxY.resize(count + SWEEP_PADDING);
+	for (Uint32 k = count; k < count + SWEEP_PADDING; k += 1)
+	{
+		broadphase->sortedMinX[k] = FLT_MAX;
+		broadphase->sortedMaxX[k] = -FLT_MAX;
+		broadphase->sortedMinY[k] = FLT_MAX;
+		broadphase->sortedMaxY[k] = -FLT_MAX;
+	}
+	RunJob(broadphase, GatherChunk, chunkCount);
+
+	if (broadphase->chunkPairs.size() < chunkCount)
+	{
+		broadphase->chunkPairs.resize(chunkCount);
+	}
+	RunJob(broadphase, SweepChunk, chunkCount);
+
+	// Chunks keep their pairs in sweep order, so the result doesn't depend on thread timing
+	broadphase->pairs.clear();
+	for (Uint32 chunk = 0; chunk < chunkCount; chunk += 1)
+	{
+		broadphase->pairs.insert(broadphase->pairs.end(), broadphase->chunkPairs[chunk].begin(), broadphase->chunkPairs[chunk].end());
+	}
+	broadphase->sprites = NULL;
+	return (Uint32)broadphase->pairs.size();
+}
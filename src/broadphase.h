@@ -0,0 +1,69 @@
+#pragma once
+#ifndef SDL_SAMPLE_BROADPHASE_H
+#define SDL_SAMPLE_BROADPHASE_H
+
+#include <SDL3/SDL.h>
+#include <vector>
+#include "sprite_layer.h"
+
+// Sprites per job. Each worker takes the next chunk until none are left.
+#define BROADPHASE_CHUNK_SIZE 1024
+#define BROADPHASE_MAX_THREADS 16
+
+// Two sprites whose bounds overlap, by index, with a < b
+typedef struct BroadphasePair
+{
+	Uint32 a, b;
+} BroadphasePair;
+
+typedef struct Broadphase Broadphase;
+typedef void (*BroadphaseJob)(Broadphase* broadphase, Uint32 chunk);
+
+typedef struct BroadphaseWorker
+{
+	Broadphase* broadphase;
+	SDL_Thread* thread;
+	SDL_Semaphore* start;
+} BroadphaseWorker;
+
+// Sweep and prune over the axis-aligned bounds of sprites, rotation included,
+// for games that collide sprites as they are drawn.
+//
+// Sprites are kept sorted by their left edge from one update to the next, so
+// while they move a little per frame the sort is an insertion sort over an
+// almost sorted list. Each sprite is then swept against the ones that start
+// before its right edge, four at a time with SIMD compares. Computing bounds
+// and sweeping are split into chunks and spread over worker threads.
+typedef struct Broadphase
+{
+	Uint32 count;
+	// Bounds by sprite index
+	std::vector<float> minX, maxX, minY, maxY;
+	// Sprite indices by left edge, and the bounds in that order, padded to a
+	// multiple of 4 with bounds nothing overlaps
+	std::vector<Uint32> order;
+	std::vector<float> sortedMinX, sortedMaxX, sortedMinY, sortedMaxY;
+	std::vector<std::vector<BroadphasePair>> chunkPairs;
+	std::vector<BroadphasePair> pairs;
+	const SpriteInstance* sprites;
+
+	Uint32 workerCount;
+	BroadphaseWorker workers[BROADPHASE_MAX_THREADS];
+	SDL_Semaphore* done;
+	SDL_AtomicInt nextChunk;
+	BroadphaseJob job;
+	Uint32 chunkCount;
+	bool quit;
+} Broadphase;
+
+// threadCount includes the calling thread, 0 picks one per logical core.
+bool Broadphase_Init(Broadphase* broadphase, Uint32 threadCount);
+void Broadphase_Release(Broadphase* broadphase);
+
+// Finds every pair of sprites whose rotated quads' bounds overlap, into
+// broadphase->pairs. Sprites should keep their indices from one update to the
+// next, that's what makes the sort cheap.
+// Returns the number of pairs.
+Uint32 Broadphase_Update(Broadphase* broadphase, const SpriteInstance* sprites, Uint32 count);
+
+#endif
@@ -1,4 +1,6 @@
 #include "common.h"
+#include "image_loader.h"
+#include "cooked_texture.h"
 
 SDL_GPUShader* LoadShader(
 	const char* BasePath,
@@ -84,39 +86,105 @@ SDL_GPUShader* LoadShader(
 	return shader;
 }
 
-SDL_Surface* LoadImage(const char* basePath, const char* imageFilename, int desiredChannels)
-{
+SDL_GPUShader* LoadShaderVariant(
+	const char* BasePath,
+	SDL_GPUDevice* device,
+	const char* shaderFilename,
+	Uint32 variant,
+	Uint32 samplerCount,
+	Uint32 uniformBufferCount,
+	Uint32 storageBufferCount,
+	Uint32 storageTextureCount
+) {
+	const char* stage = SDL_strchr(shaderFilename, '.');
+	if (stage == NULL)
+	{
+		SDL_Log("Shader name %s has no stage!", shaderFilename);
+		return NULL;
+	}
+
+	char variantFilename[128];
+	SDL_snprintf(variantFilename, sizeof(variantFilename), "%.*s_%u%s", (int)(stage - shaderFilename), shaderFilename, variant, stage);
+	return LoadShader(BasePath, device, variantFilename, samplerCount, uniformBufferCount, storageBufferCount, storageTextureCount);
+}
+
+SDL_GPUComputePipeline* CreateComputePipelineFromShader(
+	const char* BasePath,
+	SDL_GPUDevice* device,
+	const char* shaderFilename,
+	SDL_GPUComputePipelineCreateInfo* createInfo
+) {
 	char fullPath[256];
-	SDL_Surface* result;
-	SDL_PixelFormat format;
+	SDL_GPUShaderFormat backendFormats = SDL_GetGPUShaderFormats(device);
+	SDL_GPUShaderFormat format = SDL_GPU_SHADERFORMAT_INVALID;
+	const char* entrypoint;
 
-	SDL_snprintf(fullPath, sizeof(fullPath), "%sContent/Images/%s", basePath, imageFilename);
+	if (backendFormats & SDL_GPU_SHADERFORMAT_SPIRV) {
+		SDL_snprintf(fullPath, sizeof(fullPath), "%sContent/Shaders/Compiled/SPIRV/%s.spv", BasePath, shaderFilename);
+		format = SDL_GPU_SHADERFORMAT_SPIRV;
+		entrypoint = "main";
+	}
+	else if (backendFormats & SDL_GPU_SHADERFORMAT_MSL) {
+		SDL_snprintf(fullPath, sizeof(fullPath), "%sContent/Shaders/Compiled/MSL/%s.msl", BasePath, shaderFilename);
+		format = SDL_GPU_SHADERFORMAT_MSL;
+		entrypoint = "main0";
+	}
+	else if (backendFormats & SDL_GPU_SHADERFORMAT_DXIL) {
+		SDL_snprintf(fullPath, sizeof(fullPath), "%sContent/Shaders/Compiled/DXIL/%s.dxil", BasePath, shaderFilename);
+		format = SDL_GPU_SHADERFORMAT_DXIL;
+		entrypoint = "main";
+	}
+	else {
+		SDL_Log("%s", "Unrecognized backend shader format!");
+		return NULL;
+	}
 
-	result = SDL_LoadBMP(fullPath);
-	if (result == NULL)
+	size_t codeSize;
+	void* code = SDL_LoadFile(fullPath, &codeSize);
+	if (code == NULL)
 	{
-		SDL_Log("Failed to load BMP: %s", SDL_GetError());
+		SDL_Log("Failed to load compute shader from disk! %s", fullPath);
 		return NULL;
 	}
 
-	if (desiredChannels == 4)
+	createInfo->code = (const Uint8*)code;
+	createInfo->code_size = codeSize;
+	createInfo->entrypoint = entrypoint;
+	createInfo->format = format;
+
+	SDL_GPUComputePipeline* pipeline = SDL_CreateGPUComputePipeline(device, createInfo);
+	if (pipeline == NULL)
 	{
-		format = SDL_PIXELFORMAT_ABGR8888;
+		SDL_Log("Failed to create compute pipeline %s: %s", shaderFilename, SDL_GetError());
 	}
-	else
+
+	SDL_free(code);
+	return pipeline;
+}
+
+SDL_Surface* LoadImage(const char* basePath, const char* imageFilename, int desiredChannels)
+{
+	char fullPath[256];
+
+	// Every image comes out of the loader as 4 channels
+	if (desiredChannels != 4)
 	{
 		SDL_assert(!"Unexpected desiredChannels");
-		SDL_DestroySurface(result);
 		return NULL;
 	}
-	if (result->format != format)
+
+	// The cooked form is already in the final format, when asset-cook made one
+	if (CookedTexture_FindCooked(basePath, imageFilename, fullPath, sizeof(fullPath)))
 	{
-		SDL_Surface* next = SDL_ConvertSurface(result, format);
-		SDL_DestroySurface(result);
-		result = next;
+		SDL_Surface* surface = Image_Load(fullPath);
+		if (surface != NULL)
+		{
+			return surface;
+		}
 	}
 
-	return result;
+	SDL_snprintf(fullPath, sizeof(fullPath), "%sContent/Images/%s", basePath, imageFilename);
+	return Image_Load(fullPath);
 }
 
 // Matrix Math
@@ -29,6 +29,31 @@ SDL_GPUShader* LoadShader(
 	Uint32 storageTextureCount
 );
 
+// Loads a compile-time permutation of a shader, built by compile_sprite_variant
+// in CMakeLists.txt as "<name>_<variant>.<stage>" from the same source, e.g.
+// "PullSpriteBatch_3.vert".
+SDL_GPUShader* LoadShaderVariant(
+	const char* BasePath,
+	SDL_GPUDevice* device,
+	const char* shaderFilename,
+	Uint32 variant,
+	Uint32 samplerCount,
+	Uint32 uniformBufferCount,
+	Uint32 storageBufferCount,
+	Uint32 storageTextureCount
+);
+
+// Loads "<name>.comp" and creates a compute pipeline from it. The caller fills
+// in the resource counts and thread counts, the code and format are set here.
+SDL_GPUComputePipeline* CreateComputePipelineFromShader(
+	const char* BasePath,
+	SDL_GPUDevice* device,
+	const char* shaderFilename,
+	SDL_GPUComputePipelineCreateInfo* createInfo
+);
+
+// Loads an image from Content/Images in whichever format it is, see image_loader.h.
+// Its cooked form in Content/Cooked is preferred if there is a usable one.
 SDL_Surface* LoadImage(const char* BasePath, const char* imageFilename, int desiredChannels);
 
 // Vertex Formats
@@ -0,0 +1,158 @@
+#include "cooked_texture.h"
+
+// Beyond anything SDL_GPUTextureCreateInfo allows on a 2D texture
+#define COOKED_TEXTURE_MAX_SIZE 16384
+
+static_assert(sizeof(CookedTextureHeader) == 56);
+
+Uint32 CookedTexture_LevelSize(const SDL_GPUTextureCreateInfo* createInfo, Uint32 level)
+{
+	return SDL_CalculateGPUTextureFormatSize(
+		createInfo->format,
+		SDL_max(createInfo->width >> level, 1u),
+		SDL_max(createInfo->height >> level, 1u),
+		1
+	);
+}
+
+bool CookedTexture_Parse(const void* data, size_t size, const char* name, SDL_GPUTextureCreateInfo* createInfo, Uint32* flags)
+{
+	CookedTextureHeader header;
+	if (size < sizeof(header))
+	{
+		SDL_Log("%s is too short for a cooked texture", name);
+		return false;
+	}
+	SDL_memcpy(&header, data, sizeof(header));
+	if (header.magic != COOKED_TEXTURE_MAGIC || header.version != COOKED_TEXTURE_VERSION)
+	{
+		SDL_Log("%s is not a version %d cooked texture", name, COOKED_TEXTURE_VERSION);
+		return false;
+	}
+
+	// Only what asset-cook writes: single 2D textures, each level's size halved
+	Uint32 maxLevels = 1;
+	while ((SDL_max(header.width, header.height) >> maxLevels) != 0)
+	{
+		maxLevels += 1;
+	}
+	if (header.type != SDL_GPU_TEXTURETYPE_2D ||
+		header.layer_count_or_depth != 1 ||
+		header.width == 0 || header.width > COOKED_TEXTURE_MAX_SIZE ||
+		header.height == 0 || header.height > COOKED_TEXTURE_MAX_SIZE ||
+		header.num_levels == 0 || header.num_levels > maxLevels)
+	{
+		SDL_Log("%s has an unexpected layout, %ux%u with %u levels", name, header.width, header.height, header.num_levels);
+		return false;
+	}
+
+	*createInfo = SDL_GPUTextureCreateInfo{
+		.type = (SDL_GPUTextureType)header.type,
+		.format = (SDL_GPUTextureFormat)header.format,
+		.usage = header.usage,
+		.width = header.width,
+		.height = header.height,
+		.layer_count_or_depth = header.layer_count_or_depth,
+		.num_levels = header.num_levels,
+		.sample_count = (SDL_GPUSampleCount)header.sample_count,
+	};
+	*flags = header.flags;
+
+	size_t expectedSize = sizeof(header);
+	for (Uint32 level = 0; level < header.num_levels; level += 1)
+	{
+		const Uint32 levelSize = CookedTexture_LevelSize(createInfo, level);
+		if (levelSize == 0)
+		{
+			SDL_Log("%s has unknown format %u", name, header.format);
+			return false;
+		}
+		expectedSize += levelSize;
+	}
+	if (size != expectedSize)
+	{
+		SDL_Log("%s is %zu bytes, its header describes %zu", name, size, expectedSize);
+		return false;
+	}
+	return true;
+}
+
+SDL_GPUTexture* CookedTexture_Create(UploadScheduler* uploads, const void* data, size_t size, const char* name, UploadPriority priority, Uint64* bytes)
+{
+	SDL_GPUTextureCreateInfo createInfo;
+	Uint32 flags;
+	if (!CookedTexture_Parse(data, size, name, &createInfo, &flags))
+	{
+		return NULL;
+	}
+	// Block compression in particular is missing on many mobile GPUs
+	if (!SDL_GPUTextureSupportsFormat(uploads->device, createInfo.format, createInfo.type, createInfo.usage))
+	{
+		SDL_Log("%s is cooked to format %u, which this device can't sample", name, createInfo.format);
+		return NULL;
+	}
+
+	SDL_GPUTexture* texture = SDL_CreateGPUTexture(uploads->device, &createInfo);
+	if (texture == NULL)
+	{
+		SDL_Log("Failed to create texture for %s: %s", name, SDL_GetError());
+		return NULL;
+	}
+
+	const Uint8* levelData = (const Uint8*)data + sizeof(CookedTextureHeader);
+	*bytes = 0;
+	for (Uint32 level = 0; level < createInfo.num_levels; level += 1)
+	{
+		const Uint32 levelSize = CookedTexture_LevelSize(&createInfo, level);
+		void* dest = UploadScheduler_QueueTextureLevel(
+			uploads,
+			texture,
+			level,
+			SDL_max(createInfo.width >> level, 1u),
+			SDL_max(createInfo.height >> level, 1u),
+			levelSize,
+			priority
+		);
+		SDL_memcpy(dest, levelData, levelSize);
+		levelData += levelSize;
+		*bytes += levelSize;
+	}
+	return texture;
+}
+
+void CookedTexture_GetPath(const char* basePath, const char* imageFilename, char* path, size_t pathSize)
+{
+	const char* extension = SDL_strrchr(imageFilename, '.');
+	const int stemLength = extension != NULL ? (int)(extension - imageFilename) : (int)SDL_strlen(imageFilename);
+	SDL_snprintf(path, pathSize, "%s" COOKED_TEXTURE_DIRECTORY "%.*s" COOKED_TEXTURE_EXTENSION, basePath, stemLength, imageFilename);
+}
+
+bool CookedTexture_FindCooked(const char* basePath, const char* imageFilename, char* path, size_t pathSize)
+{
+	CookedTexture_GetPath(basePath, imageFilename, path, pathSize);
+	SDL_IOStream* io = SDL_IOFromFile(path, "rb");
+	if (io == NULL)
+	{
+		return false;
+	}
+	CookedTextureHeader header;
+	const bool read = SDL_ReadIO(io, &header, sizeof(header)) == sizeof(header);
+	SDL_CloseIO(io);
+
+	// Stale once the image changed after cooking, then it is loaded instead. Its
+	// bytes are compared rather than its modify time, which copying it resets.
+	char sourcePath[256];
+	size_t sourceSize;
+	SDL_snprintf(sourcePath, sizeof(sourcePath), "%sContent/Images/%s", basePath, imageFilename);
+	void* source = read ? SDL_LoadFile(sourcePath, &sourceSize) : NULL;
+	const bool stale = source != NULL &&
+		(header.source_size != sourceSize || header.source_crc32 != SDL_crc32(0, source, sourceSize));
+	SDL_free(source);
+	if (stale)
+	{
+		SDL_Log("%s was cooked from another version of %s, using the image", path, imageFilename);
+		return false;
+	}
+	// Anything else wrong with it is for CookedTexture_Parse to report
+	return true;
+}
@@ -0,0 +1,63 @@
+#pragma once
+#ifndef SDL_SAMPLE_COOKED_TEXTURE_H
+#define SDL_SAMPLE_COOKED_TEXTURE_H
+
+#include <SDL3/SDL.h>
+#include "upload_scheduler.h"
+
+#define COOKED_TEXTURE_MAGIC 0x58455447  // "GTEX"
+#define COOKED_TEXTURE_VERSION 1
+// Where asset-cook puts the cooked form of Content/Images/<name>.<ext>: Content/Cooked/<name>.gputex
+#define COOKED_TEXTURE_DIRECTORY "Content/Cooked/"
+#define COOKED_TEXTURE_EXTENSION ".gputex"
+
+typedef enum CookedTextureFlags
+{
+	COOKED_TEXTURE_PREMULTIPLIED = 1 << 0,  // color already multiplied by alpha, blend with ONE, ONE_MINUS_SRC_ALPHA
+} CookedTextureFlags;
+
+// A texture as the GPU takes it, written offline by tools/asset_cook.cpp. The
+// header is SDL_GPUTextureCreateInfo field for field, then the CRC-32 and size
+// of the image file it was cooked from, followed by every mip level of the
+// first layer, largest first, each exactly SDL_CalculateGPUTextureFormatSize
+// bytes. Loading is one read, then one upload per level straight from the
+// file's bytes.
+typedef struct CookedTextureHeader
+{
+	Uint32 magic;
+	Uint32 version;
+	Uint32 type;                  // SDL_GPUTextureType
+	Uint32 format;                // SDL_GPUTextureFormat
+	Uint32 usage;                 // SDL_GPUTextureUsageFlags
+	Uint32 width;
+	Uint32 height;
+	Uint32 layer_count_or_depth;
+	Uint32 num_levels;
+	Uint32 sample_count;          // SDL_GPUSampleCount
+	Uint32 flags;                 // CookedTextureFlags
+	Uint32 source_crc32;          // SDL_crc32 of the image file's bytes
+	Uint64 source_size;
+} CookedTextureHeader;
+
+// The size of one mip level's data
+Uint32 CookedTexture_LevelSize(const SDL_GPUTextureCreateInfo* createInfo, Uint32 level);
+
+// Checks that data is a cooked texture holding all of its levels and fills in
+// createInfo from its header. Returns false after logging why if it isn't.
+bool CookedTexture_Parse(const void* data, size_t size, const char* name, SDL_GPUTextureCreateInfo* createInfo, Uint32* flags);
+
+// Creates the texture and queues the upload of every level. bytes receives the
+// GPU memory it takes. Fails if the device can't sample the cooked format.
+SDL_GPUTexture* CookedTexture_Create(UploadScheduler* uploads, const void* data, size_t size, const char* name, UploadPriority priority, Uint64* bytes);
+
+// Writes the path of the cooked form of an image in Content/Images
+void CookedTexture_GetPath(const char* basePath, const char* imageFilename, char* path, size_t pathSize);
+
+// Writes the path of the cooked form of an image in Content/Images and returns
+// whether it exists and was cooked from the image as it is now, with the same
+// size and CRC-32. That reads the whole image, so callers loading it more than
+// once keep the answer. When the image itself is missing, the cooked form is
+// all there is and is used as it is.
+bool CookedTexture_FindCooked(const char* basePath, const char* imageFilename, char* path, size_t pathSize);
+
+#endif
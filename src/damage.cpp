@@ -0,0 +1,69 @@
+#include "damage.h"
+
+void Damage_Invalidate(DamageTracker* damage)
+{
+	damage->invalidated = true;
+}
+
+void Damage_Schedule(DamageTracker* damage, Uint64 whenNS)
+{
+	if (damage->wakeNS == 0 || whenNS < damage->wakeNS)
+	{
+		damage->wakeNS = whenNS;
+	}
+}
+
+void Damage_TrackCamera(DamageTracker* damage, const Matrix4x4* camera)
+{
+	if (!damage->hasCamera || SDL_memcmp(&damage->lastCamera, camera, sizeof(Matrix4x4)) != 0)
+	{
+		damage->lastCamera = *camera;
+		damage->hasCamera = true;
+		damage->invalidated = true;
+	}
+}
+
+void Damage_TrackLayer(DamageTracker* damage, const SpriteLayer* layer)
+{
+	if (layer->dirty)
+	{
+		damage->invalidated = true;
+	}
+}
+
+bool Damage_NeedsRender(const DamageTracker* damage, Uint64 nowNS)
+{
+	return damage->invalidated || (damage->wakeNS != 0 && nowNS >= damage->wakeNS);
+}
+
+void Damage_Clear(DamageTracker* damage)
+{
+	damage->invalidated = false;
+	damage->wakeNS = 0;
+}
+
+void Damage_WaitForChange(const DamageTracker* damage, Uint64 nowNS, Uint64 maxWaitNS)
+{
+	Uint64 deadlineNS = nowNS + maxWaitNS;
+	if (damage->wakeNS != 0 && damage->wakeNS < deadlineNS)
+	{
+		deadlineNS = damage->wakeNS;
+	}
+	if (deadlineNS <= nowNS)
+	{
+		return;
+	}
+
+	// Events only wake us with millisecond resolution, so block on them for
+	// the bulk of the wait and finish with a precise delay.
+	const Uint64 waitMS = (deadlineNS - nowNS) / SDL_NS_PER_MS;
+	if (waitMS > 1 && SDL_WaitEventTimeout(NULL, (Sint32)(waitMS - 1)))
+	{
+		return;
+	}
+	const Uint64 afterWaitNS = SDL_GetTicksNS();
+	if (afterWaitNS < deadlineNS)
+	{
+		SDL_DelayPrecise(deadlineNS - afterWaitNS);
+	}
+}
@@ -0,0 +1,36 @@
+#pragma once
+#ifndef SDL_SAMPLE_DAMAGE_H
+#define SDL_SAMPLE_DAMAGE_H
+
+#include <SDL3/SDL.h>
+#include "common.h"
+#include "sprite_layer.h"
+
+// Decides whether a frame would look any different from the last one drawn.
+// Anything that changes the picture either invalidates right away or, for
+// time-driven content like flipbooks, schedules the moment it will change.
+typedef struct DamageTracker
+{
+	bool invalidated;
+	Uint64 wakeNS;          // earliest scheduled change on the SDL_GetTicksNS clock, 0 if none
+	bool hasCamera;
+	Matrix4x4 lastCamera;
+} DamageTracker;
+
+void Damage_Invalidate(DamageTracker* damage);
+void Damage_Schedule(DamageTracker* damage, Uint64 whenNS);
+
+// Invalidate if the camera moved since the last call
+void Damage_TrackCamera(DamageTracker* damage, const Matrix4x4* camera);
+// Invalidate if the layer holds instances that were not uploaded yet
+void Damage_TrackLayer(DamageTracker* damage, const SpriteLayer* layer);
+
+bool Damage_NeedsRender(const DamageTracker* damage, Uint64 nowNS);
+// Call once a frame was rendered, before tracking the next one
+void Damage_Clear(DamageTracker* damage);
+
+// Sleeps until an event arrives, the next scheduled change is due, or
+// maxWaitNS passed, whichever comes first.
+void Damage_WaitForChange(const DamageTracker* damage, Uint64 nowNS, Uint64 maxWaitNS);
+
+#endif
@@ -0,0 +1,182 @@
+#include "dynamic_resolution.h"
+#include "common.h"
+
+static const float MIN_SCALE = 0.5f;
+static const float MAX_SCALE = 1.0f;
+static const float SCALE_DOWN_STEP = 0.05f;
+static const float SCALE_UP_STEP = 0.025f;
+static const float SMOOTHING = 0.1f;
+static const Uint32 FRAMES_BETWEEN_CHANGES = 10;
+
+// Laid out like the UniformBlock of Upscale.frag.hlsl
+typedef struct UpscaleUniforms
+{
+	float regionScale[2];
+	float regionMax[2];
+} UpscaleUniforms;
+
+// Size of the rendered region along one axis
+static Uint32 ScaledExtent(Uint32 size, float scale)
+{
+	return SDL_max((Uint32)1, (Uint32)(size * scale));
+}
+
+bool DynamicResolution_Init(DynamicResolution* resolution, SDL_GPUDevice* device, const char* basePath, SDL_GPUTextureFormat format, float targetMs)
+{
+	*resolution = DynamicResolution{};
+	resolution->scale = MAX_SCALE;
+	resolution->targetMs = targetMs;
+	resolution->workMs = targetMs;
+	resolution->format = format;
+
+	SDL_GPUShader* vertShader = LoadShader(basePath, device, "Upscale.vert", 0, 0, 0, 0);
+	SDL_GPUShader* fragShader = LoadShader(basePath, device, "Upscale.frag", 1, 1, 0, 0);
+	if (vertShader != NULL && fragShader != NULL)
+	{
+		const SDL_GPUColorTargetDescription colorTarget = {
+			.format = format,
+		};
+		auto graphicsPipelineCreateInfo = SDL_GPUGraphicsPipelineCreateInfo{
+			.vertex_shader = vertShader,
+			.fragment_shader = fragShader,
+			.primitive_type = SDL_GPU_PRIMITIVETYPE_TRIANGLELIST,
+			.target_info = {
+				.color_target_descriptions = &colorTarget,
+				.num_color_targets = 1,
+			},
+		};
+		resolution->upscalePipeline = SDL_CreateGPUGraphicsPipeline(device, &graphicsPipelineCreateInfo);
+		if (resolution->upscalePipeline == NULL)
+		{
+			SDL_Log("Failed to create upscale pipeline: %s", SDL_GetError());
+		}
+	}
+	SDL_ReleaseGPUShader(device, vertShader);
+	SDL_ReleaseGPUShader(device, fragShader);
+
+	SDL_GPUSamplerCreateInfo samplerCreateInfo = {
+		.min_filter = SDL_GPU_FILTER_LINEAR,
+		.mag_filter = SDL_GPU_FILTER_LINEAR,
+		.mipmap_mode = SDL_GPU_SAMPLERMIPMAPMODE_NEAREST,
+		.address_mode_u = SDL_GPU_SAMPLERADDRESSMODE_CLAMP_TO_EDGE,
+		.address_mode_v = SDL_GPU_SAMPLERADDRESSMODE_CLAMP_TO_EDGE,
+		.address_mode_w = SDL_GPU_SAMPLERADDRESSMODE_CLAMP_TO_EDGE,
+	};
+	resolution->sampler = SDL_CreateGPUSampler(device, &samplerCreateInfo);
+	return resolution->upscalePipeline != NULL && resolution->sampler != NULL;
+}
+
+void DynamicResolution_Release(DynamicResolution* resolution, SDL_GPUDevice* device)
+{
+	SDL_ReleaseGPUTexture(device, resolution->target);
+	SDL_ReleaseGPUGraphicsPipeline(device, resolution->upscalePipeline);
+	SDL_ReleaseGPUSampler(device, resolution->sampler);
+	resolution->target = NULL;
+	resolution->upscalePipeline = NULL;
+	resolution->sampler = NULL;
+}
+
+void DynamicResolution_Update(DynamicResolution* resolution, float cpuMs, float gpuMs)
+{
+	// The slower of the two processors bounds the frame rate
+	const float workMs = SDL_max(cpuMs, gpuMs);
+	resolution->workMs += (workMs - resolution->workMs) * SMOOTHING;
+	resolution->framesSinceChange += 1;
+	if (resolution->framesSinceChange < FRAMES_BETWEEN_CHANGES)
+	{
+		return;
+	}
+
+	// Drop quickly when over budget, recover slowly, and leave a dead band
+	// between the two so the scale settles instead of hunting.
+	float scale = resolution->scale;
+	if (resolution->workMs > resolution->targetMs * 1.05f)
+	{
+		scale -= SCALE_DOWN_STEP;
+	}
+	else if (resolution->workMs < resolution->targetMs * 0.85f)
+	{
+		scale += SCALE_UP_STEP;
+	}
+	scale = SDL_clamp(scale, MIN_SCALE, MAX_SCALE);
+
+	if (scale != resolution->scale)
+	{
+		resolution->scale = scale;
+		resolution->framesSinceChange = 0;
+	}
+}
+
+SDL_GPUTexture* DynamicResolution_Begin(
+	DynamicResolution* resolution,
+	SDL_GPUDevice* device,
+	Uint32 swapchainWidth,
+	Uint32 swapchainHeight,
+	SDL_GPUViewport* viewport
+) {
+	if (resolution->target == NULL || resolution->targetWidth != swapchainWidth || resolution->targetHeight != swapchainHeight)
+	{
+		SDL_ReleaseGPUTexture(device, resolution->target);
+
+		SDL_GPUTextureCreateInfo textureCreateInfo = {
+			.type = SDL_GPU_TEXTURETYPE_2D,
+			.format = resolution->format,
+			.usage = SDL_GPU_TEXTUREUSAGE_COLOR_TARGET | SDL_GPU_TEXTUREUSAGE_SAMPLER,
+			.width = swapchainWidth,
+			.height = swapchainHeight,
+			.layer_count_or_depth = 1,
+			.num_levels = 1,
+		};
+		resolution->target = SDL_CreateGPUTexture(device, &textureCreateInfo);
+		if (resolution->target == NULL)
+		{
+			SDL_Log("Failed to create dynamic resolution target: %s", SDL_GetError());
+			return NULL;
+		}
+		resolution->targetWidth = swapchainWidth;
+		resolution->targetHeight = swapchainHeight;
+	}
+
+	*viewport = SDL_GPUViewport{
+		.x = 0,
+		.y = 0,
+		.w = (float)ScaledExtent(swapchainWidth, resolution->scale),
+		.h = (float)ScaledExtent(swapchainHeight, resolution->scale),
+		.min_depth = 0,
+		.max_depth = 1
+	};
+	return resolution->target;
+}
+
+void DynamicResolution_Present(
+	const DynamicResolution* resolution,
+	SDL_GPUCommandBuffer* cmdBuf,
+	SDL_GPUTexture* swapchainTexture,
+	Uint32 swapchainWidth,
+	Uint32 swapchainHeight
+) {
+	// A blit of the region would filter in the texels past its right and
+	// bottom edges, the shader clamps to the last rendered ones instead
+	const float sourceWidth = (float)ScaledExtent(swapchainWidth, resolution->scale);
+	const float sourceHeight = (float)ScaledExtent(swapchainHeight, resolution->scale);
+	const UpscaleUniforms uniforms = {
+		.regionScale = { sourceWidth / resolution->targetWidth, sourceHeight / resolution->targetHeight },
+		.regionMax = { (sourceWidth - 0.5f) / resolution->targetWidth, (sourceHeight - 0.5f) / resolution->targetHeight },
+	};
+
+	const SDL_GPUColorTargetInfo colorTargetInfo = {
+		.texture = swapchainTexture,
+		.load_op = SDL_GPU_LOADOP_DONT_CARE,
+		.store_op = SDL_GPU_STOREOP_STORE,
+	};
+	const SDL_GPUTextureSamplerBinding textureSamplerBinding = {
+		.texture = resolution->target,
+		.sampler = resolution->sampler,
+	};
+	SDL_GPURenderPass* renderPass = SDL_BeginGPURenderPass(cmdBuf, &colorTargetInfo, 1, NULL);
+	SDL_BindGPUGraphicsPipeline(renderPass, resolution->upscalePipeline);
+	SDL_BindGPUFragmentSamplers(renderPass, 0, &textureSamplerBinding, 1);
+	SDL_PushGPUFragmentUniformData(cmdBuf, 0, &uniforms, sizeof(uniforms));
+	SDL_DrawGPUPrimitives(renderPass, 3, 1, 0, 0);
+	SDL_EndGPURenderPass(renderPass);
+}
@@ -0,0 +1,55 @@
+#pragma once
+#ifndef SDL_SAMPLE_DYNAMIC_RESOLUTION_H
+#define SDL_SAMPLE_DYNAMIC_RESOLUTION_H
+
+#include <SDL3/SDL.h>
+
+// Renders the scene into an offscreen target at a fraction of the swapchain
+// size and scales it up to the swapchain in a pass of its own. The fraction follows
+// the time the frame's work takes: it drops when that runs over the target
+// and slowly recovers once there is headroom again. Waits for the swapchain
+// don't count, under vsync they would always make the frame look over budget.
+//
+// The offscreen texture is allocated at the full swapchain size and the scene
+// is drawn into its top-left corner through the viewport, so changing the
+// scale never reallocates anything.
+typedef struct DynamicResolution
+{
+	float scale;
+	float targetMs;
+	float workMs;               // smoothed, the longer of CPU and GPU time
+	Uint32 framesSinceChange;
+	SDL_GPUTextureFormat format;
+	SDL_GPUTexture* target;
+	Uint32 targetWidth, targetHeight;
+	SDL_GPUGraphicsPipeline* upscalePipeline;
+	SDL_GPUSampler* sampler;
+} DynamicResolution;
+
+bool DynamicResolution_Init(DynamicResolution* resolution, SDL_GPUDevice* device, const char* basePath, SDL_GPUTextureFormat format, float targetMs);
+void DynamicResolution_Release(DynamicResolution* resolution, SDL_GPUDevice* device);
+
+// Feed the CPU time of a frame, without waits, and the GPU time, in
+// milliseconds. Pass 0 for gpuMs when no GPU timings are available.
+void DynamicResolution_Update(DynamicResolution* resolution, float cpuMs, float gpuMs);
+
+// Makes sure the offscreen target matches the swapchain and returns it. The
+// scene must be drawn with the viewport returned through `viewport`.
+SDL_GPUTexture* DynamicResolution_Begin(
+	DynamicResolution* resolution,
+	SDL_GPUDevice* device,
+	Uint32 swapchainWidth,
+	Uint32 swapchainHeight,
+	SDL_GPUViewport* viewport
+);
+
+// Upscales the rendered region onto the swapchain texture
+void DynamicResolution_Present(
+	const DynamicResolution* resolution,
+	SDL_GPUCommandBuffer* cmdBuf,
+	SDL_GPUTexture* swapchainTexture,
+	Uint32 swapchainWidth,
+	Uint32 swapchainHeight
+);
+
+#endif
@@ -0,0 +1,280 @@
+#include "ecs.h"
+
+// Columns start on 16 bytes, for SIMD loads over a component
+static const Uint32 COLUMN_ALIGNMENT = 16;
+static const Uint32 CHUNK_ALIGNMENT = 64;
+
+static Uint32 AlignColumn(Uint32 offset)
+{
+	return (offset + COLUMN_ALIGNMENT - 1) & ~(COLUMN_ALIGNMENT - 1);
+}
+
+void EcsWorld_Init(EcsWorld* world)
+{
+	SDL_zeroa(world->componentSizes);
+	world->componentCount = 0;
+	world->archetypes.clear();
+	world->entities.clear();
+	world->freeEntity = ECS_NO_SLOT;
+	world->freeChunks.clear();
+}
+
+void EcsWorld_Release(EcsWorld* world)
+{
+	for (EcsArchetype& archetype : world->archetypes)
+	{
+		for (Uint8* chunk : archetype.chunks)
+		{
+			SDL_aligned_free(chunk);
+		}
+	}
+	for (Uint8* chunk : world->freeChunks)
+	{
+		SDL_aligned_free(chunk);
+	}
+	world->archetypes.clear();
+	world->entities.clear();
+	world->freeChunks.clear();
+	world->freeEntity = ECS_NO_SLOT;
+}
+
+Uint32 EcsWorld_RegisterComponent(EcsWorld* world, Uint32 size)
+{
+	// an entity of it alone must fit a chunk, with its handle and the padding after both
+	if (world->componentCount == ECS_MAX_COMPONENTS || size == 0 ||
+		size + sizeof(EcsEntity) + COLUMN_ALIGNMENT * 2 > ECS_CHUNK_SIZE)
+	{
+		SDL_Log("Can't register a component of %u bytes", size);
+		return ECS_NO_COLUMN;
+	}
+	world->componentSizes[world->componentCount] = size;
+	world->componentCount += 1;
+	return world->componentCount - 1;
+}
+
+// Fits as many entities in a chunk as the aligned columns allow
+static bool LayoutArchetype(const EcsWorld* world, EcsArchetype* archetype)
+{
+	Uint32 rowSize = sizeof(EcsEntity);
+	for (Uint32 component = 0; component < world->componentCount; component += 1)
+	{
+		if (archetype->mask & ECS_COMPONENT(component))
+		{
+			rowSize += world->componentSizes[component];
+		}
+	}
+
+	for (Uint32 capacity = ECS_CHUNK_SIZE / rowSize; capacity > 0; capacity -= 1)
+	{
+		archetype->entityOffset = 0;
+		Uint32 offset = AlignColumn(capacity * sizeof(EcsEntity));
+		for (Uint32 component = 0; component < ECS_MAX_COMPONENTS; component += 1)
+		{
+			archetype->columnOffsets[component] = ECS_NO_COLUMN;
+			if (archetype->mask & ECS_COMPONENT(component))
+			{
+				archetype->columnOffsets[component] = offset;
+				offset = AlignColumn(offset + capacity * world->componentSizes[component]);
+			}
+		}
+		if (offset <= ECS_CHUNK_SIZE)
+		{
+			archetype->chunkCapacity = capacity;
+			return true;
+		}
+	}
+	return false;
+}
+
+static Uint32 FindArchetype(EcsWorld* world, EcsComponentMask mask)
+{
+	for (Uint32 i = 0; i < (Uint32)world->archetypes.size(); i += 1)
+	{
+		if (world->archetypes[i].mask == mask)
+		{
+			return i;
+		}
+	}
+
+	EcsArchetype archetype = {
+		.mask = mask,
+		.count = 0,
+	};
+	if (!LayoutArchetype(world, &archetype))
+	{
+		SDL_Log("Components 0x%x don't fit in one chunk", mask);
+		return ECS_NO_SLOT;
+	}
+	world->archetypes.push_back(archetype);
+	return (Uint32)world->archetypes.size() - 1;
+}
+
+static Uint8* Element(const EcsArchetype* archetype, Uint32 row, Uint32 columnOffset, Uint32 size)
+{
+	return archetype->chunks[row / archetype->chunkCapacity] + columnOffset + (row % archetype->chunkCapacity) * size;
+}
+
+EcsEntity EcsWorld_Create(EcsWorld* world, EcsComponentMask mask)
+{
+	const Uint32 archetypeIndex = FindArchetype(world, mask);
+	if (archetypeIndex == ECS_NO_SLOT)
+	{
+		return EcsEntity{ ECS_NO_SLOT, 0 };
+	}
+	EcsArchetype* archetype = &world->archetypes[archetypeIndex];
+
+	const Uint32 row = archetype->count;
+	if (row / archetype->chunkCapacity == archetype->chunks.size())
+	{
+		Uint8* chunk = NULL;
+		if (!world->freeChunks.empty())
+		{
+			chunk = world->freeChunks.back();
+			world->freeChunks.pop_back();
+		}
+		else
+		{
+			chunk = (Uint8*)SDL_aligned_alloc(CHUNK_ALIGNMENT, ECS_CHUNK_SIZE);
+			if (chunk == NULL)
+			{
+				SDL_Log("Failed to allocate an entity chunk");
+				return EcsEntity{ ECS_NO_SLOT, 0 };
+			}
+		}
+		archetype->chunks.push_back(chunk);
+	}
+
+	Uint32 index = world->freeEntity;
+	if (index != ECS_NO_SLOT)
+	{
+		world->freeEntity = world->entities[index].row;
+	}
+	else
+	{
+		index = (Uint32)world->entities.size();
+		world->entities.push_back(EcsEntityRecord{ .generation = 0 });
+	}
+	EcsEntityRecord* record = &world->entities[index];
+	record->archetype = archetypeIndex;
+	record->row = row;
+	record->alive = true;
+
+	const EcsEntity entity = { index, record->generation };
+	SDL_memcpy(Element(archetype, row, archetype->entityOffset, sizeof(EcsEntity)), &entity, sizeof(EcsEntity));
+	for (Uint32 component = 0; component < world->componentCount; component += 1)
+	{
+		if (mask & ECS_COMPONENT(component))
+		{
+			const Uint32 size = world->componentSizes[component];
+			SDL_memset(Element(archetype, row, archetype->columnOffsets[component], size), 0, size);
+		}
+	}
+	archetype->count += 1;
+	return entity;
+}
+
+bool EcsWorld_IsAlive(const EcsWorld* world, EcsEntity entity)
+{
+	return entity.index < world->entities.size() &&
+		world->entities[entity.index].alive &&
+		world->entities[entity.index].generation == entity.generation;
+}
+
+bool EcsWorld_Destroy(EcsWorld* world, EcsEntity entity)
+{
+	if (!EcsWorld_IsAlive(world, entity))
+	{
+		return false;
+	}
+	EcsEntityRecord* record = &world->entities[entity.index];
+	EcsArchetype* archetype = &world->archetypes[record->archetype];
+
+	// The archetype's last entity fills the hole, keeping its chunks packed
+	const Uint32 row = record->row;
+	const Uint32 last = archetype->count - 1;
+	if (row != last)
+	{
+		EcsEntity moved;
+		SDL_memcpy(&moved, Element(archetype, last, archetype->entityOffset, sizeof(EcsEntity)), sizeof(EcsEntity));
+		SDL_memcpy(Element(archetype, row, archetype->entityOffset, sizeof(EcsEntity)), &moved, sizeof(EcsEntity));
+		for (Uint32 component = 0; component < world->componentCount; component += 1)
+		{
+			if (archetype->mask & ECS_COMPONENT(component))
+			{
+				const Uint32 size = world->componentSizes[component];
+				const Uint32 offset = archetype->columnOffsets[component];
+				SDL_memcpy(Element(archetype, row, offset, size), Element(archetype, last, offset, size), size);
+			}
+		}
+		world->entities[moved.index].row = row;
+	}
+
+	archetype->count -= 1;
+	if (archetype->count % archetype->chunkCapacity == 0)
+	{
+		world->freeChunks.push_back(archetype->chunks.back());
+		archetype->chunks.pop_back();
+	}
+
+	record->alive = false;
+	record->generation += 1;
+	record->row = world->freeEntity;
+	world->freeEntity = entity.index;
+	return true;
+}
+
+void* EcsWorld_Get(EcsWorld* world, EcsEntity entity, Uint32 component)
+{
+	if (!EcsWorld_IsAlive(world, entity))
+	{
+		return NULL;
+	}
+	const EcsEntityRecord* record = &world->entities[entity.index];
+	const EcsArchetype* archetype = &world->archetypes[record->archetype];
+	if (!(archetype->mask & ECS_COMPONENT(component)))
+	{
+		return NULL;
+	}
+	return Element(archetype, record->row, archetype->columnOffsets[component], world->componentSizes[component]);
+}
+
+EcsQuery EcsWorld_Query(EcsWorld* world, EcsComponentMask mask)
+{
+	return EcsQuery{ world, mask, 0, 0 };
+}
+
+bool EcsQuery_Next(EcsQuery* query, EcsChunkView* view)
+{
+	std::vector<EcsArchetype>& archetypes = query->world->archetypes;
+	while (query->archetype < archetypes.size())
+	{
+		const EcsArchetype* archetype = &archetypes[query->archetype];
+		if ((archetype->mask & query->mask) == query->mask && query->chunk < archetype->chunks.size())
+		{
+			const Uint32 first = query->chunk * archetype->chunkCapacity;
+			view->chunk = archetype->chunks[query->chunk];
+			view->archetype = archetype;
+			view->count = SDL_min(archetype->count - first, archetype->chunkCapacity);
+			query->chunk += 1;
+			return true;
+		}
+		query->archetype += 1;
+		query->chunk = 0;
+	}
+	return false;
+}
+
+Uint32 EcsWorld_CopyColumn(EcsWorld* world, Uint32 component, void* destination, Uint32 capacity)
+{
+	const Uint32 size = world->componentSizes[component];
+	Uint32 copied = 0;
+	EcsQuery query = EcsWorld_Query(world, ECS_COMPONENT(component));
+	EcsChunkView view;
+	while (copied < capacity && EcsQuery_Next(&query, &view))
+	{
+		const Uint32 count = SDL_min(view.count, capacity - copied);
+		SDL_memcpy((Uint8*)destination + (size_t)copied * size, EcsChunkView_Column(&view, component), (size_t)count * size);
+		copied += count;
+	}
+	return copied;
+}
@@ -0,0 +1,112 @@
+#pragma once
+#ifndef SDL_SAMPLE_ECS_H
+#define SDL_SAMPLE_ECS_H
+
+#include <SDL3/SDL.h>
+#include <vector>
+
+#define ECS_CHUNK_SIZE (16 * 1024)
+#define ECS_MAX_COMPONENTS 32
+#define ECS_NO_COLUMN 0xFFFFFFFF
+#define ECS_NO_SLOT 0xFFFFFFFF
+
+typedef Uint32 EcsComponentMask;
+#define ECS_COMPONENT(id) ((EcsComponentMask)1 << (id))
+
+// Generational handle: a destroyed entity's slot is reused with the next
+// generation, so stale handles are recognized instead of aliasing the new entity.
+typedef struct EcsEntity
+{
+	Uint32 index;
+	Uint32 generation;
+} EcsEntity;
+
+// All entities with exactly the same set of components. They live in 16 KB
+// chunks, each component in its own contiguous column, so a column can be
+// copied or streamed as a whole. Every chunk but the last is full.
+typedef struct EcsArchetype
+{
+	EcsComponentMask mask;
+	Uint32 chunkCapacity;
+	Uint32 columnOffsets[ECS_MAX_COMPONENTS];  // ECS_NO_COLUMN for components it doesn't have
+	Uint32 entityOffset;                       // column of EcsEntity, to find an entity from its row
+	std::vector<Uint8*> chunks;
+	Uint32 count;
+} EcsArchetype;
+
+typedef struct EcsEntityRecord
+{
+	Uint32 generation;
+	Uint32 archetype;
+	Uint32 row;        // across the archetype's chunks, or the next free slot while unused
+	bool alive;
+} EcsEntityRecord;
+
+// A minimal archetype entity-component store. Components are plain data
+// registered by size, entities are created with a fixed set of them, and
+// systems run over whole chunks through EcsQuery rather than per entity.
+//
+// Destroying an entity moves its archetype's last entity into the hole, so
+// chunks stay packed. Emptied chunks go to a free list that every archetype
+// draws from, and entity slots are recycled, so a steady population
+// allocates nothing.
+typedef struct EcsWorld
+{
+	Uint32 componentSizes[ECS_MAX_COMPONENTS];
+	Uint32 componentCount;
+	std::vector<EcsArchetype> archetypes;
+	std::vector<EcsEntityRecord> entities;
+	Uint32 freeEntity;                // head of the free slot list, or ECS_NO_SLOT
+	std::vector<Uint8*> freeChunks;
+} EcsWorld;
+
+// A run of entities in one chunk, all with the components queried for
+typedef struct EcsChunkView
+{
+	Uint8* chunk;
+	const EcsArchetype* archetype;
+	Uint32 count;
+} EcsChunkView;
+
+// Visits every chunk whose archetype has all components in `mask`.
+typedef struct EcsQuery
+{
+	EcsWorld* world;
+	EcsComponentMask mask;
+	Uint32 archetype;
+	Uint32 chunk;
+} EcsQuery;
+
+void EcsWorld_Init(EcsWorld* world);
+void EcsWorld_Release(EcsWorld* world);
+
+// Returns the id to use with ECS_COMPONENT and the accessors, or
+// ECS_NO_COLUMN if there are too many or it is too large for a chunk.
+// Components are copied and zeroed as raw bytes.
+Uint32 EcsWorld_RegisterComponent(EcsWorld* world, Uint32 size);
+
+// Creates an entity with the given components, zeroed. Creating the first
+// entity of a new set of components invalidates running queries.
+EcsEntity EcsWorld_Create(EcsWorld* world, EcsComponentMask mask);
+// Returns false if the entity was already destroyed
+bool EcsWorld_Destroy(EcsWorld* world, EcsEntity entity);
+bool EcsWorld_IsAlive(const EcsWorld* world, EcsEntity entity);
+
+// NULL if the entity is dead or doesn't have the component. The pointer
+// stays valid until an entity of the same archetype is created or destroyed.
+void* EcsWorld_Get(EcsWorld* world, EcsEntity entity, Uint32 component);
+
+EcsQuery EcsWorld_Query(EcsWorld* world, EcsComponentMask mask);
+bool EcsQuery_Next(EcsQuery* query, EcsChunkView* view);
+
+static inline void* EcsChunkView_Column(const EcsChunkView* view, Uint32 component)
+{
+	return view->chunk + view->archetype->columnOffsets[component];
+}
+
+// Copies the component of every entity that has it into `destination`, back
+// to back, with one copy per chunk. E.g. a SpriteInstance component straight
+// into a mapped SpriteLayer. Stops at `capacity` entities, returns how many were copied.
+Uint32 EcsWorld_CopyColumn(EcsWorld* world, Uint32 component, void* destination, Uint32 capacity);
+
+#endif
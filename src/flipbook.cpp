@@ -0,0 +1,58 @@
+#include "flipbook.h"
+
+Uint16 FrameTable_AddAnimation(FrameTable* table, const FlipbookFrame* frames, Uint32 frameCount)
+{
+	if (frameCount == 0 || table->animationFirst.size() >= SDL_MAX_UINT16)
+	{
+		SDL_Log("Invalid flipbook animation!");
+		return 0;
+	}
+
+	table->animationFirst.push_back((Uint32)table->frames.size());
+	table->animationCount.push_back(frameCount);
+	table->frames.insert(table->frames.end(), frames, frames + frameCount);
+
+	return (Uint16)table->animationFirst.size();
+}
+
+bool FrameTable_Upload(FrameTable* table, SDL_GPUDevice* device, UploadScheduler* scheduler)
+{
+	const Uint32 animationCount = (Uint32)table->animationFirst.size();
+	const Uint32 entryCount = animationCount + (Uint32)table->frames.size();
+	if (entryCount == 0)
+	{
+		// Storage buffers cannot be empty, keep a single unused entry around
+		// so the vertex shader always has something bound.
+		static const FlipbookFrame emptyFrame = { 0, 0, 0, 0 };
+		table->frames.push_back(emptyFrame);
+		return FrameTable_Upload(table, device, scheduler);
+	}
+	const Uint32 size = entryCount * sizeof(FlipbookFrame);
+
+	auto bufferCreateInfo = SDL_GPUBufferCreateInfo{
+		.usage = SDL_GPU_BUFFERUSAGE_GRAPHICS_STORAGE_READ,
+		.size = size
+	};
+	table->buffer = SDL_CreateGPUBuffer(device, &bufferCreateInfo);
+	if (table->buffer == NULL)
+	{
+		SDL_Log("Failed to create frame table buffer: %s", SDL_GetError());
+		return false;
+	}
+
+	FlipbookFrame* entries = (FlipbookFrame*)UploadScheduler_QueueBuffer(scheduler, table->buffer, 0, size, UPLOAD_PRIORITY_VISIBLE);
+	for (Uint32 i = 0; i < animationCount; i += 1)
+	{
+		// Headers store integers in float slots, the shader reads them back with asuint()
+		Uint32 header[4] = { animationCount + table->animationFirst[i], table->animationCount[i], 0, 0 };
+		SDL_memcpy(&entries[i], header, sizeof(header));
+	}
+	SDL_memcpy(&entries[animationCount], table->frames.data(), table->frames.size() * sizeof(FlipbookFrame));
+	return true;
+}
+
+void FrameTable_Release(FrameTable* table, SDL_GPUDevice* device)
+{
+	SDL_ReleaseGPUBuffer(device, table->buffer);
+	table->buffer = NULL;
+}
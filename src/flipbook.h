@@ -0,0 +1,54 @@
+#pragma once
+#ifndef SDL_SAMPLE_FLIPBOOK_H
+#define SDL_SAMPLE_FLIPBOOK_H
+
+#include <SDL3/SDL.h>
+#include <vector>
+#include "upload_scheduler.h"
+
+// How an animation behaves once it has played its last frame.
+// Keep in sync with the LOOP_* constants in PullSpriteBatch.vert.hlsl.
+typedef enum FlipbookLoopMode
+{
+	FLIPBOOK_LOOP_REPEAT = 0,
+	FLIPBOOK_LOOP_ONCE = 1,
+	FLIPBOOK_LOOP_PINGPONG = 2
+} FlipbookLoopMode;
+
+// A single frame, as a UV rect into the sprite atlas.
+typedef struct FlipbookFrame
+{
+	float u, v, w, h;
+} FlipbookFrame;
+
+// The frame table holds every animation's frames in one storage buffer so the
+// vertex shader can pick the current frame without the CPU touching the
+// sprite instances. The GPU layout is a flat array of float4:
+//   [0, animationCount)       one header per animation: asuint(first frame), asuint(frame count), 0, 0
+//   [animationCount, ...)     the frames themselves
+typedef struct FrameTable
+{
+	std::vector<FlipbookFrame> frames;
+	std::vector<Uint32> animationFirst;
+	std::vector<Uint32> animationCount;
+	SDL_GPUBuffer* buffer;
+} FrameTable;
+
+// Registers an animation and returns its id. Ids start at 1, since 0 marks a
+// sprite that uses its own tex_u/tex_v/tex_w/tex_h instead.
+Uint16 FrameTable_AddAnimation(FrameTable* table, const FlipbookFrame* frames, Uint32 frameCount);
+
+// Creates the GPU buffer and queues its upload. Every animated sprite reads
+// it, so it goes out with the next frame. Call once after all animations have been added.
+bool FrameTable_Upload(FrameTable* table, SDL_GPUDevice* device, UploadScheduler* scheduler);
+
+void FrameTable_Release(FrameTable* table, SDL_GPUDevice* device);
+
+// Packs the per-instance animation word stored in SpriteInstance::animation.
+// Bits 0-15 hold the animation id, 16-23 the loop mode and 24-31 the frame rate.
+inline Uint32 Flipbook_Pack(Uint16 animation, FlipbookLoopMode loopMode, Uint8 fps)
+{
+	return (Uint32)animation | ((Uint32)loopMode << 16) | ((Uint32)fps << 24);
+}
+
+#endif
@@ -0,0 +1,46 @@
+#include "frame_stats.h"
+
+void RollingStats_Add(RollingStats* stats, float sample)
+{
+	stats->samples[stats->next] = sample;
+	stats->next = (stats->next + 1) % ROLLING_STATS_WINDOW;
+	stats->count = SDL_min(stats->count + 1, (Uint32)ROLLING_STATS_WINDOW);
+}
+
+void RollingStats_Reset(RollingStats* stats)
+{
+	stats->count = 0;
+	stats->next = 0;
+}
+
+static int CompareFloats(const void* a, const void* b)
+{
+	const float lhs = *(const float*)a;
+	const float rhs = *(const float*)b;
+	return (lhs > rhs) - (lhs < rhs);
+}
+
+RollingStatsSummary RollingStats_Summarize(const RollingStats* stats)
+{
+	RollingStatsSummary summary = { 0, 0, 0, 0, 0 };
+	if (stats->count == 0)
+	{
+		return summary;
+	}
+
+	float sorted[ROLLING_STATS_WINDOW];
+	float total = 0;
+	for (Uint32 i = 0; i < stats->count; i += 1)
+	{
+		sorted[i] = stats->samples[i];
+		total += stats->samples[i];
+	}
+	SDL_qsort(sorted, stats->count, sizeof(float), CompareFloats);
+
+	summary.count = stats->count;
+	summary.min = sorted[0];
+	summary.avg = total / stats->count;
+	summary.p95 = sorted[(stats->count - 1) * 95 / 100];
+	summary.max = sorted[stats->count - 1];
+	return summary;
+}
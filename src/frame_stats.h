@@ -0,0 +1,28 @@
+#pragma once
+#ifndef SDL_SAMPLE_FRAME_STATS_H
+#define SDL_SAMPLE_FRAME_STATS_H
+
+#include <SDL3/SDL.h>
+
+#define ROLLING_STATS_WINDOW 256
+
+// Keeps the most recent ROLLING_STATS_WINDOW samples of a timing, in milliseconds.
+typedef struct RollingStats
+{
+	float samples[ROLLING_STATS_WINDOW];
+	Uint32 count;
+	Uint32 next;
+} RollingStats;
+
+typedef struct RollingStatsSummary
+{
+	Uint32 count;
+	float min, avg, p95, max;
+} RollingStatsSummary;
+
+void RollingStats_Add(RollingStats* stats, float sample);
+// Drops every sample, e.g. when what is measured changes
+void RollingStats_Reset(RollingStats* stats);
+RollingStatsSummary RollingStats_Summarize(const RollingStats* stats);
+
+#endif
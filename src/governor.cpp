@@ -0,0 +1,67 @@
+#include "governor.h"
+
+// Tuning for the hysteresis described in governor.h
+static const float SMOOTHING = 0.1f;
+static const float DOWNGRADE_THRESHOLD = 0.95f;   // of the budget
+static const float UPGRADE_THRESHOLD = 0.7f;
+static const Uint32 DOWNGRADE_FRAMES = 10;
+static const Uint32 UPGRADE_FRAMES = 120;
+static const Uint32 COOLDOWN_FRAMES = 30;
+
+void FrameGovernor_Init(FrameGovernor* governor, float budgetMs)
+{
+	*governor = FrameGovernor{};
+	governor->budgetMs = budgetMs;
+	governor->level = GOVERNOR_LEVEL_COUNT - 1;
+	governor->cpuMs = budgetMs * UPGRADE_THRESHOLD;
+}
+
+bool FrameGovernor_Update(FrameGovernor* governor, float cpuMs, float gpuMs)
+{
+	governor->cpuMs += (cpuMs - governor->cpuMs) * SMOOTHING;
+	governor->gpuMs += (gpuMs - governor->gpuMs) * SMOOTHING;
+
+	if (governor->cooldownFrames > 0)
+	{
+		governor->cooldownFrames -= 1;
+		return false;
+	}
+
+	// The slower of the two processors bounds the frame rate
+	const float frameMs = SDL_max(governor->cpuMs, governor->gpuMs);
+	if (frameMs > governor->budgetMs * DOWNGRADE_THRESHOLD)
+	{
+		governor->overBudgetFrames += 1;
+		governor->underBudgetFrames = 0;
+	}
+	else if (frameMs < governor->budgetMs * UPGRADE_THRESHOLD)
+	{
+		governor->underBudgetFrames += 1;
+		governor->overBudgetFrames = 0;
+	}
+	else
+	{
+		governor->overBudgetFrames = 0;
+		governor->underBudgetFrames = 0;
+	}
+
+	int level = governor->level;
+	if (governor->overBudgetFrames >= DOWNGRADE_FRAMES && level > 0)
+	{
+		level -= 1;
+	}
+	else if (governor->underBudgetFrames >= UPGRADE_FRAMES && level < GOVERNOR_LEVEL_COUNT - 1)
+	{
+		level += 1;
+	}
+
+	if (level == governor->level)
+	{
+		return false;
+	}
+	governor->level = level;
+	governor->overBudgetFrames = 0;
+	governor->underBudgetFrames = 0;
+	governor->cooldownFrames = COOLDOWN_FRAMES;
+	return true;
+}
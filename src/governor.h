@@ -0,0 +1,40 @@
+#pragma once
+#ifndef SDL_SAMPLE_GOVERNOR_H
+#define SDL_SAMPLE_GOVERNOR_H
+
+#include <SDL3/SDL.h>
+
+#define GOVERNOR_LEVEL_COUNT 5
+
+// Scales optional work up or down so frames stay within a time budget.
+// The result is published as a quality level from 0 (least work) to
+// GOVERNOR_LEVEL_COUNT - 1 (everything on); systems read it each frame and
+// decide for themselves what to shed.
+//
+// To avoid oscillating around the budget, the level drops only after frames
+// have been over budget for a while and rises only after a longer stretch with
+// clear headroom, then holds still for a cooldown period.
+typedef struct FrameGovernor
+{
+	float budgetMs;
+	int level;
+	float cpuMs;                // smoothed
+	float gpuMs;                // smoothed, 0 while no GPU timings are available
+	Uint32 overBudgetFrames;
+	Uint32 underBudgetFrames;
+	Uint32 cooldownFrames;
+} FrameGovernor;
+
+void FrameGovernor_Init(FrameGovernor* governor, float budgetMs);
+
+// Feed the CPU and GPU time of a frame, in milliseconds. Pass 0 for gpuMs when
+// it is not known. Returns true when the quality level changed.
+bool FrameGovernor_Update(FrameGovernor* governor, float cpuMs, float gpuMs);
+
+// The quality level as a fraction, 1.0 at the highest level
+inline float FrameGovernor_Quality(const FrameGovernor* governor)
+{
+	return (float)(governor->level + 1) / GOVERNOR_LEVEL_COUNT;
+}
+
+#endif
@@ -0,0 +1,118 @@
+#include "gpu_sort.h"
+#include "common.h"
+
+static SDL_GPUComputePipeline* CreateSortPipeline(SDL_GPUDevice* device, const char* basePath, const char* shaderFilename, Uint32 readonlyStorageBuffers)
+{
+	SDL_GPUComputePipelineCreateInfo createInfo = {
+		.num_readonly_storage_buffers = readonlyStorageBuffers,
+		.num_readwrite_storage_buffers = 1,
+		.num_uniform_buffers = 1,
+		.threadcount_x = GPU_SORT_GROUP_SIZE,
+		.threadcount_y = 1,
+		.threadcount_z = 1,
+	};
+	return CreateComputePipelineFromShader(basePath, device, shaderFilename, &createInfo);
+}
+
+bool GpuDepthSort_Init(GpuDepthSort* sort, SDL_GPUDevice* device, const char* basePath, Uint32 capacity)
+{
+	SDL_zerop(sort);
+	sort->device = device;
+	sort->capacity = GPU_SORT_BLOCK_SIZE;
+	while (sort->capacity < capacity)
+	{
+		sort->capacity *= 2;
+	}
+
+	sort->keysPipeline = CreateSortPipeline(device, basePath, "SpriteSortKeys.comp", 1);
+	sort->localPipeline = CreateSortPipeline(device, basePath, "BitonicSortLocal.comp", 0);
+	sort->mergePipeline = CreateSortPipeline(device, basePath, "BitonicMerge.comp", 0);
+	if (sort->keysPipeline == NULL || sort->localPipeline == NULL || sort->mergePipeline == NULL)
+	{
+		return false;
+	}
+
+	SDL_GPUBufferCreateInfo bufferCreateInfo = {
+		.usage = SDL_GPU_BUFFERUSAGE_COMPUTE_STORAGE_READ | SDL_GPU_BUFFERUSAGE_COMPUTE_STORAGE_WRITE | SDL_GPU_BUFFERUSAGE_GRAPHICS_STORAGE_READ,
+		.size = sort->capacity * (Uint32)sizeof(Uint32) * 2
+	};
+	sort->keys = SDL_CreateGPUBuffer(device, &bufferCreateInfo);
+	if (sort->keys == NULL)
+	{
+		SDL_Log("Failed to create sort key buffer: %s", SDL_GetError());
+		return false;
+	}
+	return true;
+}
+
+void GpuDepthSort_Release(GpuDepthSort* sort)
+{
+	SDL_ReleaseGPUComputePipeline(sort->device, sort->keysPipeline);
+	SDL_ReleaseGPUComputePipeline(sort->device, sort->localPipeline);
+	SDL_ReleaseGPUComputePipeline(sort->device, sort->mergePipeline);
+	SDL_ReleaseGPUBuffer(sort->device, sort->keys);
+	sort->keysPipeline = NULL;
+	sort->localPipeline = NULL;
+	sort->mergePipeline = NULL;
+	sort->keys = NULL;
+}
+
+// Every step reads what the one before wrote, and SDL only synchronizes
+// storage writes between passes, so each dispatch gets a pass of its own
+static void Dispatch(
+	GpuDepthSort* sort,
+	SDL_GPUCommandBuffer* cmdBuf,
+	SDL_GPUComputePipeline* pipeline,
+	SDL_GPUBuffer* input,
+	const GpuSortUniforms* uniforms,
+	Uint32 groups
+) {
+	const SDL_GPUStorageBufferReadWriteBinding keysBinding = {
+		.buffer = sort->keys,
+		.cycle = false
+	};
+	SDL_GPUComputePass* computePass = SDL_BeginGPUComputePass(cmdBuf, NULL, 0, &keysBinding, 1);
+	SDL_BindGPUComputePipeline(computePass, pipeline);
+	if (input != NULL)
+	{
+		SDL_BindGPUComputeStorageBuffers(computePass, 0, &input, 1);
+	}
+	SDL_PushGPUComputeUniformData(cmdBuf, 0, uniforms, sizeof(GpuSortUniforms));
+	SDL_DispatchGPUCompute(computePass, groups, 1, 1);
+	SDL_EndGPUComputePass(computePass);
+}
+
+void GpuDepthSort_Record(GpuDepthSort* sort, SDL_GPUCommandBuffer* cmdBuf, const SpriteLayer* layer)
+{
+	SDL_assert(layer->instanceSize == sizeof(SpriteInstance));
+	SDL_assert(layer->count <= sort->capacity);
+	if (layer->count == 0)
+	{
+		return;
+	}
+
+	GpuSortUniforms uniforms = {
+		.count = layer->count,
+		.paddedCount = GPU_SORT_BLOCK_SIZE,
+	};
+	while (uniforms.paddedCount < layer->count)
+	{
+		uniforms.paddedCount *= 2;
+	}
+	const Uint32 blocks = uniforms.paddedCount / GPU_SORT_BLOCK_SIZE;
+
+	Dispatch(sort, cmdBuf, sort->keysPipeline, layer->buffer, &uniforms, uniforms.paddedCount / GPU_SORT_GROUP_SIZE);
+	Dispatch(sort, cmdBuf, sort->localPipeline, NULL, &uniforms, blocks);
+
+	// Merges of sequences longer than a block compare across blocks until the
+	// distance fits in one, and finish in shared memory from there
+	for (uniforms.k = GPU_SORT_BLOCK_SIZE * 2; uniforms.k <= uniforms.paddedCount; uniforms.k *= 2)
+	{
+		for (uniforms.j = uniforms.k / 2; uniforms.j >= GPU_SORT_BLOCK_SIZE; uniforms.j /= 2)
+		{
+			Dispatch(sort, cmdBuf, sort->mergePipeline, NULL, &uniforms, blocks);
+		}
+		uniforms.j = 0;
+		Dispatch(sort, cmdBuf, sort->localPipeline, NULL, &uniforms, blocks);
+	}
+}
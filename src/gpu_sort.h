@@ -0,0 +1,52 @@
+#pragma once
+#ifndef SDL_SAMPLE_GPU_SORT_H
+#define SDL_SAMPLE_GPU_SORT_H
+
+#include <SDL3/SDL.h>
+#include "sprite_layer.h"
+
+// Mirrors SORT_GROUP_SIZE in SpriteSort.hlsli. Each group sorts blocks of
+// twice as many keys in shared memory. 128 threads is all a Vulkan device,
+// Android ones included, is guaranteed to run in one group.
+#define GPU_SORT_GROUP_SIZE 128
+#define GPU_SORT_BLOCK_SIZE (GPU_SORT_GROUP_SIZE * 2)
+
+// Mirrors SortBlock in SpriteSort.hlsli
+typedef struct GpuSortUniforms
+{
+	Uint32 count;
+	Uint32 paddedCount;
+	Uint32 k;
+	Uint32 j;
+} GpuSortUniforms;
+
+// Orders a layer's sprites back to front by depth on the GPU, for translucent
+// sprites that have to blend in order. The sprites stay where they are: a
+// buffer of (key, index) pairs is sorted instead, and SPRITE_FEATURE_SORTED
+// pipelines read each sprite through it.
+//
+// A bitonic sort over the keys padded to a power of two. Blocks of
+// GPU_SORT_BLOCK_SIZE keys are sorted and merged in shared memory, only the
+// merge steps across blocks go through memory, so n keys take one dispatch
+// per step for log2(n / GPU_SORT_BLOCK_SIZE) * (log2(n / GPU_SORT_BLOCK_SIZE) + 3) / 2
+// + 2 steps. Nothing comes back to the CPU.
+typedef struct GpuDepthSort
+{
+	SDL_GPUDevice* device;
+	SDL_GPUComputePipeline* keysPipeline;
+	SDL_GPUComputePipeline* localPipeline;
+	SDL_GPUComputePipeline* mergePipeline;
+	SDL_GPUBuffer* keys;
+	Uint32 capacity;  // keys, a power of two
+} GpuDepthSort;
+
+// Sorts layers of up to `capacity` SpriteInstance records
+bool GpuDepthSort_Init(GpuDepthSort* sort, SDL_GPUDevice* device, const char* basePath, Uint32 capacity);
+void GpuDepthSort_Release(GpuDepthSort* sort);
+
+// Records the sort of the layer's current instances into sort->keys, in
+// compute passes of their own. Goes after the layer's upload and before the
+// render pass that draws it with SpriteLayer_DrawSorted.
+void GpuDepthSort_Record(GpuDepthSort* sort, SDL_GPUCommandBuffer* cmdBuf, const SpriteLayer* layer);
+
+#endif
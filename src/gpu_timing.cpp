@@ -0,0 +1,131 @@
+#include "gpu_timing.h"
+
+static int WaiterThread(void* data)
+{
+	GpuFrameTimer* timer = (GpuFrameTimer*)data;
+	SDL_LockMutex(timer->lock);
+	for (;;)
+	{
+		while (!timer->quit && timer->waitedCount == timer->pendingCount)
+		{
+			SDL_WaitCondition(timer->submitted, timer->lock);
+		}
+		if (timer->quit)
+		{
+			break;
+		}
+
+		// Only Poll removes fences, and only the ones already waited on, so this one stays put
+		SDL_GPUFence* fence = timer->pending[timer->waitedCount].fence;
+		SDL_UnlockMutex(timer->lock);
+		SDL_WaitForGPUFences(timer->device, true, &fence, 1);
+		const Uint64 completeNS = SDL_GetTicksNS();
+		SDL_LockMutex(timer->lock);
+		timer->pending[timer->waitedCount].completeNS = completeNS;
+		timer->waitedCount += 1;
+	}
+	SDL_UnlockMutex(timer->lock);
+	return 0;
+}
+
+bool GpuFrameTimer_Init(GpuFrameTimer* timer, SDL_GPUDevice* device)
+{
+	SDL_zerop(timer);
+	timer->device = device;
+	timer->lock = SDL_CreateMutex();
+	timer->submitted = SDL_CreateCondition();
+	if (timer->lock == NULL || timer->submitted == NULL)
+	{
+		SDL_Log("Failed to create GPU timer lock: %s", SDL_GetError());
+		GpuFrameTimer_Release(timer);
+		return false;
+	}
+	timer->waiter = SDL_CreateThread(WaiterThread, "gpu fence wait", timer);
+	if (timer->waiter == NULL)
+	{
+		SDL_Log("Failed to start GPU timer thread: %s", SDL_GetError());
+		GpuFrameTimer_Release(timer);
+		return false;
+	}
+	return true;
+}
+
+void GpuFrameTimer_Release(GpuFrameTimer* timer)
+{
+	if (timer->waiter != NULL)
+	{
+		SDL_LockMutex(timer->lock);
+		timer->quit = true;
+		SDL_SignalCondition(timer->submitted);
+		SDL_UnlockMutex(timer->lock);
+		SDL_WaitThread(timer->waiter, NULL);
+		timer->waiter = NULL;
+	}
+
+	for (Uint32 i = 0; i < timer->pendingCount; i += 1)
+	{
+		SDL_WaitForGPUFences(timer->device, true, &timer->pending[i].fence, 1);
+		SDL_ReleaseGPUFence(timer->device, timer->pending[i].fence);
+	}
+	timer->pendingCount = 0;
+	timer->waitedCount = 0;
+	SDL_DestroyCondition(timer->submitted);
+	timer->submitted = NULL;
+	SDL_DestroyMutex(timer->lock);
+	timer->lock = NULL;
+}
+
+bool GpuFrameTimer_Submit(GpuFrameTimer* timer, SDL_GPUCommandBuffer* cmdBuf, Uint64 frame)
+{
+	GpuFrameTimer_Poll(timer);
+	if (timer->pendingCount == GPU_FRAME_TIMER_MAX_PENDING)
+	{
+		// a frame that can't be timed still completes the ones before it, so nothing is lost but its sample
+		return SDL_SubmitGPUCommandBuffer(cmdBuf);
+	}
+
+	const Uint64 submitNS = SDL_GetTicksNS();
+	SDL_GPUFence* fence = SDL_SubmitGPUCommandBufferAndAcquireFence(cmdBuf);
+	if (fence == NULL)
+	{
+		SDL_Log("SubmitGPUCommandBufferAndAcquireFence failed: %s", SDL_GetError());
+		return false;
+	}
+	SDL_LockMutex(timer->lock);
+	timer->pending[timer->pendingCount] = GpuFrameFence{
+		.fence = fence,
+		.frame = frame,
+		.submitNS = submitNS
+	};
+	timer->pendingCount += 1;
+	SDL_SignalCondition(timer->submitted);
+	SDL_UnlockMutex(timer->lock);
+	return true;
+}
+
+Uint32 GpuFrameTimer_Poll(GpuFrameTimer* timer)
+{
+	SDL_LockMutex(timer->lock);
+	// In submission order, so the fences waited on are always the first ones
+	const Uint32 done = timer->waitedCount;
+	for (Uint32 i = 0; i < done; i += 1)
+	{
+		const GpuFrameFence* pending = &timer->pending[i];
+		// Until the frame before it finished, the GPU was busy with that one
+		const Uint64 startNS = SDL_max(pending->submitNS, timer->lastCompleteNS);
+		timer->latestMs = (float)(pending->completeNS - SDL_min(startNS, pending->completeNS)) / SDL_NS_PER_MS;
+		timer->lastCompleteNS = pending->completeNS;
+		timer->completedFrames = pending->frame + 1;
+		RollingStats_Add(&timer->completionMs, timer->latestMs);
+		SDL_ReleaseGPUFence(timer->device, pending->fence);
+	}
+
+	if (done > 0)
+	{
+		SDL_memmove(timer->pending, timer->pending + done, (timer->pendingCount - done) * sizeof(GpuFrameFence));
+		timer->pendingCount -= done;
+		timer->waitedCount = 0;
+	}
+	SDL_UnlockMutex(timer->lock);
+	return done;
+}
@@ -0,0 +1,58 @@
+#pragma once
+#ifndef SDL_SAMPLE_GPU_TIMING_H
+#define SDL_SAMPLE_GPU_TIMING_H
+
+#include <SDL3/SDL.h>
+#include "frame_stats.h"
+
+// Frames whose fences can be outstanding at once, comfortably more than SDL
+// ever keeps in flight
+#define GPU_FRAME_TIMER_MAX_PENDING 8
+
+typedef struct GpuFrameFence
+{
+	SDL_GPUFence* fence;
+	Uint64 frame;
+	Uint64 submitNS;
+	Uint64 completeNS;  // set by the waiter thread
+} GpuFrameFence;
+
+// Times each frame on the GPU by submitting it with a fence. A thread waits on
+// the fences one after the other and notes when each one signals, so the time
+// doesn't depend on when the main thread gets around to looking. SDL_GPU has
+// no timestamp queries, so a frame's GPU time is taken from when the GPU could
+// start on it, its submit or the previous frame finishing, whichever is later,
+// to when it finished.
+//
+// Command buffers complete in submission order, so the timer also knows the
+// newest frame the GPU is done with, for anything else waiting on a frame.
+typedef struct GpuFrameTimer
+{
+	SDL_GPUDevice* device;
+	SDL_Thread* waiter;
+	SDL_Mutex* lock;            // guards pending, pendingCount, waitedCount and quit
+	SDL_Condition* submitted;   // wakes the waiter when there is a fence to wait on
+	GpuFrameFence pending[GPU_FRAME_TIMER_MAX_PENDING];  // oldest first
+	Uint32 pendingCount;
+	Uint32 waitedCount;         // the first pending fences that have signaled
+	bool quit;
+	Uint64 completedFrames;     // frames before this one are done on the GPU
+	Uint64 lastCompleteNS;
+	float latestMs;             // of the newest completed frame, 0 before the first
+	RollingStats completionMs;
+} GpuFrameTimer;
+
+bool GpuFrameTimer_Init(GpuFrameTimer* timer, SDL_GPUDevice* device);
+// Waits for the pending frames, so their resources can be released after it
+void GpuFrameTimer_Release(GpuFrameTimer* timer);
+
+// Submits the command buffer with a fence, to be timed as `frame`. Frame
+// numbers must increase from one submit to the next.
+bool GpuFrameTimer_Submit(GpuFrameTimer* timer, SDL_GPUCommandBuffer* cmdBuf, Uint64 frame);
+
+// Records the frames that finished since the last poll. The times were taken
+// when the frames finished, so how often this is called doesn't change them.
+// Returns the number of frames that finished.
+Uint32 GpuFrameTimer_Poll(GpuFrameTimer* timer);
+
+#endif
@@ -0,0 +1,268 @@
+#include "image_loader.h"
+#include "cooked_texture.h"
+#include "trace.h"
+#include <SDL3_image/SDL_image.h>
+
+// QOI, see qoiformat.org: a 14-byte header, chunks of 1 to 5 bytes, then
+// 7 zero bytes and a one
+#define QOI_HEADER_SIZE 14
+#define QOI_END_SIZE 8
+#define QOI_OP_INDEX 0x00
+#define QOI_OP_DIFF 0x40
+#define QOI_OP_LUMA 0x80
+#define QOI_OP_RUN 0xC0
+#define QOI_OP_RGB 0xFE
+#define QOI_OP_RGBA 0xFF
+#define QOI_MASK_2 0xC0
+// The limit the reference decoder sets, far beyond any texture
+#define QOI_MAX_PIXELS 400000000
+
+ImageFormat Image_DetectFormat(const void* data, size_t size)
+{
+	static const Uint8 pngSignature[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+	const Uint8* bytes = (const Uint8*)data;
+	if (size >= 2 && bytes[0] == 'B' && bytes[1] == 'M')
+	{
+		return IMAGE_FORMAT_BMP;
+	}
+	if (size >= sizeof(pngSignature) && SDL_memcmp(bytes, pngSignature, sizeof(pngSignature)) == 0)
+	{
+		return IMAGE_FORMAT_PNG;
+	}
+	if (size >= 4 && SDL_memcmp(bytes, "qoif", 4) == 0)
+	{
+		return IMAGE_FORMAT_QOI;
+	}
+	// COOKED_TEXTURE_MAGIC as stored
+	if (size >= 4 && SDL_memcmp(bytes, "GTEX", 4) == 0)
+	{
+		return IMAGE_FORMAT_COOKED;
+	}
+	return IMAGE_FORMAT_UNKNOWN;
+}
+
+static Uint32 ReadBigEndian32(const Uint8* bytes)
+{
+	return ((Uint32)bytes[0] << 24) | ((Uint32)bytes[1] << 16) | ((Uint32)bytes[2] << 8) | bytes[3];
+}
+
+static SDL_Surface* DecodeQOI(const Uint8* bytes, size_t size)
+{
+	if (size < QOI_HEADER_SIZE + QOI_END_SIZE)
+	{
+		SDL_SetError("QOI data is truncated");
+		return NULL;
+	}
+	const Uint32 width = ReadBigEndian32(bytes + 4);
+	const Uint32 height = ReadBigEndian32(bytes + 8);
+	if (width == 0 || height == 0 || (Uint64)width * height > QOI_MAX_PIXELS)
+	{
+		SDL_SetError("QOI image is %ux%u", width, height);
+		return NULL;
+	}
+	SDL_Surface* surface = SDL_CreateSurface((int)width, (int)height, SDL_PIXELFORMAT_ABGR8888);
+	if (surface == NULL)
+	{
+		return NULL;
+	}
+
+	// Chunks never reach into the end marker, so reading one never runs off the data
+	Uint8 seen[64][4] = {};
+	Uint8 pixel[4] = { 0, 0, 0, 255 };
+	Uint32 run = 0;
+	size_t p = QOI_HEADER_SIZE;
+	const size_t chunksEnd = size - QOI_END_SIZE;
+	for (Uint32 y = 0; y < height; y += 1)
+	{
+		Uint8* row = (Uint8*)surface->pixels + (size_t)y * surface->pitch;
+		for (Uint32 x = 0; x < width; x += 1)
+		{
+			if (run > 0)
+			{
+				run -= 1;
+			}
+			else if (p < chunksEnd)
+			{
+				const Uint8 op = bytes[p++];
+				if (op == QOI_OP_RGB)
+				{
+					pixel[0] = bytes[p + 0];
+					pixel[1] = bytes[p + 1];
+					pixel[2] = bytes[p + 2];
+					p += 3;
+				}
+				else if (op == QOI_OP_RGBA)
+				{
+					SDL_memcpy(pixel, bytes + p, 4);
+					p += 4;
+				}
+				else if ((op & QOI_MASK_2) == QOI_OP_INDEX)
+				{
+					SDL_memcpy(pixel, seen[op], 4);
+				}
+				else if ((op & QOI_MASK_2) == QOI_OP_DIFF)
+				{
+					pixel[0] += ((op >> 4) & 0x03) - 2;
+					pixel[1] += ((op >> 2) & 0x03) - 2;
+					pixel[2] += (op & 0x03) - 2;
+				}
+				else if ((op & QOI_MASK_2) == QOI_OP_LUMA)
+				{
+					const Uint8 next = bytes[p++];
+					const int greenDiff = (op & 0x3F) - 32;
+					pixel[0] += greenDiff - 8 + ((next >> 4) & 0x0F);
+					pixel[1] += greenDiff;
+					pixel[2] += greenDiff - 8 + (next & 0x0F);
+				}
+				else
+				{
+					run = op & 0x3F;
+				}
+				SDL_memcpy(seen[(pixel[0] * 3 + pixel[1] * 5 + pixel[2] * 7 + pixel[3] * 11) % 64], pixel, 4);
+			}
+			SDL_memcpy(row + x * 4, pixel, 4);
+		}
+	}
+	return surface;
+}
+
+// The first level of a cooked texture, if it is in the layout surfaces use
+static SDL_Surface* DecodeCooked(const Uint8* bytes, size_t size, const char* name)
+{
+	SDL_GPUTextureCreateInfo createInfo;
+	Uint32 flags;
+	if (!CookedTexture_Parse(bytes, size, name, &createInfo, &flags))
+	{
+		SDL_SetError("not a valid cooked texture");
+		return NULL;
+	}
+	if (createInfo.format != SDL_GPU_TEXTUREFORMAT_R8G8B8A8_UNORM || (flags & COOKED_TEXTURE_PREMULTIPLIED) != 0)
+	{
+		SDL_SetError("cooked for the GPU only, format %u with flags %u", createInfo.format, flags);
+		return NULL;
+	}
+	SDL_Surface* surface = SDL_CreateSurface((int)createInfo.width, (int)createInfo.height, SDL_PIXELFORMAT_ABGR8888);
+	if (surface == NULL)
+	{
+		return NULL;
+	}
+	const Uint8* pixels = bytes + sizeof(CookedTextureHeader);
+	for (Uint32 y = 0; y < createInfo.height; y += 1)
+	{
+		SDL_memcpy((Uint8*)surface->pixels + (size_t)y * surface->pitch, pixels + (size_t)y * createInfo.width * 4, createInfo.width * 4);
+	}
+	return surface;
+}
+
+SDL_Surface* Image_Decode(const void* data, size_t size, const char* name)
+{
+	SDL_Surface* surface = NULL;
+	switch (Image_DetectFormat(data, size))
+	{
+	case IMAGE_FORMAT_BMP:
+		// SDL_image is built without BMP, SDL reads it itself
+		surface = SDL_LoadBMP_IO(SDL_IOFromConstMem(data, size), true);
+		break;
+	case IMAGE_FORMAT_QOI:
+		surface = DecodeQOI((const Uint8*)data, size);
+		break;
+	case IMAGE_FORMAT_COOKED:
+		surface = DecodeCooked((const Uint8*)data, size, name);
+		break;
+	case IMAGE_FORMAT_PNG:
+	case IMAGE_FORMAT_UNKNOWN:
+		surface = IMG_Load_IO(SDL_IOFromConstMem(data, size), true);
+		break;
+	}
+
+	if (surface != NULL && surface->format != SDL_PIXELFORMAT_ABGR8888)
+	{
+		SDL_Surface* converted = SDL_ConvertSurface(surface, SDL_PIXELFORMAT_ABGR8888);
+		SDL_DestroySurface(surface);
+		surface = converted;
+	}
+	if (surface == NULL)
+	{
+		SDL_Log("Failed to decode %s: %s", name, SDL_GetError());
+	}
+	return surface;
+}
+
+SDL_Surface* Image_Load(const char* path)
+{
+	size_t size = 0;
+	void* data = SDL_LoadFile(path, &size);
+	if (data == NULL)
+	{
+		SDL_Log("Failed to load %s: %s", path, SDL_GetError());
+		return NULL;
+	}
+	SDL_Surface* surface = Image_Decode(data, size, path);
+	SDL_free(data);
+	return surface;
+}
+
+typedef struct ImageDecodeBatch
+{
+	const ImageSource* sources;
+	SDL_Surface** surfaces;
+	Uint32 count;
+	SDL_AtomicInt next;
+} ImageDecodeBatch;
+
+// Takes the next image until none are left, so large and small images even out
+static void DecodeImages(ImageDecodeBatch* batch)
+{
+	for (;;)
+	{
+		const Uint32 i = (Uint32)SDL_AddAtomicInt(&batch->next, 1);
+		if (i >= batch->count)
+		{
+			return;
+		}
+		Trace_Begin("image decode");
+		batch->surfaces[i] = Image_Decode(batch->sources[i].data, batch->sources[i].size, batch->sources[i].name);
+		Trace_End();
+	}
+}
+
+static int DecodeWorker(void* userdata)
+{
+	Trace_SetThreadName("image decode worker");
+	DecodeImages((ImageDecodeBatch*)userdata);
+	return 0;
+}
+
+void Image_DecodeBatch(const ImageSource* sources, SDL_Surface** surfaces, Uint32 count, Uint32 threadCount)
+{
+	if (threadCount == 0)
+	{
+		threadCount = (Uint32)SDL_max(SDL_GetNumLogicalCPUCores(), 1);
+	}
+	threadCount = SDL_min(SDL_min(threadCount, count), IMAGE_MAX_THREADS);
+
+	ImageDecodeBatch batch = {
+		.sources = sources,
+		.surfaces = surfaces,
+		.count = count,
+	};
+	SDL_SetAtomicInt(&batch.next, 0);
+
+	// Threads only live for the batch, loads come in bursts far apart.
+	// Any that can't be started leave their share to the others.
+	SDL_Thread* threads[IMAGE_MAX_THREADS];
+	Uint32 started = 0;
+	for (Uint32 i = 1; i < threadCount; i += 1)
+	{
+		threads[started] = SDL_CreateThread(DecodeWorker, "image decode", &batch);
+		if (threads[started] != NULL)
+		{
+			started += 1;
+		}
+	}
+	DecodeImages(&batch);
+	for (Uint32 i = 0; i < started; i += 1)
+	{
+		SDL_WaitThread(threads[i], NULL);
+	}
+}
@@ -0,0 +1,45 @@
+#pragma once
+#ifndef SDL_SAMPLE_IMAGE_LOADER_H
+#define SDL_SAMPLE_IMAGE_LOADER_H
+
+#include <SDL3/SDL.h>
+
+#define IMAGE_MAX_THREADS 16
+
+// Recognized by their first bytes, whatever the file is called
+typedef enum ImageFormat
+{
+	IMAGE_FORMAT_UNKNOWN,  // left to SDL_image to recognize
+	IMAGE_FORMAT_BMP,
+	IMAGE_FORMAT_PNG,
+	IMAGE_FORMAT_QOI,
+	IMAGE_FORMAT_COOKED    // see cooked_texture.h
+} ImageFormat;
+
+// An encoded image in memory, for Image_DecodeBatch
+typedef struct ImageSource
+{
+	const void* data;
+	size_t size;
+	const char* name;  // for error messages
+} ImageSource;
+
+ImageFormat Image_DetectFormat(const void* data, size_t size);
+
+// The one way images are read. BMP goes through SDL itself and QOI through
+// the decoder here, straight into the final format. PNG and anything else
+// SDL_image knows go through SDL_image. Cooked textures in plain R8G8B8A8 with
+// straight alpha are copied out as they are, other cooked formats are only
+// for the GPU and fail here. Every image comes back as a
+// 4-channel SDL_PIXELFORMAT_ABGR8888 surface, or NULL after logging why.
+// Safe to call from any thread.
+SDL_Surface* Image_Decode(const void* data, size_t size, const char* name);
+SDL_Surface* Image_Load(const char* path);
+
+// Decodes `count` images at once, one per job, spread over threadCount
+// threads including the caller's. 0 picks one per logical core. Decoding
+// dominates loading a large set of PNGs, so this scales with the cores.
+// surfaces[i] is NULL for each image that failed.
+void Image_DecodeBatch(const ImageSource* sources, SDL_Surface** surfaces, Uint32 count, Uint32 threadCount);
+
+#endif
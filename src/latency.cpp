@@ -0,0 +1,47 @@
+#include "latency.h"
+
+static bool IsInput(Uint32 type)
+{
+	return type == SDL_EVENT_MOUSE_MOTION || type == SDL_EVENT_MOUSE_BUTTON_DOWN || type == SDL_EVENT_KEY_DOWN;
+}
+
+void LatencyProbe_OnEvent(LatencyProbe* probe, const SDL_Event* event)
+{
+	const Uint64 timestampNS = event->common.timestamp;
+	if (!IsInput(event->type) || timestampNS <= probe->sampledUntilNS)
+	{
+		return;
+	}
+	if (probe->pendingInputNS == 0 || timestampNS < probe->pendingInputNS)
+	{
+		probe->pendingInputNS = timestampNS;
+	}
+}
+
+void LatencyProbe_PeekQueuedInput(LatencyProbe* probe)
+{
+	// Keys come before the mouse among the event types, the range also holds events that don't count
+	SDL_Event events[64];
+	const int count = SDL_PeepEvents(events, SDL_arraysize(events), SDL_PEEKEVENT, SDL_EVENT_KEY_DOWN, SDL_EVENT_MOUSE_BUTTON_DOWN);
+	for (int i = 0; i < count; i += 1)
+	{
+		LatencyProbe_OnEvent(probe, &events[i]);
+	}
+}
+
+void LatencyProbe_MarkSampled(LatencyProbe* probe, Uint64 nowNS)
+{
+	probe->frameInputNS = probe->pendingInputNS;
+	probe->pendingInputNS = 0;
+	probe->sampledUntilNS = nowNS;
+}
+
+void LatencyProbe_OnSubmit(LatencyProbe* probe, Uint64 nowNS)
+{
+	if (probe->frameInputNS == 0)
+	{
+		return;
+	}
+	RollingStats_Add(&probe->inputToSubmit, (float)(nowNS - probe->frameInputNS) / SDL_NS_PER_MS);
+	probe->frameInputNS = 0;
+}
@@ -0,0 +1,30 @@
+#pragma once
+#ifndef SDL_SAMPLE_LATENCY_H
+#define SDL_SAMPLE_LATENCY_H
+
+#include <SDL3/SDL.h>
+#include "frame_stats.h"
+
+// Measures how long input waits before a frame showing it is handed to the GPU.
+// Each frame's sample is taken from the oldest input event that frame is the
+// first to reflect, so the statistics describe worst-case responsiveness.
+typedef struct LatencyProbe
+{
+	Uint64 pendingInputNS;   // oldest input not reflected in any frame yet, 0 if none
+	Uint64 frameInputNS;     // oldest input reflected in the frame being recorded
+	Uint64 sampledUntilNS;   // inputs older than this were already picked up
+	RollingStats inputToSubmit;
+} LatencyProbe;
+
+// Feed every event. Mouse motion, mouse clicks and key presses count as input.
+void LatencyProbe_OnEvent(LatencyProbe* probe, const SDL_Event* event);
+
+// Picks up input that was pumped but not yet dispatched to SDL_AppEvent, for
+// frames that sample the mouse late with SDL_PumpEvents.
+void LatencyProbe_PeekQueuedInput(LatencyProbe* probe);
+
+// Call at the point the frame reads input state, and again once it was submitted
+void LatencyProbe_MarkSampled(LatencyProbe* probe, Uint64 nowNS);
+void LatencyProbe_OnSubmit(LatencyProbe* probe, Uint64 nowNS);
+
+#endif
@@ -0,0 +1,144 @@
+#include "lighting.h"
+#include "common.h"
+
+// The shaders read both as laid out in HLSL, 16-byte aligned vectors and all
+static_assert(sizeof(PointLight) == 32);
+static_assert(sizeof(LightGridUniforms) == 32);
+
+bool LightGrid_Init(LightGrid* grid, SDL_GPUDevice* device, const char* basePath, Uint32 sceneWidth, Uint32 sceneHeight, Uint32 capacity, Uint32 maxPerTile)
+{
+	SDL_zerop(grid);
+	grid->device = device;
+	grid->capacity = capacity;
+	grid->uniforms.tilesX = (sceneWidth + LIGHT_TILE_SIZE - 1) / LIGHT_TILE_SIZE;
+	grid->uniforms.tilesY = (sceneHeight + LIGHT_TILE_SIZE - 1) / LIGHT_TILE_SIZE;
+	grid->uniforms.maxPerTile = maxPerTile;
+	grid->uniforms.ambient[0] = 0.15f;
+	grid->uniforms.ambient[1] = 0.15f;
+	grid->uniforms.ambient[2] = 0.2f;
+
+	SDL_GPUComputePipelineCreateInfo createInfo = {
+		.num_readonly_storage_buffers = 1,
+		.num_readwrite_storage_buffers = 1,
+		.num_uniform_buffers = 1,
+		.threadcount_x = LIGHT_CULL_GROUP_SIZE,
+		.threadcount_y = 1,
+		.threadcount_z = 1,
+	};
+	grid->cullPipeline = CreateComputePipelineFromShader(basePath, device, "LightCull.comp", &createInfo);
+	if (grid->cullPipeline == NULL)
+	{
+		return false;
+	}
+
+	SDL_GPUBufferCreateInfo lightsCreateInfo = {
+		.usage = SDL_GPU_BUFFERUSAGE_COMPUTE_STORAGE_READ | SDL_GPU_BUFFERUSAGE_GRAPHICS_STORAGE_READ,
+		.size = capacity * (Uint32)sizeof(PointLight)
+	};
+	SDL_GPUBufferCreateInfo tilesCreateInfo = {
+		.usage = SDL_GPU_BUFFERUSAGE_COMPUTE_STORAGE_WRITE | SDL_GPU_BUFFERUSAGE_GRAPHICS_STORAGE_READ,
+		.size = grid->uniforms.tilesX * grid->uniforms.tilesY * (maxPerTile + 1) * (Uint32)sizeof(Uint32)
+	};
+	grid->lights = SDL_CreateGPUBuffer(device, &lightsCreateInfo);
+	grid->tileLights = SDL_CreateGPUBuffer(device, &tilesCreateInfo);
+	if (grid->lights == NULL || grid->tileLights == NULL)
+	{
+		SDL_Log("Failed to create light grid buffers: %s", SDL_GetError());
+		return false;
+	}
+	return true;
+}
+
+void LightGrid_Release(LightGrid* grid)
+{
+	SDL_ReleaseGPUComputePipeline(grid->device, grid->cullPipeline);
+	SDL_ReleaseGPUBuffer(grid->device, grid->lights);
+	SDL_ReleaseGPUBuffer(grid->device, grid->tileLights);
+	grid->cullPipeline = NULL;
+	grid->lights = NULL;
+	grid->tileLights = NULL;
+}
+
+PointLight* LightGrid_QueueLights(LightGrid* grid, UploadScheduler* uploads, Uint32 count)
+{
+	SDL_assert(count <= grid->capacity);
+	grid->uniforms.lightCount = count;
+	if (count == 0)
+	{
+		return NULL;
+	}
+	return (PointLight*)UploadScheduler_QueueBuffer(uploads, grid->lights, 0, count * (Uint32)sizeof(PointLight), UPLOAD_PRIORITY_VISIBLE);
+}
+
+void LightGrid_RecordCull(LightGrid* grid, SDL_GPUCommandBuffer* cmdBuf)
+{
+	// Every tile's list is rewritten, cycling lets the GPU start before the last frame's draws are done
+	const SDL_GPUStorageBufferReadWriteBinding tilesBinding = {
+		.buffer = grid->tileLights,
+		.cycle = true
+	};
+	SDL_GPUComputePass* computePass = SDL_BeginGPUComputePass(cmdBuf, NULL, 0, &tilesBinding, 1);
+	SDL_BindGPUComputePipeline(computePass, grid->cullPipeline);
+	SDL_BindGPUComputeStorageBuffers(computePass, 0, &grid->lights, 1);
+	SDL_PushGPUComputeUniformData(cmdBuf, 0, &grid->uniforms, sizeof(LightGridUniforms));
+	SDL_DispatchGPUCompute(computePass, grid->uniforms.tilesX * grid->uniforms.tilesY, 1, 1);
+	SDL_EndGPUComputePass(computePass);
+}
+
+void LightGrid_Bind(const LightGrid* grid, SDL_GPUCommandBuffer* cmdBuf, SDL_GPURenderPass* renderPass)
+{
+	SDL_GPUBuffer* buffers[2] = { grid->lights, grid->tileLights };
+	SDL_BindGPUFragmentStorageBuffers(renderPass, 0, buffers, 2);
+	SDL_PushGPUFragmentUniformData(cmdBuf, 0, &grid->uniforms, sizeof(LightGridUniforms));
+}
+
+SDL_Surface* LightGrid_CreateNormalMap(SDL_Surface* albedo, float strength)
+{
+	const int w = albedo->w;
+	const int h = albedo->h;
+	float* heights = (float*)SDL_malloc(sizeof(float) * w * h);
+	SDL_Surface* normals = SDL_CreateSurface(w, h, SDL_PIXELFORMAT_ABGR8888);
+	if (heights == NULL || normals == NULL)
+	{
+		SDL_Log("Failed to create normal map: %s", SDL_GetError());
+		SDL_free(heights);
+		SDL_DestroySurface(normals);
+		return NULL;
+	}
+
+	for (int y = 0; y < h; y += 1)
+	{
+		const Uint8* row = (const Uint8*)albedo->pixels + y * albedo->pitch;
+		for (int x = 0; x < w; x += 1)
+		{
+			const Uint8* texel = &row[x * 4];
+			const float brightness = (texel[0] * 0.3f + texel[1] * 0.59f + texel[2] * 0.11f) / 255.0f;
+			heights[y * w + x] = texel[3] / 255.0f * (0.5f + 0.5f * brightness);
+		}
+	}
+
+	// Central differences, clamped at the edges. The normals are in the atlas'
+	// own axes, x right, y down and z out of the screen.
+	for (int y = 0; y < h; y += 1)
+	{
+		Uint8* row = (Uint8*)normals->pixels + y * normals->pitch;
+		const int up = SDL_max(y - 1, 0) * w;
+		const int down = SDL_min(y + 1, h - 1) * w;
+		for (int x = 0; x < w; x += 1)
+		{
+			const int left = SDL_max(x - 1, 0);
+			const int right = SDL_min(x + 1, w - 1);
+			const float dx = (heights[y * w + right] - heights[y * w + left]) * strength;
+			const float dy = (heights[down + x] - heights[up + x]) * strength;
+			const float length = SDL_sqrtf(dx * dx + dy * dy + 1.0f);
+			Uint8* texel = &row[x * 4];
+			texel[0] = (Uint8)((-dx / length * 0.5f + 0.5f) * 255.0f + 0.5f);
+			texel[1] = (Uint8)((-dy / length * 0.5f + 0.5f) * 255.0f + 0.5f);
+			texel[2] = (Uint8)((1.0f / length * 0.5f + 0.5f) * 255.0f + 0.5f);
+			texel[3] = 255;
+		}
+	}
+
+	SDL_free(heights);
+	return normals;
+}
@@ -0,0 +1,77 @@
+#pragma once
+#ifndef SDL_SAMPLE_LIGHTING_H
+#define SDL_SAMPLE_LIGHTING_H
+
+#include <SDL3/SDL.h>
+#include "upload_scheduler.h"
+
+// Mirrors LIGHT_TILE_SIZE in SpriteLighting.hlsli
+#define LIGHT_TILE_SIZE 32
+// How many lights a tile's list holds unless told otherwise. Lights beyond the
+// maximum that reach a tile are dropped from it. 1000 lights over the 640x480
+// scene put up to about 55 on one tile, this leaves room for twice that.
+#define LIGHT_DEFAULT_MAX_PER_TILE 127
+// Mirrors LIGHT_CULL_GROUP_SIZE in LightCull.comp.hlsl
+#define LIGHT_CULL_GROUP_SIZE 64
+
+// Mirrors PointLight in SpriteLighting.hlsli
+typedef struct PointLight
+{
+	float x, y;
+	float height;  // above the sprites, which lights them from the side
+	float radius;  // no light at all beyond this
+	float r, g, b;
+	float intensity;
+} PointLight;
+
+// Mirrors LightGridBlock in LightCull.comp.hlsl and TexturedQuadColor.frag.hlsl
+typedef struct LightGridUniforms
+{
+	Uint32 lightCount;
+	Uint32 tilesX;
+	Uint32 tilesY;
+	Uint32 maxPerTile;
+	float ambient[3];
+	float padding2;
+} LightGridUniforms;
+
+// Point lights for SPRITE_FEATURE_LIT sprites, binned into screen tiles on the
+// GPU every frame. The culling pass gives each LIGHT_TILE_SIZE tile a list of
+// the lights whose radius reaches it, so a lit fragment only loops over the
+// lights near it, not all of them.
+//
+// Tiles cover the scene in the coordinates sprites are placed in, which stay
+// the same whatever the window size or render resolution.
+typedef struct LightGrid
+{
+	SDL_GPUDevice* device;
+	SDL_GPUComputePipeline* cullPipeline;
+	SDL_GPUBuffer* lights;
+	SDL_GPUBuffer* tileLights;  // per tile a count, then that many light indices
+	Uint32 capacity;
+	LightGridUniforms uniforms;
+} LightGrid;
+
+// Covers a sceneWidth x sceneHeight scene with tiles, for up to `capacity`
+// lights and at most maxPerTile of them on each tile
+bool LightGrid_Init(LightGrid* grid, SDL_GPUDevice* device, const char* basePath, Uint32 sceneWidth, Uint32 sceneHeight, Uint32 capacity, Uint32 maxPerTile);
+void LightGrid_Release(LightGrid* grid);
+
+// Replaces the lights with `count` new ones, which the caller writes to the
+// returned memory before the next call into the scheduler
+PointLight* LightGrid_QueueLights(LightGrid* grid, UploadScheduler* uploads, Uint32 count);
+
+// Records the culling pass, after the lights' upload and before the render
+// pass that draws lit sprites
+void LightGrid_RecordCull(LightGrid* grid, SDL_GPUCommandBuffer* cmdBuf);
+
+// Binds the lights and tile lists for the lit sprite shaders, which also need
+// the normal map bound as their second sampler
+void LightGrid_Bind(const LightGrid* grid, SDL_GPUCommandBuffer* cmdBuf, SDL_GPURenderPass* renderPass);
+
+// ravioli_atlas.bmp has no hand-made normal map, so one is derived from it:
+// coverage and brightness stand in for height, and the normals follow their
+// slopes. Takes and returns 4-channel surfaces, or NULL on failure.
+SDL_Surface* LightGrid_CreateNormalMap(SDL_Surface* albedo, float strength);
+
+#endif
@@ -5,9 +5,33 @@
 #include <SDL3_mixer/SDL_mixer.h>
 #include <SDL3_image/SDL_image.h>
 #include <cmath>
-#include <string_view>
 #include <filesystem>
 #include "common.h"
+#include "flipbook.h"
+#include "sprite_layer.h"
+#include "tilemap.h"
+#include "nine_slice.h"
+#include "options.h"
+#include "latency.h"
+#include "governor.h"
+#include "damage.h"
+#include "dynamic_resolution.h"
+#include "frame_stats.h"
+#include "sprite_permutations.h"
+#include "upload_scheduler.h"
+#include "texture_residency.h"
+#include "virtual_texture.h"
+#include "sprite_picking.h"
+#include "broadphase.h"
+#include "random_stream.h"
+#include "ecs.h"
+#include "trace.h"
+#include "gpu_timing.h"
+#include "gpu_sort.h"
+#include "lighting.h"
+#include "sdf_font.h"
+#include "image_loader.h"
+#include <vector>
 
 constexpr uint32_t windowStartWidth = 640;
 constexpr uint32_t windowStartHeight = 480;
@@ -23,23 +47,504 @@ struct AppContext {
     SDL_AppResult app_quit = SDL_APP_CONTINUE;
 };
 
-static SDL_GPUGraphicsPipeline* RenderPipeline;
+static SpritePipelineCache SpritePipelines;
+static SDL_GPUGraphicsPipeline* InstancedRenderPipeline;
+static SDL_GPUGraphicsPipeline* TilemapPipeline;
+static SDL_GPUGraphicsPipeline* NineSlicePipeline;
 static SDL_GPUSampler* Sampler;
-static SDL_GPUTexture* Texture;
-static SDL_GPUTransferBuffer* SpriteDataTransferBuffer;
-static SDL_GPUBuffer* SpriteDataBuffer;
-
-typedef struct SpriteInstance
+static SDL_GPUTexture* CursorTexture;
+static SpriteLayer StaticSprites;
+static SpriteLayer DynamicSprites;
+static FrameTable SpriteFrameTable;
+static Uint16 RavioliAnimation;
+static Tilemap Background;
+static SpriteLayer Panels;
+static SpriteLayer Cursor;
+static AppOptions Options;
+static LatencyProbe Latency;
+static Uint64 LastLatencyReportNS;
+static FrameGovernor Governor;
+static Uint64 FrameIndex;
+static DamageTracker Damage;
+static DynamicResolution Resolution;
+static UploadScheduler Uploads;
+static TextureResidency Residency;
+static Uint32 AtlasPage;
+static VirtualTexture VirtualSheet;
+static SpriteLayer VirtualSprites;
+static Uint64 VirtualShuffleNS;
+static SpritePicker Picker;
+static SpritePick HoveredSprite;
+static bool PickClickPending;
+static Uint64 PickClickFrame;
+static Broadphase Collision;
+static std::vector<SpriteInstance> CollisionSprites;
+static std::vector<float> CollisionVelocities;
+static RollingStats BroadphaseMs;
+static Uint64 LastCollisionStepNS;
+static Uint64 LastBroadphaseReportNS;
+static RandomStream SceneRandom;
+static EcsWorld World;
+static Uint32 SpriteComponent;
+static Uint32 VelocityComponent;
+static Uint32 SpinComponent;
+static std::vector<EcsEntity> EcsSprites;
+static Uint64 LastEcsStepNS;
+static Uint64 LastFrameStartNS;
+static bool UseInstancing;
+static Uint64 SpritePathSwitchNS;
+static RollingStats SpritePathFrameMs[2];
+static RollingStats SpritePathCpuMs[2];
+static RollingStats SpritePathGpuMs[2];
+static Uint64 SpritePathGpuFrames;
+static Uint64 SpritePathFirstFrame;  // the first frame measured for the current path
+static GpuFrameTimer GpuTimer;
+static GpuDepthSort DepthSort;
+static LightGrid Lights;
+static SDL_GPUTexture* NormalAtlas;
+static SdfFont Font;
+static SpriteLayer Text;
+static SDL_GPUSampler* TextSampler;
+
+typedef struct SpriteBatchUniforms
 {
-    float x, y, z;
-    float rotation;
-    float w, h, padding_a, padding_b;
-    float tex_u, tex_v, tex_w, tex_h;
-    float r, g, b, a;
-} SpriteInstance;
+    Matrix4x4 viewProjection;
+    float time;
+    float padding[3];
+} SpriteBatchUniforms;
 
 static const Uint32 SPRITE_COUNT = 8192;
+// Most sprites are scenery that never moves, only the rest is rewritten each frame
+static const Uint32 STATIC_SPRITE_COUNT = SPRITE_COUNT / 16 * 15;
+static const Uint32 DYNAMIC_SPRITE_COUNT = SPRITE_COUNT - STATIC_SPRITE_COUNT;
+
+static float uCoords[4] = { 0.0f, 0.5f, 0.0f, 0.5f };
+static float vCoords[4] = { 0.0f, 0.0f, 0.5f, 0.5f };
+static const Uint8 RAVIOLI_FPS = 8;
+
+// A million-tile background, scrolled behind the sprites
+static const Uint32 BACKGROUND_TILES = 1024;
+static const float BACKGROUND_TILE_SIZE = 16;
+static const float BACKGROUND_SCROLL_SPEED = 64;
+
+// UI panels, nine-sliced from the first ravioli in the atlas
+static const Uint32 PANEL_COUNT = 4;
+
+// Text at a range of sizes, all drawn from the one distance field atlas, and a line that zooms
+static const Uint32 TEXT_GLYPH_CAPACITY = 256;
+static const float TEXT_SIZES[5] = { 10, 16, 24, 36, 54 };
+static const float TEXT_ZOOM_MIN = 12;
+static const float TEXT_ZOOM_MAX = 120;
+static const char* TEXT_MESSAGE = "Hello SDL!";
+
+static const Uint64 LATENCY_REPORT_INTERVAL_NS = 2 * SDL_NS_PER_SECOND;
+
+// How many frames pass between re-randomizing the dynamic sprites, per governor level
+static const Uint32 DYNAMIC_UPDATE_INTERVALS[GOVERNOR_LEVEL_COUNT] = { 4, 3, 2, 1, 1 };
+
+// Upper bounds on sleeping between iterations, so quitting and audio stay responsive
+static const Sint32 PAUSED_WAIT_MS = 100;
+static const Uint64 IDLE_MAX_WAIT_NS = 250 * SDL_NS_PER_MS;
+
+// How long each sprite path runs before --benchmark-sprite-paths switches to the other
+static const Uint64 SPRITE_PATH_BENCHMARK_INTERVAL_NS = 5 * SDL_NS_PER_SECOND;
+// Left out after each switch: pipelines and caches warm up, and frames of the
+// old path are still finishing on the GPU
+static const Uint64 SPRITE_PATH_WARMUP_FRAMES = 30;
+static const char* SPRITE_PATH_NAMES[2] = { "pulling", "instanced" };
+
+// Shader features each layer needs on the pulling path. The raviolis are never
+// tinted, and the probe marker is neither rotated nor tinted.
+static const Uint32 SCENERY_FEATURES = SPRITE_FEATURE_ROTATION;
+static const Uint32 CURSOR_FEATURES = 0;
+static Uint32 StaticSpriteFeatures = SCENERY_FEATURES;
+static Uint32 DynamicSpriteFeatures = SCENERY_FEATURES;
+// Text is drawn from a distance field, in the instance color
+static const Uint32 TEXT_FEATURES = SPRITE_FEATURE_TINT | SPRITE_FEATURE_SDF;
+// Only the pulling shaders can read sort keys, lights or distance fields, layers with these are never instanced
+static const Uint32 PULLED_ONLY_FEATURES = SPRITE_FEATURE_SORTED | SPRITE_FEATURE_LIT | SPRITE_FEATURE_SDF;
+
+// --virtual-texture: a few sprites cut out of a 16384x16384 sheet that only
+// ever has a 2048x2048 cache in GPU memory. Each shows one page worth of
+// texels, and most straddle page corners, so 48 of them need at most 192 pages.
+static const Uint32 VIRTUAL_SHEET_SIZE = 16384;
+static const Uint32 VIRTUAL_CACHE_SIZE = 2048;
+static const Uint32 VIRTUAL_LOADS_PER_FRAME = 8;
+static const Uint32 VIRTUAL_SPRITE_COUNT = 48;
+static const float VIRTUAL_SPRITE_SIZE = 48;
+static const Uint32 VIRTUAL_SHUFFLE_COUNT = 8;
+static const Uint64 VIRTUAL_SHUFFLE_INTERVAL_NS = 2 * SDL_NS_PER_SECOND;
+static SpriteInstance VirtualSpriteData[VIRTUAL_SPRITE_COUNT];
+
+// --picking: layer ids written to the pick target
+static const Uint32 PICK_LAYER_STATIC = 0;
+static const Uint32 PICK_LAYER_DYNAMIC = 1;
+static const char* PICK_LAYER_NAMES[2] = { "static", "dynamic" };
+
+// --broadphase: off-screen sprites spread out so each has about this much room,
+// drifting and spinning so the sweep sees coherent motion
+static const float COLLISION_SPACING = 48;
+static const float COLLISION_MAX_SPEED = 60;
+static const float COLLISION_SPIN_SPEED = 0.5f;
+static const Uint64 BROADPHASE_REPORT_INTERVAL_NS = 2 * SDL_NS_PER_SECOND;
+
+// --ecs: dynamic sprites are entities, either bouncing around the scene or spinning in place
+typedef struct Velocity
+{
+    float x, y;
+} Velocity;
+
+typedef struct Spin
+{
+    float speed;
+} Spin;
+
+static const float ECS_MAX_SPEED = 120;
+static const float ECS_MAX_SPIN = 4;
+
+// --async-acquire: what runs while the swapchain has no texture to give, in order
+static const Uint32 ACQUIRE_WAIT_STEP_BROADPHASE = 0;
+static const Uint32 ACQUIRE_WAIT_STEP_UPLOADS = 1;
+static const Uint32 ACQUIRE_WAIT_STEP_COUNT = 2;
+
+// --gpu-sort: dynamic sprites are spread over this range of depths, and see-through enough
+// that drawing them out of order would show
+static const float SORTED_MAX_DEPTH = 100;
+static const float SORTED_MIN_ALPHA = 0.3f;
+static const float SORTED_MAX_ALPHA = 0.8f;
+
+// --lights: each light circles a point of the scene, small enough that
+// a tile is only reached by a few dozen of a thousand
+typedef struct LightOrbit
+{
+    float x, y;
+    float radius;
+    float speed;  // radians per second, either way around
+} LightOrbit;
+
+static const float LIGHT_MIN_RADIUS = 16;
+static const float LIGHT_MAX_RADIUS = 48;
+static const float LIGHT_HEIGHT = 24;
+static const float LIGHT_INTENSITY = 1.5f;
+static const float LIGHT_MAX_ORBIT = 64;
+static const float LIGHT_MAX_ORBIT_SPEED = 2;
+static const float NORMAL_MAP_STRENGTH = 4;
+static std::vector<PointLight> LightSources;
+static std::vector<LightOrbit> LightOrbits;
+
+// Sprites are randomized a block at a time, drawing each field for the whole block in one bulk fill
+static const Uint32 RANDOM_BLOCK_SIZE = 256;
+
+static void RandomizeSprites(SpriteInstance* sprites, Uint32 count, float time)
+{
+    Sint32 ravioli[RANDOM_BLOCK_SIZE];
+    Sint32 x[RANDOM_BLOCK_SIZE];
+    Sint32 y[RANDOM_BLOCK_SIZE];
+    float rotation[RANDOM_BLOCK_SIZE];
+    for (Uint32 first = 0; first < count; first += RANDOM_BLOCK_SIZE)
+    {
+        const Uint32 blockCount = SDL_min(count - first, RANDOM_BLOCK_SIZE);
+        RandomStream_FillInt(&SceneRandom, ravioli, blockCount, 4);
+        RandomStream_FillInt(&SceneRandom, x, blockCount, 640);
+        RandomStream_FillInt(&SceneRandom, y, blockCount, 480);
+        RandomStream_FillFloat(&SceneRandom, rotation, blockCount);
+        for (Uint32 i = 0; i < blockCount; i += 1)
+        {
+            SpriteInstance* sprite = &sprites[first + i];
+            sprite->x = (float)x[i];
+            sprite->y = (float)y[i];
+            sprite->z = 0;
+            sprite->rotation = rotation[i] * SDL_PI_F * 2;
+            sprite->w = 32;
+            sprite->h = 32;
+            // start each sprite on a random frame of the animation
+            sprite->animation = Flipbook_Pack(RavioliAnimation, FLIPBOOK_LOOP_REPEAT, RAVIOLI_FPS);
+            sprite->animation_start = time - (float)ravioli[i] / RAVIOLI_FPS;
+            sprite->tex_u = uCoords[ravioli[i]];
+            sprite->tex_v = vCoords[ravioli[i]];
+            sprite->tex_w = 0.5f;
+            sprite->tex_h = 0.5f;
+            sprite->r = 1.0f;
+            sprite->g = 1.0f;
+            sprite->b = 1.0f;
+            sprite->a = 1.0f;
+        }
+    }
+}
+
+// --gpu-sort: gives sprites a random depth and translucency, and the tint feature that applies it
+static void RandomizeDepths(SpriteInstance* sprites, Uint32 count)
+{
+    float depth[RANDOM_BLOCK_SIZE];
+    float alpha[RANDOM_BLOCK_SIZE];
+    for (Uint32 first = 0; first < count; first += RANDOM_BLOCK_SIZE)
+    {
+        const Uint32 blockCount = SDL_min(count - first, RANDOM_BLOCK_SIZE);
+        RandomStream_FillFloat(&SceneRandom, depth, blockCount);
+        RandomStream_FillFloat(&SceneRandom, alpha, blockCount);
+        for (Uint32 i = 0; i < blockCount; i += 1)
+        {
+            sprites[first + i].z = depth[i] * SORTED_MAX_DEPTH;
+            sprites[first + i].a = SORTED_MIN_ALPHA + alpha[i] * (SORTED_MAX_ALPHA - SORTED_MIN_ALPHA);
+        }
+    }
+}
+
+// Queues this frame's lights, each moved along its orbit
+static void AnimateLights(float time)
+{
+    PointLight* lights = LightGrid_QueueLights(&Lights, &Uploads, (Uint32)LightSources.size());
+    for (size_t i = 0; i < LightSources.size(); i += 1)
+    {
+        const LightOrbit* orbit = &LightOrbits[i];
+        const float angle = time * orbit->speed + (float)i;
+        lights[i] = LightSources[i];
+        lights[i].x = orbit->x + SDL_cosf(angle) * orbit->radius;
+        lights[i].y = orbit->y + SDL_sinf(angle) * orbit->radius;
+    }
+}
+
+// Lays out the text lines, the last one at a size that changes with time
+static void LayoutText(SDL_GPUDevice* device, float time)
+{
+    SpriteInstance* glyphs = SpriteLayer_Map(&Text, device);
+    const SDL_FColor white = { 1.0f, 1.0f, 1.0f, 1.0f };
+    Uint32 count = 0;
+    float y = 10;
+    for (float size : TEXT_SIZES)
+    {
+        count += SdfFont_Layout(&Font, TEXT_MESSAGE, 10, y, size, white, glyphs + count, TEXT_GLYPH_CAPACITY - count);
+        y += size * 1.25f;
+    }
+    const float zoom = TEXT_ZOOM_MIN + (SDL_sinf(time) + 1) / 2 * (TEXT_ZOOM_MAX - TEXT_ZOOM_MIN);
+    const SDL_FColor gold = { 1.0f, 0.8f, 0.3f, 1.0f };
+    count += SdfFont_Layout(&Font, TEXT_MESSAGE, 320, 20, zoom, gold, glyphs + count, TEXT_GLYPH_CAPACITY - count);
+    SpriteLayer_Unmap(&Text, device, count);
+}
+
+static void SpawnEcsSprite(float time)
+{
+    const bool spinning = RandomStream_NextInt(&SceneRandom, 2) == 0;
+    const EcsEntity entity = EcsWorld_Create(&World, ECS_COMPONENT(SpriteComponent) | ECS_COMPONENT(spinning ? SpinComponent : VelocityComponent));
+    if (not EcsWorld_IsAlive(&World, entity)) {
+        return;
+    }
+    SpriteInstance* sprite = (SpriteInstance*)EcsWorld_Get(&World, entity, SpriteComponent);
+    RandomizeSprites(sprite, 1, time);
+    if (Options.gpuSort) {
+        RandomizeDepths(sprite, 1);
+    }
+    if (spinning) {
+        Spin* spin = (Spin*)EcsWorld_Get(&World, entity, SpinComponent);
+        spin->speed = (RandomStream_NextFloat(&SceneRandom) * 2 - 1) * ECS_MAX_SPIN;
+    }
+    else {
+        Velocity* velocity = (Velocity*)EcsWorld_Get(&World, entity, VelocityComponent);
+        velocity->x = (RandomStream_NextFloat(&SceneRandom) * 2 - 1) * ECS_MAX_SPEED;
+        velocity->y = (RandomStream_NextFloat(&SceneRandom) * 2 - 1) * ECS_MAX_SPEED;
+    }
+    EcsSprites.push_back(entity);
+}
+
+// Spawns or despawns entities until there are `count`, then runs the systems
+// a chunk at a time and streams the sprite column into the layer
+static void UpdateEcsSprites(SpriteInstance* dataPtr, Uint32 count, float time)
+{
+    while (EcsSprites.size() < count)
+    {
+        const size_t before = EcsSprites.size();
+        SpawnEcsSprite(time);
+        if (EcsSprites.size() == before) {
+            break;
+        }
+    }
+    while (EcsSprites.size() > count)
+    {
+        // despawn from anywhere, the world keeps its chunks packed
+        const size_t victim = (size_t)RandomStream_NextInt(&SceneRandom, (Sint32)EcsSprites.size());
+        EcsWorld_Destroy(&World, EcsSprites[victim]);
+        EcsSprites[victim] = EcsSprites.back();
+        EcsSprites.pop_back();
+    }
 
+    const Uint64 stepNS = SDL_GetTicksNS();
+    const float dt = LastEcsStepNS != 0 ? SDL_min((float)(stepNS - LastEcsStepNS) / SDL_NS_PER_SECOND, 0.1f) : 0;
+    LastEcsStepNS = stepNS;
+
+    EcsChunkView view;
+    EcsQuery movers = EcsWorld_Query(&World, ECS_COMPONENT(SpriteComponent) | ECS_COMPONENT(VelocityComponent));
+    while (EcsQuery_Next(&movers, &view))
+    {
+        SpriteInstance* sprites = (SpriteInstance*)EcsChunkView_Column(&view, SpriteComponent);
+        Velocity* velocities = (Velocity*)EcsChunkView_Column(&view, VelocityComponent);
+        for (Uint32 i = 0; i < view.count; i += 1)
+        {
+            sprites[i].x += velocities[i].x * dt;
+            sprites[i].y += velocities[i].y * dt;
+            if ((sprites[i].x < 0 && velocities[i].x < 0) || (sprites[i].x > 640 - sprites[i].w && velocities[i].x > 0)) {
+                velocities[i].x = -velocities[i].x;
+            }
+            if ((sprites[i].y < 0 && velocities[i].y < 0) || (sprites[i].y > 480 - sprites[i].h && velocities[i].y > 0)) {
+                velocities[i].y = -velocities[i].y;
+            }
+        }
+    }
+    EcsQuery spinners = EcsWorld_Query(&World, ECS_COMPONENT(SpriteComponent) | ECS_COMPONENT(SpinComponent));
+    while (EcsQuery_Next(&spinners, &view))
+    {
+        SpriteInstance* sprites = (SpriteInstance*)EcsChunkView_Column(&view, SpriteComponent);
+        const Spin* spins = (const Spin*)EcsChunkView_Column(&view, SpinComponent);
+        for (Uint32 i = 0; i < view.count; i += 1)
+        {
+            sprites[i].rotation += spins[i].speed * dt;
+        }
+    }
+
+    EcsWorld_CopyColumn(&World, SpriteComponent, dataPtr, count);
+}
+
+// Stands in for reading pages off disk: a color per page with a dark border,
+// so page seams and mismatched table entries are easy to spot
+static void GenerateVirtualPage(void* userdata, Uint32 pageX, Uint32 pageY, Uint8* pixels)
+{
+    for (Uint32 y = 0; y < VIRTUAL_TEXTURE_PAGE_SIZE; y += 1)
+    {
+        for (Uint32 x = 0; x < VIRTUAL_TEXTURE_PAGE_SIZE; x += 1)
+        {
+            Uint8* texel = &pixels[(y * VIRTUAL_TEXTURE_PAGE_SIZE + x) * 4];
+            const bool border = x < 2 || y < 2;
+            texel[0] = border ? 0 : (Uint8)(pageX * 37);
+            texel[1] = border ? 0 : (Uint8)(pageY * 53);
+            texel[2] = border ? 0 : (Uint8)(128 + (x ^ y) / 2);
+            texel[3] = 255;
+        }
+    }
+}
+
+static void RandomizeVirtualSprite(SpriteInstance* sprite)
+{
+    const float texSize = (float)VIRTUAL_TEXTURE_PAGE_SIZE / VIRTUAL_SHEET_SIZE;
+    *sprite = SpriteInstance{
+        .x = (float)RandomStream_NextInt(&SceneRandom, 640 - (Sint32)VIRTUAL_SPRITE_SIZE),
+        .y = (float)RandomStream_NextInt(&SceneRandom, 480 - (Sint32)VIRTUAL_SPRITE_SIZE),
+        .w = VIRTUAL_SPRITE_SIZE,
+        .h = VIRTUAL_SPRITE_SIZE,
+        .tex_u = RandomStream_NextFloat(&SceneRandom) * (1.0f - texSize),
+        .tex_v = RandomStream_NextFloat(&SceneRandom) * (1.0f - texSize),
+        .tex_w = texSize,
+        .tex_h = texSize,
+        .r = 1.0f, .g = 1.0f, .b = 1.0f, .a = 1.0f,
+    };
+}
+
+// Sprite layers can be drawn by either path, which share the uniforms. Pulling uses the
+// shader permutation for the layer's features, instancing always the general shader.
+// Lit layers also need LightGrid_Bind to have been called in the render pass.
+static void DrawSprites(const SpriteLayer* layer, Uint32 features, SDL_GPURenderPass* renderPass, const SDL_GPUTextureSamplerBinding* textureSamplerBinding)
+{
+    if (UseInstancing && not (features & PULLED_ONLY_FEATURES)) {
+        SDL_BindGPUGraphicsPipeline(renderPass, InstancedRenderPipeline);
+        SDL_BindGPUFragmentSamplers(renderPass, 0, textureSamplerBinding, 1);
+        SpriteLayer_DrawInstanced(layer, renderPass, SpriteFrameTable.buffer);
+        return;
+    }
+
+    SDL_BindGPUGraphicsPipeline(renderPass, SpritePipelineCache_Get(&SpritePipelines, features));
+    if (features & SPRITE_FEATURE_LIT) {
+        // the normal map is laid out like the atlas, so it shares the texture coordinates
+        const SDL_GPUTextureSamplerBinding litSamplerBindings[2] = {
+            *textureSamplerBinding,
+            { .texture = NormalAtlas, .sampler = Sampler },
+        };
+        SDL_BindGPUFragmentSamplers(renderPass, 0, litSamplerBindings, 2);
+    }
+    else {
+        SDL_BindGPUFragmentSamplers(renderPass, 0, textureSamplerBinding, 1);
+    }
+    if (features & SPRITE_FEATURE_SORTED) {
+        SpriteLayer_DrawSorted(layer, renderPass, SpriteFrameTable.buffer, DepthSort.keys);
+    }
+    else {
+        SpriteLayer_Draw(layer, renderPass, SpriteFrameTable.buffer);
+    }
+}
+
+// The picking variant of a layer's shaders. Ids aren't lit.
+static Uint32 PickFeatures(Uint32 features)
+{
+    return (features & ~SPRITE_FEATURE_LIT) | SPRITE_FEATURE_PICKING;
+}
+
+// Draws a layer's ids into the pick pass, with the picking variant of the layer's shaders
+static void PickSprites(const SpriteLayer* layer, Uint32 features, Uint32 pickLayer, SDL_GPUCommandBuffer* cmdBuf, SDL_GPURenderPass* pickPass, const SDL_GPUTextureSamplerBinding* textureSamplerBinding)
+{
+    const SpritePickUniforms pickUniforms = SpritePick_Uniforms(pickLayer);
+    SDL_BindGPUGraphicsPipeline(pickPass, SpritePipelineCache_Get(&SpritePipelines, PickFeatures(features)));
+    SDL_BindGPUFragmentSamplers(pickPass, 0, textureSamplerBinding, 1);
+    SDL_PushGPUVertexUniformData(cmdBuf, 1, &pickUniforms, sizeof(SpritePickUniforms));
+    if (features & SPRITE_FEATURE_SORTED) {
+        // the same order as the scene, so the topmost sprite is the one picked
+        SpriteLayer_DrawSorted(layer, pickPass, SpriteFrameTable.buffer, DepthSort.keys);
+    }
+    else {
+        SpriteLayer_Draw(layer, pickPass, SpriteFrameTable.buffer);
+    }
+}
+
+
+// Moves the broadphase crowd on, wrapping at the edges, and times finding its overlaps
+static void StepBroadphase()
+{
+    const Uint64 stepNS = SDL_GetTicksNS();
+    const float dt = LastCollisionStepNS != 0 ? SDL_min((float)(stepNS - LastCollisionStepNS) / SDL_NS_PER_SECOND, 0.1f) : 0;
+    const float worldSize = SDL_sqrtf((float)CollisionSprites.size()) * COLLISION_SPACING;
+    LastCollisionStepNS = stepNS;
+    for (size_t i = 0; i < CollisionSprites.size(); i += 1)
+    {
+        SpriteInstance* sprite = &CollisionSprites[i];
+        sprite->x = SDL_fmodf(sprite->x + CollisionVelocities[i * 2 + 0] * dt + worldSize, worldSize);
+        sprite->y = SDL_fmodf(sprite->y + CollisionVelocities[i * 2 + 1] * dt + worldSize, worldSize);
+        sprite->rotation += COLLISION_SPIN_SPEED * dt;
+    }
+
+    const Uint64 broadphaseStartNS = SDL_GetTicksNS();
+    const Uint32 pairCount = Broadphase_Update(&Collision, CollisionSprites.data(), (Uint32)CollisionSprites.size());
+    const Uint64 broadphaseEndNS = SDL_GetTicksNS();
+    RollingStats_Add(&BroadphaseMs, (float)(broadphaseEndNS - broadphaseStartNS) / SDL_NS_PER_MS);
+    if (broadphaseEndNS - LastBroadphaseReportNS >= BROADPHASE_REPORT_INTERVAL_NS) {
+        const RollingStatsSummary summary = RollingStats_Summarize(&BroadphaseMs);
+        SDL_Log("Broadphase: %u sprites, %u pairs, avg %.2fms p95 %.2fms (%u threads)",
+            (Uint32)CollisionSprites.size(), pairCount, summary.avg, summary.p95, Collision.workerCount + 1);
+        LastBroadphaseReportNS = broadphaseEndNS;
+    }
+}
+
+// Queues instance data, the static layer only goes up when it changed, then records
+// everything due this frame in one copy pass
+static void RecordUploads(SDL_GPUCommandBuffer* cmdBuf, const SDL_FRect& backgroundView)
+{
+    Trace_Begin("upload");
+    SpriteLayer_Upload(&StaticSprites, &Uploads);
+    SpriteLayer_Upload(&DynamicSprites, &Uploads);
+    SpriteLayer_Upload(&Panels, &Uploads);
+    SpriteLayer_Upload(&Text, &Uploads);
+    SpriteLayer_Upload(&Cursor, &Uploads);
+    SpriteLayer_Upload(&VirtualSprites, &Uploads);
+    Tilemap_Upload(&Background, &Uploads, backgroundView);
+    UploadScheduler_Flush(&Uploads, cmdBuf);
+    Trace_End();
+}
+
+// --async-acquire: work that needs no swapchain texture, run while there is none yet
+static void RunAcquireWaitStep(Uint32 step, SDL_GPUCommandBuffer* cmdBuf, const SDL_FRect& backgroundView)
+{
+    if (step == ACQUIRE_WAIT_STEP_BROADPHASE && Options.broadphaseSprites > 0) {
+        StepBroadphase();
+    }
+    else if (step == ACQUIRE_WAIT_STEP_UPLOADS) {
+        RecordUploads(cmdBuf, backgroundView);
+    }
+}
 
 SDL_AppResult SDL_Fail(){
     SDL_LogError(SDL_LOG_CATEGORY_CUSTOM, "Error %s", SDL_GetError());
@@ -47,6 +552,19 @@ SDL_AppResult SDL_Fail(){
 }
 
 SDL_AppResult SDL_AppInit(void** appstate, int argc, char* argv[]) {
+    if (not Options_Parse(&Options, argc, argv)) {
+        return SDL_APP_FAILURE;
+    }
+    if (Options.tracePath != NULL) {
+        Trace_Init();
+    }
+
+    // Everything random in the scene comes from one seed, so every run shows the same scene until --seed picks another
+    SceneRandom = RandomStream_Create(Options.seed, 0);
+    SDL_Log("Scene seed: %u", Options.seed);
+
+    Trace_Begin("init device");
+
     // init the library, here we make a window so we only need the Video capabilities.
     if (not SDL_Init(SDL_INIT_VIDEO | SDL_INIT_AUDIO)){
         return SDL_Fail();
@@ -117,19 +635,29 @@ SDL_AppResult SDL_AppInit(void** appstate, int argc, char* argv[]) {
         presentMode
     );
 
-    SDL_srand(0);
+    // Fewer frames in flight means input reaches the screen sooner, at the cost of CPU/GPU overlap
+    if (Options.framesInFlight != 0 && not SDL_SetGPUAllowedFramesInFlight(device, Options.framesInFlight)) {
+        return SDL_Fail();
+    }
 
-    // Create the shaders
-    SDL_GPUShader* vertShader = LoadShader(
-        basePath.string().c_str(),
-        device,
-        "PullSpriteBatch.vert",
-        0,
-        1,
-        1,
-        0
-    );
+    // Every frame is submitted with a fence, timing it on the GPU and telling the picker when it's done
+    if (not GpuFrameTimer_Init(&GpuTimer, device)) {
+        return SDL_Fail();
+    }
+    if (Options.frameBudgetMs > 0) {
+        FrameGovernor_Init(&Governor, Options.frameBudgetMs);
+    }
+    if (Options.dynamicResolutionMs > 0) {
+        // the offscreen target must match the swapchain so the pipelines below can draw into either
+        if (not DynamicResolution_Init(&Resolution, device, basePath.string().c_str(), SDL_GetGPUSwapchainTextureFormat(device, window), Options.dynamicResolutionMs)) {
+            return SDL_Fail();
+        }
+    }
+
+    Trace_End();
 
+    // Create the shaders
+    Trace_Begin("init pipelines");
     SDL_GPUShader* fragShader = LoadShader(
 		basePath.string().c_str(),
         device,
@@ -158,70 +686,107 @@ SDL_AppResult SDL_AppInit(void** appstate, int argc, char* argv[]) {
             .num_color_targets = 1,
     };
 
-    // Create the sprite render pipeline
+    // Sprite pipelines are specialized per feature mask. Create the ones the layers
+    // use now, so a missing shader variant fails at startup rather than mid-frame.
+    if (Options.packedSprites) {
+        StaticSpriteFeatures |= SPRITE_FEATURE_PACKED;
+    }
+    if (Options.gpuSort) {
+        DynamicSpriteFeatures |= SPRITE_FEATURE_TINT | SPRITE_FEATURE_SORTED;
+    }
+    if (Options.lightCount > 0) {
+        StaticSpriteFeatures |= SPRITE_FEATURE_LIT;
+        DynamicSpriteFeatures |= SPRITE_FEATURE_LIT;
+    }
+    SpritePipelineCache_Init(&SpritePipelines, device, basePath.string().c_str(), colorTargetDescriptions[0]);
+    if (not SpritePipelineCache_Get(&SpritePipelines, StaticSpriteFeatures) ||
+        not SpritePipelineCache_Get(&SpritePipelines, SCENERY_FEATURES) ||
+        not SpritePipelineCache_Get(&SpritePipelines, DynamicSpriteFeatures) ||
+        (Options.latencyProbe && not SpritePipelineCache_Get(&SpritePipelines, CURSOR_FEATURES)) ||
+        not SpritePipelineCache_Get(&SpritePipelines, TEXT_FEATURES) ||
+        (Options.virtualTexture && not SpritePipelineCache_Get(&SpritePipelines, SPRITE_FEATURE_VIRTUAL)) ||
+        (Options.picking && not SpritePipelineCache_Get(&SpritePipelines, PickFeatures(StaticSpriteFeatures))) ||
+        (Options.picking && not SpritePipelineCache_Get(&SpritePipelines, PickFeatures(DynamicSpriteFeatures)))) {
+        return SDL_Fail();
+    }
+
+    // The dynamic layer never holds more sprites than it was created for
+    if (Options.gpuSort && not GpuDepthSort_Init(&DepthSort, device, basePath.string().c_str(), DYNAMIC_SPRITE_COUNT)) {
+        return SDL_Fail();
+    }
+    if (Options.lightCount > 0 && not LightGrid_Init(&Lights, device, basePath.string().c_str(), 640, 480, Options.lightCount, Options.lightsPerTile)) {
+        return SDL_Fail();
+    }
+
+    // The tilemap shares the general fragment stage and blending, only the vertex stage differs
+    SDL_GPUShader* tilemapVertShader = LoadShader(
+        basePath.string().c_str(),
+        device,
+        "TilemapChunk.vert",
+        0,
+        1,
+        1,
+        0
+    );
     auto graphicsPipelineCreateInfo = SDL_GPUGraphicsPipelineCreateInfo{
-        .vertex_shader = vertShader,
+        .vertex_shader = tilemapVertShader,
         .fragment_shader = fragShader,
         .primitive_type = SDL_GPU_PRIMITIVETYPE_TRIANGLELIST,
         .target_info = graphicsPipelineTargetInfo,
     };
-    RenderPipeline = SDL_CreateGPUGraphicsPipeline(
+    TilemapPipeline = SDL_CreateGPUGraphicsPipeline(
         device,
         &graphicsPipelineCreateInfo
     );
 
-    SDL_ReleaseGPUShader(device, vertShader);
-    SDL_ReleaseGPUShader(device, fragShader);
-
-    // Load the image data
-    SDL_Surface* imageData = LoadImage(basePath.string().c_str(), "ravioli_atlas.bmp", 4);
-    if (imageData == NULL)
-    {
-        SDL_Log("Could not load image data!");
-        return SDL_Fail();
-    }
-
-    auto transferBufferCreateInfo = SDL_GPUTransferBufferCreateInfo{
-        .usage = SDL_GPU_TRANSFERBUFFERUSAGE_UPLOAD,
-            .size = (Uint32) imageData->w * imageData->h * 4
-    };
-
-    SDL_GPUTransferBuffer* textureTransferBuffer = SDL_CreateGPUTransferBuffer(
+    SDL_GPUShader* nineSliceVertShader = LoadShader(
+        basePath.string().c_str(),
+        device,
+        "NineSlice.vert",
+        0,
+        1,
+        1,
+        0
+    );
+    graphicsPipelineCreateInfo.vertex_shader = nineSliceVertShader;
+    NineSlicePipeline = SDL_CreateGPUGraphicsPipeline(
         device,
-        &transferBufferCreateInfo
+        &graphicsPipelineCreateInfo
     );
 
-    Uint8* textureTransferPtr = (Uint8*) SDL_MapGPUTransferBuffer(
+    // Same sprites, fetched per instance by the input assembler rather than pulled from storage
+    SDL_GPUShader* instancedVertShader = LoadShader(
+        basePath.string().c_str(),
         device,
-        textureTransferBuffer,
-        false
+        "InstancedSpriteBatch.vert",
+        0,
+        1,
+        1,
+        0
     );
-    SDL_memcpy(textureTransferPtr, imageData->pixels, imageData->w * imageData->h * 4);
-    SDL_UnmapGPUTransferBuffer(device, textureTransferBuffer);
-
-    // Create the GPU resources
-    auto textureCreateInfo = SDL_GPUTextureCreateInfo {
-        .type = SDL_GPU_TEXTURETYPE_2D,
-            .format = SDL_GPU_TEXTUREFORMAT_R8G8B8A8_UNORM,
-            .usage = SDL_GPU_TEXTUREUSAGE_SAMPLER,
-            .width = (Uint32) imageData->w,
-            .height = (Uint32) imageData->h,
-            .layer_count_or_depth = 1,
-            .num_levels = 1,
-    };
-
-    Texture = SDL_CreateGPUTexture(
+    graphicsPipelineCreateInfo.vertex_shader = instancedVertShader;
+    graphicsPipelineCreateInfo.vertex_input_state = SpriteLayer_InstanceVertexInput();
+    graphicsPipelineCreateInfo.primitive_type = SDL_GPU_PRIMITIVETYPE_TRIANGLESTRIP;
+    InstancedRenderPipeline = SDL_CreateGPUGraphicsPipeline(
         device,
-        &textureCreateInfo
+        &graphicsPipelineCreateInfo
     );
+    UseInstancing = Options.instancedSprites;
 
+    SDL_ReleaseGPUShader(device, tilemapVertShader);
+    SDL_ReleaseGPUShader(device, nineSliceVertShader);
+    SDL_ReleaseGPUShader(device, instancedVertShader);
+    SDL_ReleaseGPUShader(device, fragShader);
+
+    // Lets cooked atlas pages' mips be used when sprites are drawn small
     auto samplerCreateInfo = SDL_GPUSamplerCreateInfo{
         .min_filter = SDL_GPU_FILTER_NEAREST,
             .mag_filter = SDL_GPU_FILTER_NEAREST,
             .mipmap_mode = SDL_GPU_SAMPLERMIPMAPMODE_NEAREST,
             .address_mode_u = SDL_GPU_SAMPLERADDRESSMODE_CLAMP_TO_EDGE,
             .address_mode_v = SDL_GPU_SAMPLERADDRESSMODE_CLAMP_TO_EDGE,
-            .address_mode_w = SDL_GPU_SAMPLERADDRESSMODE_CLAMP_TO_EDGE
+            .address_mode_w = SDL_GPU_SAMPLERADDRESSMODE_CLAMP_TO_EDGE,
+            .max_lod = 1000.0f
     };
 
     Sampler = SDL_CreateGPUSampler(
@@ -229,92 +794,229 @@ SDL_AppResult SDL_AppInit(void** appstate, int argc, char* argv[]) {
         &samplerCreateInfo
     );
 
-    auto transferBufferCreateInfo2 = SDL_GPUTransferBufferCreateInfo{
-        .usage = SDL_GPU_TRANSFERBUFFERUSAGE_UPLOAD,
-            .size = SPRITE_COUNT * sizeof(SpriteInstance)
-    };
+    Trace_End();
 
-    SpriteDataTransferBuffer = SDL_CreateGPUTransferBuffer(
-        device,
-        &transferBufferCreateInfo2
-    );
+    Trace_Begin("init scene");
+    if (not SpriteLayer_InitFormat(&StaticSprites, device, SPRITE_LAYER_STATIC, STATIC_SPRITE_COUNT, SpritePermutation_Get(StaticSpriteFeatures)->instanceSize, 6) ||
+        not SpriteLayer_Init(&DynamicSprites, device, SPRITE_LAYER_DYNAMIC, DYNAMIC_SPRITE_COUNT) ||
+        not NineSlice_InitLayer(&Panels, device, SPRITE_LAYER_DYNAMIC, PANEL_COUNT)) {
+        return SDL_Fail();
+    }
 
-    auto bufferCreateInfo = SDL_GPUBufferCreateInfo{
-        .usage = SDL_GPU_BUFFERUSAGE_GRAPHICS_STORAGE_READ,
-            .size = SPRITE_COUNT * sizeof(SpriteInstance)
-    };
+    // Up-front data goes through the same scheduler as everything else, starting with the first frame
+    UploadScheduler_Init(&Uploads, device, Options.uploadBudgetKiB * 1024);
 
-    SpriteDataBuffer = SDL_CreateGPUBuffer(
-        device,
-        &bufferCreateInfo
-    );
+    // The atlas is there from the first frame, and streamed back in if it is ever evicted
+    if (not TextureResidency_Init(&Residency, device, &Uploads, basePath.string().c_str(), (Uint64)Options.textureBudgetMiB * 1024 * 1024)) {
+        return SDL_Fail();
+    }
+    AtlasPage = TextureResidency_AddPage(&Residency, "ravioli_atlas.bmp");
+    if (not TextureResidency_Load(&Residency, AtlasPage)) {
+        SDL_Log("Could not load image data!");
+        return SDL_Fail();
+    }
 
-    // Transfer the up-front data
-    SDL_GPUCommandBuffer* uploadCmdBuf = SDL_AcquireGPUCommandBuffer(device);
-    SDL_GPUCopyPass* copyPass = SDL_BeginGPUCopyPass(uploadCmdBuf);
+    // A crowd for the broadphase, which isn't drawn, only timed
+    if (Options.broadphaseSprites > 0)
+    {
+        if (not Broadphase_Init(&Collision, 0)) {
+            return SDL_Fail();
+        }
+        const float worldSize = SDL_sqrtf((float)Options.broadphaseSprites) * COLLISION_SPACING;
+        CollisionSprites.resize(Options.broadphaseSprites);
+        CollisionVelocities.resize(Options.broadphaseSprites * 2);
+        for (Uint32 i = 0; i < Options.broadphaseSprites; i += 1)
+        {
+            CollisionSprites[i] = SpriteInstance{
+                .x = RandomStream_NextFloat(&SceneRandom) * worldSize,
+                .y = RandomStream_NextFloat(&SceneRandom) * worldSize,
+                .rotation = RandomStream_NextFloat(&SceneRandom) * SDL_PI_F * 2,
+                .w = 32,
+                .h = 32,
+            };
+            CollisionVelocities[i * 2 + 0] = (RandomStream_NextFloat(&SceneRandom) * 2 - 1) * COLLISION_MAX_SPEED;
+            CollisionVelocities[i * 2 + 1] = (RandomStream_NextFloat(&SceneRandom) * 2 - 1) * COLLISION_MAX_SPEED;
+        }
+    }
 
-    auto textureTransferInfo = SDL_GPUTextureTransferInfo {
-        .transfer_buffer = textureTransferBuffer,
-            .offset = 0, /* Zeroes out the rest */
-    };
+    // Dynamic sprites live in the world, with each kind of entity in its own archetype
+    if (Options.ecs)
+    {
+        EcsWorld_Init(&World);
+        SpriteComponent = EcsWorld_RegisterComponent(&World, sizeof(SpriteInstance));
+        VelocityComponent = EcsWorld_RegisterComponent(&World, sizeof(Velocity));
+        SpinComponent = EcsWorld_RegisterComponent(&World, sizeof(Spin));
+        EcsSprites.reserve(DYNAMIC_SPRITE_COUNT);
+    }
 
-    auto textureRegion = SDL_GPUTextureRegion {
-        .texture = Texture,
-            .w = (Uint32) imageData->w,
-            .h = (Uint32) imageData->h,
-            .d = 1
-    };
+    // Ids are drawn in the scene's 640x480 coordinates, whatever the window size
+    if (Options.picking && not SpritePicker_Init(&Picker, device, 640, 480)) {
+        return SDL_Fail();
+    }
 
-    SDL_UploadToGPUTexture(
-        copyPass,
-        &textureTransferInfo,
-        &textureRegion,
-        false
-    );
+    // Every page of the sheet starts out on the placeholder, the first frame's sprites ask for theirs
+    if (Options.virtualTexture)
+    {
+        if (not VirtualTexture_Init(&VirtualSheet, device, &Uploads, VIRTUAL_SHEET_SIZE, VIRTUAL_SHEET_SIZE, VIRTUAL_CACHE_SIZE, VIRTUAL_LOADS_PER_FRAME, GenerateVirtualPage, NULL) ||
+            not SpriteLayer_Init(&VirtualSprites, device, SPRITE_LAYER_STATIC, VIRTUAL_SPRITE_COUNT))
+        {
+            return SDL_Fail();
+        }
+        SpriteInstance* virtualPtr = SpriteLayer_Map(&VirtualSprites, device);
+        for (Uint32 i = 0; i < VIRTUAL_SPRITE_COUNT; i += 1)
+        {
+            RandomizeVirtualSprite(&VirtualSpriteData[i]);
+            virtualPtr[i] = VirtualSpriteData[i];
+        }
+        SpriteLayer_Unmap(&VirtualSprites, device, VIRTUAL_SPRITE_COUNT);
+    }
 
-    SDL_EndGPUCopyPass(copyPass);
-    SDL_SubmitGPUCommandBuffer(uploadCmdBuf);
+    // Lit sprites sample a normal map laid out like the atlas, derived from it once here
+    if (Options.lightCount > 0)
+    {
+        SDL_Surface* albedo = LoadImage(basePath.string().c_str(), "ravioli_atlas.bmp", 4);
+        if (albedo == NULL)
+        {
+            return SDL_Fail();
+        }
+        SDL_Surface* normalMap = LightGrid_CreateNormalMap(albedo, NORMAL_MAP_STRENGTH);
+        SDL_DestroySurface(albedo);
+        if (normalMap == NULL)
+        {
+            return SDL_Fail();
+        }
+        NormalAtlas = UploadScheduler_CreateTexture(&Uploads, normalMap, UPLOAD_PRIORITY_VISIBLE);
+        SDL_DestroySurface(normalMap);
+        if (NormalAtlas == NULL)
+        {
+            return SDL_Fail();
+        }
 
-    SDL_DestroySurface(imageData);
-    SDL_ReleaseGPUTransferBuffer(device, textureTransferBuffer);
-    
-    // load the font
+        LightSources.resize(Options.lightCount);
+        LightOrbits.resize(Options.lightCount);
+        for (Uint32 i = 0; i < Options.lightCount; i += 1)
+        {
+            LightSources[i] = PointLight{
+                .height = LIGHT_HEIGHT,
+                .radius = LIGHT_MIN_RADIUS + RandomStream_NextFloat(&SceneRandom) * (LIGHT_MAX_RADIUS - LIGHT_MIN_RADIUS),
+                .r = 0.5f + RandomStream_NextFloat(&SceneRandom) * 0.5f,
+                .g = 0.5f + RandomStream_NextFloat(&SceneRandom) * 0.5f,
+                .b = 0.5f + RandomStream_NextFloat(&SceneRandom) * 0.5f,
+                .intensity = LIGHT_INTENSITY,
+            };
+            LightOrbits[i] = LightOrbit{
+                .x = RandomStream_NextFloat(&SceneRandom) * 640,
+                .y = RandomStream_NextFloat(&SceneRandom) * 480,
+                .radius = RandomStream_NextFloat(&SceneRandom) * LIGHT_MAX_ORBIT,
+                .speed = (RandomStream_NextFloat(&SceneRandom) * 2 - 1) * LIGHT_MAX_ORBIT_SPEED,
+            };
+        }
+    }
 
-    const auto fontPath = basePath / "Inter-VariableFont.ttf";
-    TTF_Font* font = TTF_OpenFont(fontPath.string().c_str(), 36);
-    if (not font) {
-        return SDL_Fail();
+    // The latency probe draws this marker where the mouse was sampled, to compare against the OS cursor
+    if (Options.latencyProbe)
+    {
+        SDL_Surface* cursorData = LoadImage(basePath.string().c_str(), "latency.bmp", 4);
+        if (cursorData == NULL)
+        {
+            return SDL_Fail();
+        }
+        CursorTexture = UploadScheduler_CreateTexture(&Uploads, cursorData, UPLOAD_PRIORITY_VISIBLE);
+        if (CursorTexture == NULL or not SpriteLayer_Init(&Cursor, device, SPRITE_LAYER_STATIC, 1))
+        {
+            return SDL_Fail();
+        }
+
+        SpriteInstance* cursorPtr = SpriteLayer_Map(&Cursor, device);
+        *cursorPtr = SpriteInstance{
+            .w = (float)cursorData->w,
+            .h = (float)cursorData->h,
+            .tex_w = 1.0f,
+            .tex_h = 1.0f,
+            .r = 1.0f, .g = 1.0f, .b = 1.0f, .a = 1.0f,
+        };
+        SpriteLayer_Unmap(&Cursor, device, 1);
+        SDL_DestroySurface(cursorData);
     }
 
-    // render the font to a surface
-    const std::string_view text = "Hello SDL!";
-    SDL_Surface* surfaceMessage = TTF_RenderText_Solid(font, text.data(), text.length(), { 255,255,255 });
+    // Every ravioli in the atlas, played in order as one looping animation
+    const FlipbookFrame ravioliFrames[4] = {
+        { 0.0f, 0.0f, 0.5f, 0.5f },
+        { 0.5f, 0.0f, 0.5f, 0.5f },
+        { 0.0f, 0.5f, 0.5f, 0.5f },
+        { 0.5f, 0.5f, 0.5f, 0.5f },
+    };
+    RavioliAnimation = FrameTable_AddAnimation(&SpriteFrameTable, ravioliFrames, SDL_arraysize(ravioliFrames));
+    if (not FrameTable_Upload(&SpriteFrameTable, device, &Uploads)) {
+        return SDL_Fail();
+    }
 
-    // make a texture from the surface
-    //SDL_Texture* messageTex = SDL_CreateTextureFromSurface(renderer, surfaceMessage);
+    // Scatter raviolis over the background, leaving most tiles empty. The chunks
+    // around the camera go up with the first frame, the rest trickle in behind it.
+    if (not Tilemap_Init(&Background, device, BACKGROUND_TILES, BACKGROUND_TILES, BACKGROUND_TILE_SIZE, BACKGROUND_TILE_SIZE, 2, 2)) {
+        return SDL_Fail();
+    }
+    for (Uint32 y = 0; y < BACKGROUND_TILES; y += 1)
+    {
+        Sint32 occupied[BACKGROUND_TILES];
+        Sint32 tiles[BACKGROUND_TILES];
+        RandomStream_FillInt(&SceneRandom, occupied, BACKGROUND_TILES, 8);
+        RandomStream_FillInt(&SceneRandom, tiles, BACKGROUND_TILES, 4);
+        for (Uint32 x = 0; x < BACKGROUND_TILES; x += 1)
+        {
+            if (occupied[x] == 0)
+            {
+                Tilemap_SetTile(&Background, x, y, (Uint16)tiles[x]);
+            }
+        }
+    }
+    // Place the static sprites once, they are uploaded with the first frame
+    void* staticPtr = SpriteLayer_MapInstances(&StaticSprites, device);
+    if (StaticSpriteFeatures & SPRITE_FEATURE_PACKED) {
+        std::vector<SpriteInstance> staticSprites(STATIC_SPRITE_COUNT);
+        RandomizeSprites(staticSprites.data(), STATIC_SPRITE_COUNT, 0);
+        for (Uint32 i = 0; i < STATIC_SPRITE_COUNT; i += 1)
+        {
+            SpriteInstance_Pack(&((PackedSpriteInstance*)staticPtr)[i], &staticSprites[i]);
+        }
+    }
+    else {
+        RandomizeSprites((SpriteInstance*)staticPtr, STATIC_SPRITE_COUNT, 0);
+    }
+    SpriteLayer_Unmap(&StaticSprites, device, STATIC_SPRITE_COUNT);
+    Trace_End();
+    
+    // load the font as a distance field atlas, generated on the first run and read back after that
+    Trace_Begin("init font");
+    const auto fontPath = basePath / "Inter-VariableFont.ttf";
+    char* prefPath = SDL_GetPrefPath("libsdl", "sdl-min");
+    const std::string fontCachePath = prefPath ? std::string(prefPath) + "Inter-VariableFont.sdf" : std::string();
+    SDL_free(prefPath);
+    if (not SdfFont_Load(&Font, &Uploads, fontPath.string().c_str(), fontCachePath.empty() ? NULL : fontCachePath.c_str()) ||
+        not SpriteLayer_Init(&Text, device, SPRITE_LAYER_DYNAMIC, TEXT_GLYPH_CAPACITY)) {
+        return SDL_Fail();
+    }
 
-    // we no longer need the font or the surface, so we can destroy those now.
-    TTF_CloseFont(font);
-    SDL_DestroySurface(surfaceMessage);
+    // distances have to be interpolated between texels to scale smoothly
+    auto textSamplerCreateInfo = SDL_GPUSamplerCreateInfo{
+        .min_filter = SDL_GPU_FILTER_LINEAR,
+        .mag_filter = SDL_GPU_FILTER_LINEAR,
+        .mipmap_mode = SDL_GPU_SAMPLERMIPMAPMODE_NEAREST,
+        .address_mode_u = SDL_GPU_SAMPLERADDRESSMODE_CLAMP_TO_EDGE,
+        .address_mode_v = SDL_GPU_SAMPLERADDRESSMODE_CLAMP_TO_EDGE,
+        .address_mode_w = SDL_GPU_SAMPLERADDRESSMODE_CLAMP_TO_EDGE
+    };
+    TextSampler = SDL_CreateGPUSampler(device, &textSamplerCreateInfo);
+    Trace_End();
 
     // load the SVG
-    auto svg_surface = IMG_Load((basePath / "gs_tiger.svg").string().c_str());
+    auto svg_surface = Image_Load((basePath / "gs_tiger.svg").string().c_str());
     //SDL_Texture* tex = SDL_CreateTextureFromSurface(renderer, svg_surface);
     //SDL_DestroySurface(svg_surface);
     
 
-    // get the on-screen dimensions of the text. this is necessary for rendering it
-    /*
-    auto messageTexProps = SDL_GetTextureProperties(messageTex);
-    SDL_FRect text_rect{
-            .x = 0,
-            .y = 0,
-            .w = float(SDL_GetNumberProperty(messageTexProps, SDL_PROP_TEXTURE_WIDTH_NUMBER, 0)),
-            .h = float(SDL_GetNumberProperty(messageTexProps, SDL_PROP_TEXTURE_HEIGHT_NUMBER, 0))
-    };
-    */
-
     // init SDL Mixer
+    Trace_Begin("init audio");
     auto audioDevice = SDL_OpenAudioDevice(SDL_AUDIO_DEVICE_DEFAULT_PLAYBACK, NULL);
     if (not audioDevice) {
         return SDL_Fail();
@@ -332,6 +1034,7 @@ SDL_AppResult SDL_AppInit(void** appstate, int argc, char* argv[]) {
 
     // play the music (does not loop)
     Mix_PlayMusic(music, 0);
+    Trace_End();
     
     // print some information about the window
     SDL_ShowWindow(window);
@@ -372,29 +1075,206 @@ SDL_AppResult SDL_AppEvent(void *appstate, SDL_Event* event) {
         app->app_quit = SDL_APP_SUCCESS;
     }
 
+    LatencyProbe_OnEvent(&Latency, event);
+    switch (event->type) {
+        case SDL_EVENT_MOUSE_MOTION:
+        case SDL_EVENT_MOUSE_BUTTON_DOWN:
+        case SDL_EVENT_KEY_DOWN:
+            // the probe marker follows the mouse, and so does the pick region
+            if (Options.latencyProbe || Options.picking) {
+                Damage_Invalidate(&Damage);
+            }
+            // the click is answered by the first pick taken after it
+            if (event->type == SDL_EVENT_MOUSE_BUTTON_DOWN && Options.picking) {
+                PickClickPending = true;
+                PickClickFrame = FrameIndex;
+            }
+            // F12 saves what the trace holds so far, without waiting for exit
+            if (event->type == SDL_EVENT_KEY_DOWN && event->key.key == SDLK_F12 && not event->key.repeat && Options.tracePath != NULL) {
+                Trace_Write(Options.tracePath);
+            }
+            break;
+        case SDL_EVENT_WINDOW_EXPOSED:
+        case SDL_EVENT_WINDOW_SHOWN:
+        case SDL_EVENT_WINDOW_RESTORED:
+        case SDL_EVENT_WINDOW_PIXEL_SIZE_CHANGED:
+            Damage_Invalidate(&Damage);
+            break;
+        default:
+            break;
+    }
+
     return SDL_APP_CONTINUE;
 }
 
-static float uCoords[4] = { 0.0f, 0.5f, 0.0f, 0.5f };
-static float vCoords[4] = { 0.0f, 0.0f, 0.5f, 0.5f };
 SDL_AppResult SDL_AppIterate(void *appstate) {
     auto* app = (AppContext*)appstate;
 
+    // Minimized, hidden or fully covered windows show nothing, so don't draw at all
+    if (SDL_GetWindowFlags(app->window) & (SDL_WINDOW_MINIMIZED | SDL_WINDOW_OCCLUDED | SDL_WINDOW_HIDDEN)) {
+        SDL_WaitEventTimeout(NULL, PAUSED_WAIT_MS);
+        return app->app_quit;
+    }
+
+    const Uint64 frameStartNS = SDL_GetTicksNS();
+    Trace_Begin("simulate");
+    GpuFrameTimer_Poll(&GpuTimer);
+
     // draw a color
     auto time = SDL_GetTicks() / 1000.f;
     auto red = (std::sin(time) + 1) / 2.0 * 255;
     auto green = (std::sin(time / 2) + 1) / 2.0 * 255;
     auto blue = (std::sin(time) * 2 + 1) / 2.0 * 255;
     
-    Matrix4x4 cameraMatrix = Matrix4x4_CreateOrthographicOffCenter(
-        0,
-        640,
-        480,
-        0,
+    SpriteBatchUniforms uniforms = {
+        .viewProjection = Matrix4x4_CreateOrthographicOffCenter(
+            0,
+            640,
+            480,
+            0,
+            0,
+            -1
+        ),
+        .time = time,
+    };
+
+    // Pan across the tilemap, the sprites stay put in screen space
+    const float backgroundWidth = Background.chunksX * TILEMAP_CHUNK_SIZE * BACKGROUND_TILE_SIZE;
+    const SDL_FRect backgroundView = {
+        .x = Options.idleAware ? 0 : SDL_fmodf(time * BACKGROUND_SCROLL_SPEED, backgroundWidth - 640),
+        .y = 0,
+        .w = 640,
+        .h = 480
+    };
+    Matrix4x4 backgroundMatrix = Matrix4x4_CreateOrthographicOffCenter(
+        backgroundView.x,
+        backgroundView.x + backgroundView.w,
+        backgroundView.y + backgroundView.h,
+        backgroundView.y,
         0,
         -1
     );
 
+    // The governor trades the number and refresh rate of the dynamic sprites for frame time
+    Uint32 dynamicCount = DYNAMIC_SPRITE_COUNT;
+    Uint32 updateInterval = 1;
+    if (Options.frameBudgetMs > 0) {
+        dynamicCount = (Uint32)(DYNAMIC_SPRITE_COUNT * FrameGovernor_Quality(&Governor));
+        updateInterval = DYNAMIC_UPDATE_INTERVALS[Governor.level];
+    }
+
+    // Build sprite instance transfer
+    if ((not Options.idleAware && FrameIndex % updateInterval == 0) || dynamicCount != DynamicSprites.count) {
+        SpriteInstance* dataPtr = SpriteLayer_Map(&DynamicSprites, app->device);
+        if (Options.ecs) {
+            UpdateEcsSprites(dataPtr, dynamicCount, time);
+            dynamicCount = (Uint32)EcsSprites.size();
+        }
+        else {
+            RandomizeSprites(dataPtr, dynamicCount, time);
+            if (Options.gpuSort) {
+                RandomizeDepths(dataPtr, dynamicCount);
+            }
+        }
+        SpriteLayer_Unmap(&DynamicSprites, app->device, dynamicCount);
+    }
+
+    // Panels breathe in size, which only touches their width and height
+    if (not Options.idleAware || Panels.count == 0) {
+        // The atlas was loaded up front, so its size is known
+        const TexturePage* atlas = &Residency.pages[AtlasPage];
+        NineSliceInstance* panelPtr = (NineSliceInstance*)SpriteLayer_MapInstances(&Panels, app->device);
+        for (Uint32 i = 0; i < PANEL_COUNT; i += 1)
+        {
+            const float grow = Options.idleAware ? 0 : (SDL_sinf(time + i) + 1) * 40;
+            const SDL_FRect dest = { 20.0f + i * 150.0f, 380.0f - grow, 120.0f, 80.0f + grow };
+            NineSlice_Set(&panelPtr[i], dest, SDL_FRect{ 0, 0, 16, 16 }, 5, 5, 5, 5, (float)atlas->width, (float)atlas->height, 2);
+            panelPtr[i].a = 0.85f;
+        }
+        SpriteLayer_Unmap(&Panels, app->device, PANEL_COUNT);
+    }
+
+    // Text is laid out again as it zooms, only its glyphs' sizes and positions change
+    if (not Options.idleAware || Text.count == 0) {
+        LayoutText(app->device, Options.idleAware ? 0 : time);
+    }
+
+    // Lights hold still while idle, like everything else
+    if (Options.lightCount > 0 && (not Options.idleAware || Lights.uniforms.lightCount == 0)) {
+        AnimateLights(Options.idleAware ? 0 : time);
+    }
+
+    // Move the broadphase crowd on. With --async-acquire it waits until the frame waits on the swapchain.
+    if (Options.broadphaseSprites > 0 && not Options.asyncAcquire) {
+        StepBroadphase();
+    }
+
+    // Virtual sprites wander off to other parts of the sheet now and then
+    if (Options.virtualTexture && not Options.idleAware && SDL_GetTicksNS() - VirtualShuffleNS >= VIRTUAL_SHUFFLE_INTERVAL_NS) {
+        SpriteInstance* virtualPtr = SpriteLayer_Map(&VirtualSprites, app->device);
+        for (Uint32 i = 0; i < VIRTUAL_SHUFFLE_COUNT; i += 1)
+        {
+            RandomizeVirtualSprite(&VirtualSpriteData[RandomStream_NextInt(&SceneRandom, VIRTUAL_SPRITE_COUNT)]);
+        }
+        SDL_memcpy(virtualPtr, VirtualSpriteData, sizeof(VirtualSpriteData));
+        SpriteLayer_Unmap(&VirtualSprites, app->device, VIRTUAL_SPRITE_COUNT);
+        VirtualShuffleNS = SDL_GetTicksNS();
+    }
+
+    // Picks come back a frame or so after they were drawn
+    SpritePick pick;
+    if (Options.picking && SpritePicker_Poll(&Picker, GpuTimer.completedFrames, &pick)) {
+        const bool hoverChanged = pick.hit != HoveredSprite.hit || pick.layer != HoveredSprite.layer || pick.index != HoveredSprite.index;
+        if (PickClickPending && pick.frame >= PickClickFrame) {
+            if (pick.hit) {
+                SDL_Log("Clicked %s sprite %u at %.0f,%.0f", PICK_LAYER_NAMES[pick.layer], pick.index, pick.x, pick.y);
+            }
+            else {
+                SDL_Log("Clicked nothing at %.0f,%.0f", pick.x, pick.y);
+            }
+            PickClickPending = false;
+        }
+        else if (hoverChanged && pick.hit) {
+            SDL_Log("Hovering %s sprite %u", PICK_LAYER_NAMES[pick.layer], pick.index);
+        }
+        HoveredSprite = pick;
+    }
+
+    // Pages that finished loading replace their placeholders
+    if (TextureResidency_BeginFrame(&Residency)) {
+        Damage_Invalidate(&Damage);
+    }
+    // Virtual pages the last frame asked for are queued, they show up once uploaded
+    if (Options.virtualTexture && VirtualTexture_Update(&VirtualSheet, &Uploads)) {
+        Damage_Invalidate(&Damage);
+    }
+
+    Trace_Counter("dynamic sprites", (float)DynamicSprites.count);
+    Trace_End();
+
+    // Skip the whole frame, copy pass included, if it would look like the last one
+    if (Options.idleAware) {
+        Damage_TrackCamera(&Damage, &backgroundMatrix);
+        Damage_TrackLayer(&Damage, &StaticSprites);
+        Damage_TrackLayer(&Damage, &DynamicSprites);
+        Damage_TrackLayer(&Damage, &Panels);
+        Damage_TrackLayer(&Damage, &Text);
+        Damage_TrackLayer(&Damage, &Cursor);
+        Damage_TrackLayer(&Damage, &VirtualSprites);
+        // uploads left over from earlier frames still need frames to go out with
+        if (UploadScheduler_HasPending(&Uploads)) {
+            Damage_Invalidate(&Damage);
+        }
+        // flipbooks advance on a fixed beat, wake up for the next frame of animation
+        Damage_Schedule(&Damage, ((Uint64)SDL_floorf(time * RAVIOLI_FPS) + 1) * SDL_NS_PER_SECOND / RAVIOLI_FPS);
+
+        const Uint64 nowNS = SDL_GetTicksNS();
+        if (not Damage_NeedsRender(&Damage, nowNS)) {
+            Damage_WaitForChange(&Damage, nowNS, IDLE_MAX_WAIT_NS);
+            return app->app_quit;
+        }
+    }
+
     SDL_GPUCommandBuffer* cmdBuf = SDL_AcquireGPUCommandBuffer(app->device);
     if (cmdBuf == NULL)
     {
@@ -402,65 +1282,83 @@ SDL_AppResult SDL_AppIterate(void *appstate) {
         return SDL_Fail();
     }
 
-    SDL_GPUTexture* swapchainTexture;
-    if (!SDL_WaitAndAcquireGPUSwapchainTexture(cmdBuf, app->window, &swapchainTexture, NULL, NULL)) {
-        SDL_Log("WaitAndAcquireGPUSwapchainTexture failed: %s", SDL_GetError());
-        return SDL_Fail();
+    SDL_GPUTexture* swapchainTexture = NULL;
+    Uint32 swapchainWidth, swapchainHeight;
+
+    // Try for the swapchain texture without blocking, doing the next piece of work each
+    // time there is none yet. Only once the work runs out is it worth waiting for.
+    Uint32 acquireWaitStep = 0;
+    if (Options.asyncAcquire) {
+        for (;;) {
+            if (!SDL_AcquireGPUSwapchainTexture(cmdBuf, app->window, &swapchainTexture, &swapchainWidth, &swapchainHeight)) {
+                SDL_Log("AcquireGPUSwapchainTexture failed: %s", SDL_GetError());
+                return SDL_Fail();
+            }
+            if (swapchainTexture != NULL || acquireWaitStep == ACQUIRE_WAIT_STEP_COUNT) {
+                break;
+            }
+            RunAcquireWaitStep(acquireWaitStep, cmdBuf, backgroundView);
+            acquireWaitStep += 1;
+        }
+        Trace_Counter("steps overlapped with acquire", (float)acquireWaitStep);
+    }
+
+    const Uint64 swapchainWaitStartNS = SDL_GetTicksNS();
+    if (swapchainTexture == NULL) {
+        Trace_Begin("acquire swapchain");
+        if (!SDL_WaitAndAcquireGPUSwapchainTexture(cmdBuf, app->window, &swapchainTexture, &swapchainWidth, &swapchainHeight)) {
+            SDL_Log("WaitAndAcquireGPUSwapchainTexture failed: %s", SDL_GetError());
+            return SDL_Fail();
+        }
+        Trace_End();
+    }
+    const Uint64 swapchainWaitNS = SDL_GetTicksNS() - swapchainWaitStartNS;
+
+    // Whatever the wait didn't cover still has to happen this frame. Like the synchronous
+    // path, the simulation steps regardless, but uploads not recorded yet wait for a frame
+    // that draws. Ones recorded while polling above were committed to before it was known
+    // whether this frame draws, and go out with the command buffer either way, which is
+    // harmless: the uploads were due, and nothing reads them until the next frame draws.
+    if (Options.asyncAcquire) {
+        for (; acquireWaitStep < ACQUIRE_WAIT_STEP_COUNT; acquireWaitStep += 1) {
+            if (swapchainTexture != NULL || acquireWaitStep != ACQUIRE_WAIT_STEP_UPLOADS) {
+                RunAcquireWaitStep(acquireWaitStep, cmdBuf, backgroundView);
+            }
+        }
     }
 
     if (swapchainTexture != NULL)
     {
-        // Build sprite instance transfer
-        SpriteInstance* dataPtr = (SpriteInstance*) SDL_MapGPUTransferBuffer(
-            app->device,
-            SpriteDataTransferBuffer,
-            true
-        );
+        if (not Options.asyncAcquire) {
+            RecordUploads(cmdBuf, backgroundView);
+        }
 
-        for (Uint32 i = 0; i < SPRITE_COUNT; i += 1)
-        {
-            Sint32 ravioli = SDL_rand(4);
-            dataPtr[i].x = (float)(SDL_rand(640));
-            dataPtr[i].y = (float)(SDL_rand(480));
-            dataPtr[i].z = 0;
-            dataPtr[i].rotation = SDL_randf() * SDL_PI_F * 2;
-            dataPtr[i].w = 32;
-            dataPtr[i].h = 32;
-            dataPtr[i].tex_u = uCoords[ravioli];
-            dataPtr[i].tex_v = vCoords[ravioli];
-            dataPtr[i].tex_w = 0.5f;
-            dataPtr[i].tex_h = 0.5f;
-            dataPtr[i].r = 1.0f;
-            dataPtr[i].g = 1.0f;
-            dataPtr[i].b = 1.0f;
-            dataPtr[i].a = 1.0f;
-        }
-
-        SDL_UnmapGPUTransferBuffer(app->device, SpriteDataTransferBuffer);
-
-        // Upload instance data
-        SDL_GPUCopyPass* copyPass = SDL_BeginGPUCopyPass(cmdBuf);
-        auto transferBufferLocation = SDL_GPUTransferBufferLocation {
-            .transfer_buffer = SpriteDataTransferBuffer,
-                .offset = 0
-        };
-        auto gpuBufferRegion = SDL_GPUBufferRegion{
-            .buffer = SpriteDataBuffer,
-                .offset = 0,
-                .size = SPRITE_COUNT * sizeof(SpriteInstance)
-        };
+        // Sorted every frame, even when the sprites didn't move, so the keys never need keeping
+        if (Options.gpuSort) {
+            Trace_Begin("depth sort");
+            GpuDepthSort_Record(&DepthSort, cmdBuf, &DynamicSprites);
+            Trace_End();
+        }
+        if (Options.lightCount > 0) {
+            Trace_Begin("light cull");
+            LightGrid_RecordCull(&Lights, cmdBuf);
+            Trace_End();
+        }
 
-        SDL_UploadToGPUBuffer(
-            copyPass,
-            &transferBufferLocation,
-            &gpuBufferRegion,
-            true
-        );
-        SDL_EndGPUCopyPass(copyPass);
+        // With dynamic resolution the scene goes to an offscreen target first
+        Trace_Begin("record passes");
+        SDL_GPUTexture* sceneTarget = swapchainTexture;
+        SDL_GPUViewport sceneViewport;
+        if (Options.dynamicResolutionMs > 0) {
+            sceneTarget = DynamicResolution_Begin(&Resolution, app->device, swapchainWidth, swapchainHeight, &sceneViewport);
+            if (sceneTarget == NULL) {
+                return SDL_Fail();
+            }
+        }
 
         // Render sprites
         auto colorTargetInfo = SDL_GPUColorTargetInfo {
-            .texture = swapchainTexture,
+            .texture = sceneTarget,
             .clear_color = { 0, 0, 0, 1 },
             .load_op = SDL_GPU_LOADOP_CLEAR,
                 .store_op = SDL_GPU_STOREOP_STORE,
@@ -473,19 +1371,57 @@ SDL_AppResult SDL_AppIterate(void *appstate) {
             1,
             NULL
         );
+        if (Options.dynamicResolutionMs > 0) {
+            SDL_SetGPUViewport(renderPass, &sceneViewport);
+        }
 
-        SDL_BindGPUGraphicsPipeline(renderPass, RenderPipeline);
-        SDL_BindGPUVertexStorageBuffers(
+        auto textureSamplerBinding = SDL_GPUTextureSamplerBinding {
+            .texture = TextureResidency_Use(&Residency, AtlasPage),
+                .sampler = Sampler
+        };
+
+        // Background tiles first
+        SDL_BindGPUGraphicsPipeline(renderPass, TilemapPipeline);
+        SDL_BindGPUFragmentSamplers(
             renderPass,
             0,
-            &SpriteDataBuffer,
+            &textureSamplerBinding,
             1
         );
-        auto textureSamplerBinding = SDL_GPUTextureSamplerBinding {
-            .texture = Texture,
-                .sampler = Sampler
-        };
+        Tilemap_Draw(&Background, cmdBuf, renderPass, &backgroundMatrix, backgroundView);
 
+        SDL_PushGPUVertexUniformData(
+            cmdBuf,
+            0,
+            &uniforms,
+            sizeof(SpriteBatchUniforms)
+        );
+        if (Options.lightCount > 0) {
+            LightGrid_Bind(&Lights, cmdBuf, renderPass);
+        }
+        DrawSprites(&StaticSprites, StaticSpriteFeatures, renderPass, &textureSamplerBinding);
+        DrawSprites(&DynamicSprites, DynamicSpriteFeatures, renderPass, &textureSamplerBinding);
+
+        // Virtual sprites always go through the pulling path, the instanced shader can't translate UVs.
+        // Whatever they show this frame is what the next frame makes resident.
+        if (Options.virtualTexture) {
+            const SDL_GPUTextureSamplerBinding virtualSamplerBindings[2] = {
+                { .texture = VirtualSheet.pageTable, .sampler = Sampler },
+                { .texture = VirtualSheet.cache, .sampler = Sampler },
+            };
+            const VirtualTextureUniforms virtualUniforms = VirtualTexture_GetUniforms(&VirtualSheet);
+            SDL_BindGPUGraphicsPipeline(renderPass, SpritePipelineCache_Get(&SpritePipelines, SPRITE_FEATURE_VIRTUAL));
+            SDL_BindGPUFragmentSamplers(renderPass, 0, virtualSamplerBindings, 2);
+            SDL_PushGPUFragmentUniformData(cmdBuf, 0, &virtualUniforms, sizeof(VirtualTextureUniforms));
+            SpriteLayer_Draw(&VirtualSprites, renderPass, SpriteFrameTable.buffer);
+
+            for (const SpriteInstance& sprite : VirtualSpriteData) {
+                VirtualTexture_RequestRect(&VirtualSheet, sprite.tex_u, sprite.tex_v, sprite.tex_w, sprite.tex_h);
+            }
+        }
+
+        // UI on top, with the same screen-space camera
+        SDL_BindGPUGraphicsPipeline(renderPass, NineSlicePipeline);
         SDL_BindGPUFragmentSamplers(
             renderPass,
             0,
@@ -495,21 +1431,159 @@ SDL_AppResult SDL_AppIterate(void *appstate) {
         SDL_PushGPUVertexUniformData(
             cmdBuf,
             0,
-            &cameraMatrix,
+            &uniforms.viewProjection,
             sizeof(Matrix4x4)
         );
-        SDL_DrawGPUPrimitives(
-            renderPass,
-            SPRITE_COUNT * 6,
-            1,
+        SpriteLayer_Draw(&Panels, renderPass, NULL);
+
+        // Text over the panels, every size from the same atlas
+        auto textSamplerBinding = SDL_GPUTextureSamplerBinding {
+            .texture = Font.atlas,
+            .sampler = TextSampler
+        };
+        SDL_PushGPUVertexUniformData(
+            cmdBuf,
             0,
-            0
+            &uniforms,
+            sizeof(SpriteBatchUniforms)
         );
+        DrawSprites(&Text, TEXT_FEATURES, renderPass, &textSamplerBinding);
+
+        // Late input sampling: read the mouse as late as possible, right before its uniform goes out
+        if (Options.lowLatency) {
+            SDL_PumpEvents();
+            LatencyProbe_PeekQueuedInput(&Latency);
+        }
+        float mouseX, mouseY;
+        int windowWidth, windowHeight;
+        SDL_GetMouseState(&mouseX, &mouseY);
+        SDL_GetWindowSize(app->window, &windowWidth, &windowHeight);
+        LatencyProbe_MarkSampled(&Latency, SDL_GetTicksNS());
+
+        if (Options.latencyProbe) {
+            SpriteBatchUniforms cursorUniforms = uniforms;
+            cursorUniforms.viewProjection = Matrix4x4_Multiply(
+                Matrix4x4_CreateTranslation(mouseX * 640 / windowWidth, mouseY * 480 / windowHeight, 0),
+                uniforms.viewProjection
+            );
+            auto cursorSamplerBinding = SDL_GPUTextureSamplerBinding {
+                .texture = CursorTexture,
+                .sampler = Sampler
+            };
+
+            SDL_PushGPUVertexUniformData(
+                cmdBuf,
+                0,
+                &cursorUniforms,
+                sizeof(SpriteBatchUniforms)
+            );
+            DrawSprites(&Cursor, CURSOR_FEATURES, renderPass, &cursorSamplerBinding);
+        }
 
         SDL_EndGPURenderPass(renderPass);
+
+        // Draw the pickable layers' ids around the mouse and start reading them back
+        if (Options.picking) {
+            SDL_GPURenderPass* pickPass = SpritePicker_Begin(&Picker, cmdBuf, mouseX * 640 / windowWidth, mouseY * 480 / windowHeight, FrameIndex);
+            if (pickPass != NULL) {
+                SDL_PushGPUVertexUniformData(
+                    cmdBuf,
+                    0,
+                    &uniforms,
+                    sizeof(SpriteBatchUniforms)
+                );
+                PickSprites(&StaticSprites, StaticSpriteFeatures, PICK_LAYER_STATIC, cmdBuf, pickPass, &textureSamplerBinding);
+                PickSprites(&DynamicSprites, DynamicSpriteFeatures, PICK_LAYER_DYNAMIC, cmdBuf, pickPass, &textureSamplerBinding);
+                SpritePicker_End(&Picker, cmdBuf, pickPass);
+            }
+        }
+
+        if (Options.dynamicResolutionMs > 0) {
+            DynamicResolution_Present(&Resolution, cmdBuf, swapchainTexture, swapchainWidth, swapchainHeight);
+        }
+        Damage_Clear(&Damage);
+        TextureResidency_EndFrame(&Residency);
+        Trace_End();
+    }
+
+    Trace_Begin("submit");
+    const bool submitted = GpuFrameTimer_Submit(&GpuTimer, cmdBuf, FrameIndex);
+    if (Options.picking) {
+        SpritePicker_Submitted(&Picker, submitted);
+    }
+    Trace_End();
+
+    const Uint64 submitNS = SDL_GetTicksNS();
+    LatencyProbe_OnSubmit(&Latency, submitNS);
+    FrameIndex += 1;
+
+    // The full interval between frames, waits included, is what the viewer sees
+    const float frameMs = LastFrameStartNS != 0 ? (float)(frameStartNS - LastFrameStartNS) / SDL_NS_PER_MS : 0;
+    LastFrameStartNS = frameStartNS;
+
+    // Time spent blocked on the swapchain is not CPU work
+    const float cpuMs = (float)(submitNS - frameStartNS - swapchainWaitNS) / SDL_NS_PER_MS;
+    Trace_Counter("cpu ms", cpuMs);
+    Trace_Counter("gpu ms", GpuTimer.latestMs);
+
+    // Resolution only follows the work, a frame waiting on vsync isn't over budget
+    if (Options.dynamicResolutionMs > 0) {
+        DynamicResolution_Update(&Resolution, cpuMs, GpuTimer.latestMs);
+    }
+
+    // Run each sprite path for a while, then report it and switch to the other one
+    if (Options.benchmarkSpritePaths) {
+        const int path = UseInstancing ? 1 : 0;
+        const Uint64 frameIndex = FrameIndex - 1;
+        if (SpritePathSwitchNS != 0 && frameIndex >= SpritePathFirstFrame) {
+            if (frameMs > 0) {
+                RollingStats_Add(&SpritePathFrameMs[path], frameMs);
+            }
+            RollingStats_Add(&SpritePathCpuMs[path], cpuMs);
+        }
+        // one sample per frame the GPU finished since the last one, once it finishes frames of this path
+        if (GpuTimer.completedFrames != SpritePathGpuFrames) {
+            if (SpritePathSwitchNS != 0 && GpuTimer.completedFrames > SpritePathFirstFrame) {
+                RollingStats_Add(&SpritePathGpuMs[path], GpuTimer.latestMs);
+            }
+            SpritePathGpuFrames = GpuTimer.completedFrames;
+        }
+
+        if (SpritePathSwitchNS == 0) {
+            SpritePathSwitchNS = submitNS;
+            SpritePathFirstFrame = frameIndex + SPRITE_PATH_WARMUP_FRAMES;
+        }
+        else if (submitNS - SpritePathSwitchNS >= SPRITE_PATH_BENCHMARK_INTERVAL_NS) {
+            const RollingStatsSummary frame = RollingStats_Summarize(&SpritePathFrameMs[path]);
+            const RollingStatsSummary cpu = RollingStats_Summarize(&SpritePathCpuMs[path]);
+            const RollingStatsSummary gpu = RollingStats_Summarize(&SpritePathGpuMs[path]);
+            SDL_Log("Sprite path %s: frame avg %.2fms p95 %.2fms, cpu avg %.2fms p95 %.2fms, gpu avg %.2fms p95 %.2fms (%u sprites)",
+                SPRITE_PATH_NAMES[path], frame.avg, frame.p95, cpu.avg, cpu.p95, gpu.avg, gpu.p95, StaticSprites.count + DynamicSprites.count);
+            // Each report only covers the run before it
+            for (int p = 0; p < 2; p += 1) {
+                RollingStats_Reset(&SpritePathFrameMs[p]);
+                RollingStats_Reset(&SpritePathCpuMs[p]);
+                RollingStats_Reset(&SpritePathGpuMs[p]);
+            }
+            UseInstancing = not UseInstancing;
+            SpritePathSwitchNS = submitNS;
+            SpritePathFirstFrame = frameIndex + 1 + SPRITE_PATH_WARMUP_FRAMES;
+        }
     }
 
-    SDL_SubmitGPUCommandBuffer(cmdBuf);
+    if (Options.frameBudgetMs > 0) {
+        if (FrameGovernor_Update(&Governor, cpuMs, GpuTimer.latestMs)) {
+            SDL_Log("Governor: quality level %i (cpu %.2fms, gpu %.2fms, budget %.2fms)", Governor.level, Governor.cpuMs, Governor.gpuMs, Governor.budgetMs);
+        }
+    }
+    if (Options.latencyProbe && submitNS - LastLatencyReportNS >= LATENCY_REPORT_INTERVAL_NS) {
+        const RollingStatsSummary summary = RollingStats_Summarize(&Latency.inputToSubmit);
+        if (summary.count != 0) {
+            SDL_Log("Input to submit: min %.2fms avg %.2fms p95 %.2fms max %.2fms (%u samples, %u frames in flight)",
+                summary.min, summary.avg, summary.p95, summary.max, summary.count, Options.framesInFlight != 0 ? Options.framesInFlight : 2 /* SDL's default */);
+        }
+        LastLatencyReportNS = submitNS;
+    }
 
     return app->app_quit;
 }
@@ -518,6 +1592,39 @@ void SDL_AppQuit(void* appstate, SDL_AppResult result) {
     auto* app = (AppContext*)appstate;
     if (app) {
         //SDL_DestroyRenderer(app->renderer);
+        // Wait out the frames in flight before releasing what they use
+        GpuFrameTimer_Release(&GpuTimer);
+        SpriteLayer_Release(&StaticSprites, app->device);
+        SpriteLayer_Release(&DynamicSprites, app->device);
+        SpriteLayer_Release(&Panels, app->device);
+        SpriteLayer_Release(&Text, app->device);
+        SdfFont_Release(&Font, app->device);
+        SDL_ReleaseGPUSampler(app->device, TextSampler);
+        SpriteLayer_Release(&Cursor, app->device);
+        SpriteLayer_Release(&VirtualSprites, app->device);
+        GpuDepthSort_Release(&DepthSort);
+        LightGrid_Release(&Lights);
+        SDL_ReleaseGPUTexture(app->device, NormalAtlas);
+        SpritePipelineCache_Release(&SpritePipelines);
+        UploadScheduler_Release(&Uploads);
+        SDL_ReleaseGPUTexture(app->device, CursorTexture);
+        TextureResidency_Release(&Residency);
+        VirtualTexture_Release(&VirtualSheet, app->device);
+        SpritePicker_Release(&Picker);
+        if (Options.broadphaseSprites > 0) {
+            Broadphase_Release(&Collision);
+        }
+        if (Options.ecs) {
+            EcsWorld_Release(&World);
+        }
+        // Every thread that records has stopped by now
+        if (Options.tracePath != NULL) {
+            Trace_Write(Options.tracePath);
+            Trace_Quit();
+        }
+        DynamicResolution_Release(&Resolution, app->device);
+        FrameTable_Release(&SpriteFrameTable, app->device);
+        Tilemap_Release(&Background, app->device);
         SDL_ReleaseWindowFromGPUDevice(app->device, app->window);
         SDL_DestroyWindow(app->window);
         SDL_DestroyGPUDevice(app->device);
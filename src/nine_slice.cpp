@@ -0,0 +1,39 @@
+#include "nine_slice.h"
+
+void NineSlice_Set(
+	NineSliceInstance* panel,
+	SDL_FRect dest,
+	SDL_FRect source,
+	float insetLeft,
+	float insetTop,
+	float insetRight,
+	float insetBottom,
+	float textureWidth,
+	float textureHeight,
+	float borderScale
+) {
+	panel->x = dest.x;
+	panel->y = dest.y;
+	panel->w = dest.w;
+	panel->h = dest.h;
+
+	panel->border_left = insetLeft * borderScale;
+	panel->border_top = insetTop * borderScale;
+	panel->border_right = insetRight * borderScale;
+	panel->border_bottom = insetBottom * borderScale;
+
+	panel->tex_u = source.x / textureWidth;
+	panel->tex_v = source.y / textureHeight;
+	panel->tex_w = source.w / textureWidth;
+	panel->tex_h = source.h / textureHeight;
+
+	panel->tex_border_left = insetLeft / textureWidth;
+	panel->tex_border_top = insetTop / textureHeight;
+	panel->tex_border_right = insetRight / textureWidth;
+	panel->tex_border_bottom = insetBottom / textureHeight;
+
+	panel->r = 1.0f;
+	panel->g = 1.0f;
+	panel->b = 1.0f;
+	panel->a = 1.0f;
+}
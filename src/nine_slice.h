@@ -0,0 +1,45 @@
+#pragma once
+#ifndef SDL_SAMPLE_NINE_SLICE_H
+#define SDL_SAMPLE_NINE_SLICE_H
+
+#include <SDL3/SDL.h>
+#include "sprite_layer.h"
+
+// Each panel is expanded by NineSlice.vert into a 4x4 vertex grid, drawn as
+// 9 quads of 6 vertices. Only the center row and column stretch.
+#define NINE_SLICE_VERTEX_COUNT (9 * 6)
+
+// Mirrors PanelData in NineSlice.vert.hlsl
+typedef struct NineSliceInstance
+{
+	float x, y;
+	float w, h;
+	float border_left, border_top, border_right, border_bottom;                  // on screen
+	float tex_u, tex_v, tex_w, tex_h;
+	float tex_border_left, tex_border_top, tex_border_right, tex_border_bottom;  // in UV units
+	float r, g, b, a;
+} NineSliceInstance;
+
+// Creates a SpriteLayer that holds NineSliceInstance records.
+inline bool NineSlice_InitLayer(SpriteLayer* layer, SDL_GPUDevice* device, SpriteLayerUsage usage, Uint32 capacity)
+{
+	return SpriteLayer_InitFormat(layer, device, usage, capacity, sizeof(NineSliceInstance), NINE_SLICE_VERTEX_COUNT);
+}
+
+// Fills a panel from a source rect and its border insets, both in texels of a
+// textureWidth x textureHeight texture. Borders are drawn at `borderScale`
+// screen pixels per texel, the white tint is left to the caller to change.
+void NineSlice_Set(
+	NineSliceInstance* panel,
+	SDL_FRect dest,
+	SDL_FRect source,
+	float insetLeft,
+	float insetTop,
+	float insetRight,
+	float insetBottom,
+	float textureWidth,
+	float textureHeight,
+	float borderScale
+);
+
+#endif
@@ -0,0 +1,197 @@
+#include "options.h"
+#include "lighting.h"
+
+static bool ParseUint(const char* flag, const char* value, Uint32 min, Uint32 max, Uint32* result)
+{
+	if (value == NULL)
+	{
+		SDL_Log("%s expects a value", flag);
+		return false;
+	}
+	char* end;
+	const long parsed = SDL_strtol(value, &end, 10);
+	if (*end != '\0' || parsed < (long)min || parsed > (long)max)
+	{
+		SDL_Log("%s expects a number between %u and %u, got '%s'", flag, min, max, value);
+		return false;
+	}
+	*result = (Uint32)parsed;
+	return true;
+}
+
+static bool ParseFloat(const char* flag, const char* value, float min, float max, float* result)
+{
+	if (value == NULL)
+	{
+		SDL_Log("%s expects a value", flag);
+		return false;
+	}
+	char* end;
+	const double parsed = SDL_strtod(value, &end);
+	if (*end != '\0' || parsed < min || parsed > max)
+	{
+		SDL_Log("%s expects a number between %g and %g, got '%s'", flag, min, max, value);
+		return false;
+	}
+	*result = (float)parsed;
+	return true;
+}
+
+bool Options_Parse(AppOptions* options, int argc, char* argv[])
+{
+	*options = AppOptions{};
+	options->uploadBudgetKiB = 1024;
+	options->textureBudgetMiB = 256;
+	options->lightsPerTile = LIGHT_DEFAULT_MAX_PER_TILE;
+
+	for (int i = 1; i < argc; i += 1)
+	{
+		const char* arg = argv[i];
+		const char* value = i + 1 < argc ? argv[i + 1] : NULL;
+
+		if (SDL_strcmp(arg, "--low-latency") == 0)
+		{
+			options->lowLatency = true;
+		}
+		else if (SDL_strcmp(arg, "--frames-in-flight") == 0)
+		{
+			if (!ParseUint(arg, value, 1, 3, &options->framesInFlight))
+			{
+				return false;
+			}
+			i += 1;
+		}
+		else if (SDL_strcmp(arg, "--latency-probe") == 0)
+		{
+			options->latencyProbe = true;
+		}
+		else if (SDL_strcmp(arg, "--dynamic-resolution") == 0)
+		{
+			if (!ParseFloat(arg, value, 1.0f, 1000.0f, &options->dynamicResolutionMs))
+			{
+				return false;
+			}
+			i += 1;
+		}
+		else if (SDL_strcmp(arg, "--idle-aware") == 0)
+		{
+			options->idleAware = true;
+		}
+		else if (SDL_strcmp(arg, "--instanced") == 0)
+		{
+			options->instancedSprites = true;
+		}
+		else if (SDL_strcmp(arg, "--benchmark-sprite-paths") == 0)
+		{
+			options->benchmarkSpritePaths = true;
+		}
+		else if (SDL_strcmp(arg, "--packed-sprites") == 0)
+		{
+			options->packedSprites = true;
+		}
+		else if (SDL_strcmp(arg, "--upload-budget") == 0)
+		{
+			if (!ParseUint(arg, value, 0, 1024 * 1024, &options->uploadBudgetKiB))
+			{
+				return false;
+			}
+			i += 1;
+		}
+		else if (SDL_strcmp(arg, "--texture-budget") == 0)
+		{
+			if (!ParseUint(arg, value, 1, 64 * 1024, &options->textureBudgetMiB))
+			{
+				return false;
+			}
+			i += 1;
+		}
+		else if (SDL_strcmp(arg, "--virtual-texture") == 0)
+		{
+			options->virtualTexture = true;
+		}
+		else if (SDL_strcmp(arg, "--picking") == 0)
+		{
+			options->picking = true;
+		}
+		else if (SDL_strcmp(arg, "--broadphase") == 0)
+		{
+			if (!ParseUint(arg, value, 1, 1 << 24, &options->broadphaseSprites))
+			{
+				return false;
+			}
+			i += 1;
+		}
+		else if (SDL_strcmp(arg, "--ecs") == 0)
+		{
+			options->ecs = true;
+		}
+		else if (SDL_strcmp(arg, "--async-acquire") == 0)
+		{
+			options->asyncAcquire = true;
+		}
+		else if (SDL_strcmp(arg, "--lights") == 0)
+		{
+			if (!ParseUint(arg, value, 1, 1 << 16, &options->lightCount))
+			{
+				return false;
+			}
+			i += 1;
+		}
+		else if (SDL_strcmp(arg, "--lights-per-tile") == 0)
+		{
+			if (!ParseUint(arg, value, 1, 4096, &options->lightsPerTile))
+			{
+				return false;
+			}
+			i += 1;
+		}
+		else if (SDL_strcmp(arg, "--gpu-sort") == 0)
+		{
+			options->gpuSort = true;
+		}
+		else if (SDL_strcmp(arg, "--trace") == 0)
+		{
+			if (value == NULL)
+			{
+				SDL_Log("%s expects a file name", arg);
+				return false;
+			}
+			options->tracePath = value;
+			i += 1;
+		}
+		else if (SDL_strcmp(arg, "--seed") == 0)
+		{
+			if (!ParseUint(arg, value, 0, SDL_MAX_SINT32, &options->seed))
+			{
+				return false;
+			}
+			i += 1;
+		}
+		else if (SDL_strcmp(arg, "--frame-budget") == 0)
+		{
+			if (!ParseFloat(arg, value, 1.0f, 1000.0f, &options->frameBudgetMs))
+			{
+				return false;
+			}
+			i += 1;
+		}
+		else
+		{
+			// Platforms may pass their own arguments (e.g. macOS -psn_*), so just note it
+			SDL_Log("Ignoring unknown argument '%s'", arg);
+		}
+	}
+
+	// The instanced path reads the vertex layout of SpriteInstance, which packed layers don't have
+	if (options->packedSprites && (options->instancedSprites || options->benchmarkSpritePaths))
+	{
+		SDL_Log("--packed-sprites only works with the pulling sprite path");
+		return false;
+	}
+
+	if (options->lowLatency && options->framesInFlight == 0)
+	{
+		options->framesInFlight = 1;
+	}
+	return true;
+}
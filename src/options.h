@@ -0,0 +1,35 @@
+#pragma once
+#ifndef SDL_SAMPLE_OPTIONS_H
+#define SDL_SAMPLE_OPTIONS_H
+
+#include <SDL3/SDL.h>
+
+// Runtime switches, parsed from the command line in SDL_AppInit.
+typedef struct AppOptions
+{
+	bool lowLatency;            // --low-latency: sample input late, defaults to one frame in flight
+	Uint32 framesInFlight;      // --frames-in-flight <1-3>, 0 leaves SDL's default
+	bool latencyProbe;          // --latency-probe: draw a cursor probe and log input latency
+	float frameBudgetMs;        // --frame-budget <ms>: let the governor scale work to fit, 0 disables it
+	bool idleAware;             // --idle-aware: hold the scene still and only draw frames that changed
+	float dynamicResolutionMs;  // --dynamic-resolution <ms>: scale the render resolution to hit this frame time
+	bool instancedSprites;      // --instanced: feed sprites through an instance-rate vertex buffer instead of pulling
+	bool benchmarkSpritePaths;  // --benchmark-sprite-paths: alternate between pulling and instancing, logging both
+	bool packedSprites;         // --packed-sprites: store the static sprites as 36-byte PackedSpriteInstance records
+	Uint32 uploadBudgetKiB;     // --upload-budget <KiB>: uploads beyond the visible ones per frame, 0 for no limit
+	Uint32 textureBudgetMiB;    // --texture-budget <MiB>: GPU memory for streamed atlas pages
+	bool virtualTexture;        // --virtual-texture: draw extra sprites from a paged virtual texture
+	bool picking;               // --picking: log the sprite under the mouse, read back from a GPU id buffer
+	Uint32 broadphaseSprites;   // --broadphase <count>: time the collision broadphase over this many moving sprites
+	bool ecs;                   // --ecs: run the dynamic sprites as entities in an archetype ECS
+	bool asyncAcquire;          // --async-acquire: poll for the swapchain texture and work in the meantime instead of blocking
+	Uint32 lightCount;          // --lights <count>: light the scenery and dynamic sprites with this many point lights, binned into tiles
+	Uint32 lightsPerTile;       // --lights-per-tile <count>: the most lights one tile sums, those beyond are dropped
+	bool gpuSort;               // --gpu-sort: make the dynamic sprites translucent and draw them back to front, sorted on the GPU
+	const char* tracePath;      // --trace <file>: record a Chrome trace, written on exit and when F12 is pressed
+	Uint32 seed;                // --seed <n>: the seed the scene is generated from, 0 by default
+} AppOptions;
+
+bool Options_Parse(AppOptions* options, int argc, char* argv[]);
+
+#endif
@@ -0,0 +1,302 @@
+#include "random_stream.h"
+#include <SDL3/SDL_intrin.h>
+
+typedef enum RandomFillKind
+{
+	RANDOM_FILL_BITS,
+	RANDOM_FILL_FLOAT,
+	RANDOM_FILL_INT
+} RandomFillKind;
+
+// Floats take the top 24 bits, which they hold exactly
+static const float FLOAT_UNIT = 1.0f / 16777216.0f;
+
+static Uint64 SplitMix64(Uint64 x)
+{
+	x += 0x9E3779B97F4A7C15ull;
+	x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ull;
+	x = (x ^ (x >> 27)) * 0x94D049BB133111EBull;
+	return x ^ (x >> 31);
+}
+
+// triple32 by Chris Wellons: a 32-bit bijection with very little bias.
+// Every SIMD version below must compute exactly the same.
+static Uint32 Hash(Uint32 x)
+{
+	x ^= x >> 17;
+	x *= 0xED5AD4BBu;
+	x ^= x >> 11;
+	x *= 0xAC4C1B51u;
+	x ^= x >> 15;
+	x *= 0x31848BABu;
+	x ^= x >> 14;
+	return x;
+}
+
+// The counter's high word goes into the second round's key. Hash(0) is 0, so
+// the first 2^32 numbers only depend on keyHigh.
+static Uint32 HighKey(const RandomStream* stream, Uint64 counter)
+{
+	return stream->keyHigh ^ Hash((Uint32)(counter >> 32));
+}
+
+// Two rounds with a key half each, so streams aren't shifted copies of each other
+static Uint32 Value(const RandomStream* stream, Uint64 counter)
+{
+	return Hash(Hash((Uint32)counter + stream->keyLow) ^ HighKey(stream, counter));
+}
+
+static void Store(RandomFillKind kind, void* values, Uint32 i, Uint32 bits, Uint32 n)
+{
+	switch (kind)
+	{
+	case RANDOM_FILL_BITS:
+		((Uint32*)values)[i] = bits;
+		break;
+	case RANDOM_FILL_FLOAT:
+		((float*)values)[i] = (float)(bits >> 8) * FLOAT_UNIT;
+		break;
+	case RANDOM_FILL_INT:
+		// the same mapping as SDL_rand
+		((Sint32*)values)[i] = (Sint32)(((Uint64)bits * n) >> 32);
+		break;
+	}
+}
+
+#if defined(SDL_SSE2_INTRINSICS)
+// SSE2 has no 32-bit multiply, so the even and odd lanes go through 64-bit ones
+static __m128i MulLow4(__m128i a, __m128i b)
+{
+	const __m128i even = _mm_mul_epu32(a, b);
+	const __m128i odd = _mm_mul_epu32(_mm_srli_epi64(a, 32), _mm_srli_epi64(b, 32));
+	return _mm_or_si128(_mm_and_si128(even, _mm_set_epi32(0, -1, 0, -1)), _mm_slli_epi64(odd, 32));
+}
+
+static __m128i MulHigh4(__m128i a, __m128i b)
+{
+	const __m128i even = _mm_mul_epu32(a, b);
+	const __m128i odd = _mm_mul_epu32(_mm_srli_epi64(a, 32), _mm_srli_epi64(b, 32));
+	return _mm_or_si128(_mm_srli_epi64(even, 32), _mm_and_si128(odd, _mm_set_epi32(-1, 0, -1, 0)));
+}
+
+static __m128i Hash4(__m128i x)
+{
+	x = _mm_xor_si128(x, _mm_srli_epi32(x, 17));
+	x = MulLow4(x, _mm_set1_epi32((int)0xED5AD4BBu));
+	x = _mm_xor_si128(x, _mm_srli_epi32(x, 11));
+	x = MulLow4(x, _mm_set1_epi32((int)0xAC4C1B51u));
+	x = _mm_xor_si128(x, _mm_srli_epi32(x, 15));
+	x = MulLow4(x, _mm_set1_epi32((int)0x31848BABu));
+	x = _mm_xor_si128(x, _mm_srli_epi32(x, 14));
+	return x;
+}
+
+static Uint32 FillSSE2(const RandomStream* stream, RandomFillKind kind, void* values, Uint32 count, Uint32 n)
+{
+	const __m128i keyLow = _mm_set1_epi32((int)stream->keyLow);
+	const __m128i keyHigh = _mm_set1_epi32((int)HighKey(stream, stream->counter));
+	const __m128i lanes = _mm_setr_epi32(0, 1, 2, 3);
+	Uint32 i = 0;
+	for (; i + 4 <= count; i += 4)
+	{
+		const __m128i counter = _mm_add_epi32(_mm_set1_epi32((int)(Uint32)(stream->counter + i)), lanes);
+		const __m128i bits = Hash4(_mm_xor_si128(Hash4(_mm_add_epi32(counter, keyLow)), keyHigh));
+		switch (kind)
+		{
+		case RANDOM_FILL_BITS:
+			_mm_storeu_si128((__m128i*)&((Uint32*)values)[i], bits);
+			break;
+		case RANDOM_FILL_FLOAT:
+			_mm_storeu_ps(&((float*)values)[i], _mm_mul_ps(_mm_cvtepi32_ps(_mm_srli_epi32(bits, 8)), _mm_set1_ps(FLOAT_UNIT)));
+			break;
+		case RANDOM_FILL_INT:
+			_mm_storeu_si128((__m128i*)&((Sint32*)values)[i], MulHigh4(bits, _mm_set1_epi32((int)n)));
+			break;
+		}
+	}
+	return i;
+}
+#endif
+
+#if defined(SDL_AVX2_INTRINSICS)
+SDL_TARGETING("avx2") static __m256i MulHigh8(__m256i a, __m256i b)
+{
+	const __m256i even = _mm256_mul_epu32(a, b);
+	const __m256i odd = _mm256_mul_epu32(_mm256_srli_epi64(a, 32), _mm256_srli_epi64(b, 32));
+	return _mm256_blend_epi32(_mm256_srli_epi64(even, 32), odd, 0xAA);
+}
+
+SDL_TARGETING("avx2") static __m256i Hash8(__m256i x)
+{
+	x = _mm256_xor_si256(x, _mm256_srli_epi32(x, 17));
+	x = _mm256_mullo_epi32(x, _mm256_set1_epi32((int)0xED5AD4BBu));
+	x = _mm256_xor_si256(x, _mm256_srli_epi32(x, 11));
+	x = _mm256_mullo_epi32(x, _mm256_set1_epi32((int)0xAC4C1B51u));
+	x = _mm256_xor_si256(x, _mm256_srli_epi32(x, 15));
+	x = _mm256_mullo_epi32(x, _mm256_set1_epi32((int)0x31848BABu));
+	x = _mm256_xor_si256(x, _mm256_srli_epi32(x, 14));
+	return x;
+}
+
+SDL_TARGETING("avx2") static Uint32 FillAVX2(const RandomStream* stream, RandomFillKind kind, void* values, Uint32 count, Uint32 n)
+{
+	const __m256i keyLow = _mm256_set1_epi32((int)stream->keyLow);
+	const __m256i keyHigh = _mm256_set1_epi32((int)HighKey(stream, stream->counter));
+	const __m256i lanes = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+	Uint32 i = 0;
+	for (; i + 8 <= count; i += 8)
+	{
+		const __m256i counter = _mm256_add_epi32(_mm256_set1_epi32((int)(Uint32)(stream->counter + i)), lanes);
+		const __m256i bits = Hash8(_mm256_xor_si256(Hash8(_mm256_add_epi32(counter, keyLow)), keyHigh));
+		switch (kind)
+		{
+		case RANDOM_FILL_BITS:
+			_mm256_storeu_si256((__m256i*)&((Uint32*)values)[i], bits);
+			break;
+		case RANDOM_FILL_FLOAT:
+			_mm256_storeu_ps(&((float*)values)[i], _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_srli_epi32(bits, 8)), _mm256_set1_ps(FLOAT_UNIT)));
+			break;
+		case RANDOM_FILL_INT:
+			_mm256_storeu_si256((__m256i*)&((Sint32*)values)[i], MulHigh8(bits, _mm256_set1_epi32((int)n)));
+			break;
+		}
+	}
+	return i;
+}
+
+static bool UseAVX2(void)
+{
+	static const bool hasAVX2 = SDL_HasAVX2();
+	return hasAVX2;
+}
+#endif
+
+#if defined(SDL_NEON_INTRINSICS)
+static uint32x4_t Hash4(uint32x4_t x)
+{
+	x = veorq_u32(x, vshrq_n_u32(x, 17));
+	x = vmulq_n_u32(x, 0xED5AD4BBu);
+	x = veorq_u32(x, vshrq_n_u32(x, 11));
+	x = vmulq_n_u32(x, 0xAC4C1B51u);
+	x = veorq_u32(x, vshrq_n_u32(x, 15));
+	x = vmulq_n_u32(x, 0x31848BABu);
+	x = veorq_u32(x, vshrq_n_u32(x, 14));
+	return x;
+}
+
+static Uint32 FillNEON(const RandomStream* stream, RandomFillKind kind, void* values, Uint32 count, Uint32 n)
+{
+	static const Uint32 laneOffsets[4] = { 0, 1, 2, 3 };
+	const uint32x4_t lanes = vld1q_u32(laneOffsets);
+	const uint32x4_t keyHigh = vdupq_n_u32(HighKey(stream, stream->counter));
+	Uint32 i = 0;
+	for (; i + 4 <= count; i += 4)
+	{
+		const uint32x4_t counter = vaddq_u32(vdupq_n_u32((Uint32)(stream->counter + i) + stream->keyLow), lanes);
+		const uint32x4_t bits = Hash4(veorq_u32(Hash4(counter), keyHigh));
+		switch (kind)
+		{
+		case RANDOM_FILL_BITS:
+			vst1q_u32(&((Uint32*)values)[i], bits);
+			break;
+		case RANDOM_FILL_FLOAT:
+			vst1q_f32(&((float*)values)[i], vmulq_n_f32(vcvtq_f32_u32(vshrq_n_u32(bits, 8)), FLOAT_UNIT));
+			break;
+		case RANDOM_FILL_INT:
+			vst1q_s32(&((Sint32*)values)[i], vreinterpretq_s32_u32(vcombine_u32(
+				vshrn_n_u64(vmull_n_u32(vget_low_u32(bits), n), 32),
+				vshrn_n_u64(vmull_n_u32(vget_high_u32(bits), n), 32)
+			)));
+			break;
+		}
+	}
+	return i;
+}
+#endif
+
+// Fills as much as the widest available SIMD path can, then finishes one at a
+// time. The SIMD paths take the high word of the counter as fixed, so the
+// range must not cross a multiple of 2^32.
+static void FillRange(RandomStream* stream, RandomFillKind kind, void* values, Uint32 count, Uint32 n)
+{
+	Uint32 i = 0;
+#if defined(SDL_AVX2_INTRINSICS)
+	if (UseAVX2())
+	{
+		i = FillAVX2(stream, kind, values, count, n);
+	}
+#endif
+#if defined(SDL_SSE2_INTRINSICS)
+	if (i == 0)
+	{
+		i = FillSSE2(stream, kind, values, count, n);
+	}
+#elif defined(SDL_NEON_INTRINSICS)
+	i = FillNEON(stream, kind, values, count, n);
+#endif
+	for (; i < count; i += 1)
+	{
+		Store(kind, values, i, Value(stream, stream->counter + i), n);
+	}
+	stream->counter += count;
+}
+
+static void Fill(RandomStream* stream, RandomFillKind kind, void* values, Uint32 count, Uint32 n)
+{
+	// Every kind stores 4 bytes per number
+	Uint8* next = (Uint8*)values;
+	while (count > 0)
+	{
+		const Uint64 untilWrap = 0x100000000ull - (Uint32)stream->counter;
+		const Uint32 rangeCount = (Uint32)SDL_min((Uint64)count, untilWrap);
+		FillRange(stream, kind, next, rangeCount, n);
+		next += (size_t)rangeCount * sizeof(Uint32);
+		count -= rangeCount;
+	}
+}
+
+RandomStream RandomStream_Create(Uint64 seed, Uint32 streamIndex)
+{
+	const Uint64 key = SplitMix64(seed ^ SplitMix64(streamIndex));
+	return RandomStream{
+		.keyLow = (Uint32)key,
+		.keyHigh = (Uint32)(key >> 32),
+		.counter = 0
+	};
+}
+
+Uint32 RandomStream_Next(RandomStream* stream)
+{
+	const Uint32 bits = Value(stream, stream->counter);
+	stream->counter += 1;
+	return bits;
+}
+
+float RandomStream_NextFloat(RandomStream* stream)
+{
+	float value;
+	Store(RANDOM_FILL_FLOAT, &value, 0, RandomStream_Next(stream), 0);
+	return value;
+}
+
+Sint32 RandomStream_NextInt(RandomStream* stream, Sint32 n)
+{
+	Sint32 value;
+	Store(RANDOM_FILL_INT, &value, 0, RandomStream_Next(stream), (Uint32)n);
+	return value;
+}
+
+void RandomStream_Fill(RandomStream* stream, Uint32* values, Uint32 count)
+{
+	Fill(stream, RANDOM_FILL_BITS, values, count, 0);
+}
+
+void RandomStream_FillFloat(RandomStream* stream, float* values, Uint32 count)
+{
+	Fill(stream, RANDOM_FILL_FLOAT, values, count, 0);
+}
+
+void RandomStream_FillInt(RandomStream* stream, Sint32* values, Uint32 count, Sint32 n)
+{
+	Fill(stream, RANDOM_FILL_INT, values, count, (Uint32)n);
+}
@@ -0,0 +1,48 @@
+#pragma once
+#ifndef SDL_SAMPLE_RANDOM_STREAM_H
+#define SDL_SAMPLE_RANDOM_STREAM_H
+
+#include <SDL3/SDL.h>
+
+// A counter-based random number generator. The nth number of a stream is a
+// hash of the stream's key and n, so there is no state to carry from one
+// number to the next:
+// - bulk fills compute 4 or 8 numbers at once with SIMD (8 with AVX2, picked at runtime)
+// - skipping ahead is just adding to the counter
+// - threads filling parts of one array can each skip to their own part, and
+//   the array comes out the same however it was split
+// Streams created from the same seed with different indices are independent.
+// The counter is 64 bits, so a stream never runs out in practice.
+//
+// A fill gives the same numbers, bit for bit, as the matching RandomStream_Next*
+// called the same number of times.
+typedef struct RandomStream
+{
+	Uint32 keyLow, keyHigh;
+	Uint64 counter;
+} RandomStream;
+
+RandomStream RandomStream_Create(Uint64 seed, Uint32 streamIndex);
+
+// Jumps over the next `count` numbers
+static inline void RandomStream_Skip(RandomStream* stream, Uint64 count)
+{
+	stream->counter += count;
+}
+
+Uint32 RandomStream_Next(RandomStream* stream);
+
+// In [0, 1), like SDL_randf
+float RandomStream_NextFloat(RandomStream* stream);
+
+// In [0, n), like SDL_rand
+Sint32 RandomStream_NextInt(RandomStream* stream, Sint32 n);
+
+void RandomStream_Fill(RandomStream* stream, Uint32* values, Uint32 count);
+// In [0, 1). Scaling is left to the caller, so the floats stay exactly
+// the same whichever path computed them.
+void RandomStream_FillFloat(RandomStream* stream, float* values, Uint32 count);
+// In [0, n)
+void RandomStream_FillInt(RandomStream* stream, Sint32* values, Uint32 count, Sint32 n);
+
+#endif
@@ -0,0 +1,283 @@
+#include "sdf_font.h"
+#include <SDL3_ttf/SDL_ttf.h>
+
+#define SDF_FONT_CACHE_MAGIC 0x46464453  // "SDFF"
+#define SDF_FONT_CACHE_VERSION 1
+
+// Followed by the glyphs, then one distance byte per atlas texel
+typedef struct SdfFontCacheHeader
+{
+	Uint32 magic;
+	Uint32 version;
+	Uint64 fontBytes;
+	SDL_Time fontModified;
+	Uint32 renderSize;
+	Uint32 glyphCount;
+	Uint32 atlasWidth;
+	Uint32 atlasHeight;
+	float lineHeight;
+	Uint32 padding;
+} SdfFontCacheHeader;
+
+// Returns the atlas' distances, or NULL if the cache is missing or was made from another font
+static Uint8* ReadCache(SdfFont* font, const char* cachePath, const SDL_PathInfo* fontInfo)
+{
+	size_t size = 0;
+	Uint8* data = (Uint8*)SDL_LoadFile(cachePath, &size);
+	if (data == NULL)
+	{
+		return NULL;
+	}
+
+	SdfFontCacheHeader header;
+	const size_t glyphsOffset = sizeof(SdfFontCacheHeader);
+	const size_t distancesOffset = glyphsOffset + sizeof(font->glyphs);
+	if (size >= distancesOffset)
+	{
+		SDL_memcpy(&header, data, sizeof(header));
+	}
+	if (size < distancesOffset ||
+		header.magic != SDF_FONT_CACHE_MAGIC ||
+		header.version != SDF_FONT_CACHE_VERSION ||
+		header.fontBytes != fontInfo->size ||
+		header.fontModified != fontInfo->modify_time ||
+		header.renderSize != SDF_FONT_RENDER_SIZE ||
+		header.glyphCount != SDF_FONT_GLYPH_COUNT ||
+		size != distancesOffset + (size_t)header.atlasWidth * header.atlasHeight)
+	{
+		SDL_free(data);
+		return NULL;
+	}
+
+	Uint8* distances = (Uint8*)SDL_malloc((size_t)header.atlasWidth * header.atlasHeight);
+	if (distances != NULL)
+	{
+		font->atlasWidth = header.atlasWidth;
+		font->atlasHeight = header.atlasHeight;
+		font->lineHeight = header.lineHeight;
+		SDL_memcpy(font->glyphs, data + glyphsOffset, sizeof(font->glyphs));
+		SDL_memcpy(distances, data + distancesOffset, (size_t)header.atlasWidth * header.atlasHeight);
+	}
+	SDL_free(data);
+	return distances;
+}
+
+static void WriteCache(const SdfFont* font, const char* cachePath, const SDL_PathInfo* fontInfo, const Uint8* distances)
+{
+	const size_t atlasBytes = (size_t)font->atlasWidth * font->atlasHeight;
+	const size_t size = sizeof(SdfFontCacheHeader) + sizeof(font->glyphs) + atlasBytes;
+	Uint8* data = (Uint8*)SDL_malloc(size);
+	if (data == NULL)
+	{
+		return;
+	}
+
+	const SdfFontCacheHeader header = {
+		.magic = SDF_FONT_CACHE_MAGIC,
+		.version = SDF_FONT_CACHE_VERSION,
+		.fontBytes = fontInfo->size,
+		.fontModified = fontInfo->modify_time,
+		.renderSize = SDF_FONT_RENDER_SIZE,
+		.glyphCount = SDF_FONT_GLYPH_COUNT,
+		.atlasWidth = font->atlasWidth,
+		.atlasHeight = font->atlasHeight,
+		.lineHeight = font->lineHeight,
+	};
+	SDL_memcpy(data, &header, sizeof(header));
+	SDL_memcpy(data + sizeof(header), font->glyphs, sizeof(font->glyphs));
+	SDL_memcpy(data + sizeof(header) + sizeof(font->glyphs), distances, atlasBytes);
+
+	// Only costs the next run the generation again
+	if (!SDL_SaveFile(cachePath, data, size))
+	{
+		SDL_Log("Couldn't write the font cache %s: %s", cachePath, SDL_GetError());
+	}
+	SDL_free(data);
+}
+
+// Renders every glyph's distance field and packs them into rows of the atlas
+static Uint8* GenerateAtlas(SdfFont* font, const char* fontPath)
+{
+	TTF_Font* ttf = TTF_OpenFont(fontPath, SDF_FONT_RENDER_SIZE);
+	if (ttf == NULL)
+	{
+		SDL_Log("Couldn't open %s: %s", fontPath, SDL_GetError());
+		return NULL;
+	}
+	if (!TTF_SetFontSDF(ttf, true))
+	{
+		SDL_Log("Couldn't render %s as distance fields: %s", fontPath, SDL_GetError());
+		TTF_CloseFont(ttf);
+		return NULL;
+	}
+	font->lineHeight = (float)TTF_GetFontHeight(ttf);
+
+	SDL_Surface* cells[SDF_FONT_GLYPH_COUNT] = {};
+	int cellX[SDF_FONT_GLYPH_COUNT] = {};
+	int cellY[SDF_FONT_GLYPH_COUNT] = {};
+	int penX = SDF_FONT_PADDING;
+	int penY = SDF_FONT_PADDING;
+	int rowHeight = 0;
+	for (Uint32 i = 0; i < SDF_FONT_GLYPH_COUNT; i += 1)
+	{
+		const Uint32 ch = SDF_FONT_FIRST_CHAR + i;
+		int advance = 0;
+		TTF_GetGlyphMetrics(ttf, ch, NULL, NULL, NULL, NULL, &advance);
+		font->glyphs[i].advance = (float)advance;
+
+		// Blank glyphs like the space have no surface, only an advance
+		SDL_Surface* cell = TTF_RenderGlyph_Blended(ttf, ch, SDL_Color{ 255, 255, 255, 255 });
+		if (cell != NULL && cell->format != SDL_PIXELFORMAT_ABGR8888)
+		{
+			SDL_Surface* converted = SDL_ConvertSurface(cell, SDL_PIXELFORMAT_ABGR8888);
+			SDL_DestroySurface(cell);
+			cell = converted;
+		}
+		if (cell == NULL || cell->w == 0 || cell->h == 0 || cell->w + SDF_FONT_PADDING * 2 > SDF_FONT_ATLAS_WIDTH)
+		{
+			SDL_DestroySurface(cell);
+			continue;
+		}
+
+		if (penX + cell->w + SDF_FONT_PADDING > SDF_FONT_ATLAS_WIDTH)
+		{
+			penX = SDF_FONT_PADDING;
+			penY += rowHeight + SDF_FONT_PADDING;
+			rowHeight = 0;
+		}
+		cells[i] = cell;
+		cellX[i] = penX;
+		cellY[i] = penY;
+		penX += cell->w + SDF_FONT_PADDING;
+		rowHeight = SDL_max(rowHeight, cell->h);
+	}
+	TTF_CloseFont(ttf);
+
+	font->atlasWidth = SDF_FONT_ATLAS_WIDTH;
+	font->atlasHeight = 1;
+	while (font->atlasHeight < (Uint32)(penY + rowHeight + SDF_FONT_PADDING))
+	{
+		font->atlasHeight *= 2;
+	}
+
+	// Texels no glyph covers are as far outside as can be
+	Uint8* distances = (Uint8*)SDL_calloc(font->atlasWidth, font->atlasHeight);
+	for (Uint32 i = 0; i < SDF_FONT_GLYPH_COUNT; i += 1)
+	{
+		SDL_Surface* cell = cells[i];
+		if (cell == NULL)
+		{
+			continue;
+		}
+		if (distances != NULL)
+		{
+			for (int y = 0; y < cell->h; y += 1)
+			{
+				const Uint8* row = (const Uint8*)cell->pixels + y * cell->pitch;
+				Uint8* dest = distances + (cellY[i] + y) * font->atlasWidth + cellX[i];
+				for (int x = 0; x < cell->w; x += 1)
+				{
+					dest[x] = row[x * 4 + 3];
+				}
+			}
+		}
+		SdfGlyph* glyph = &font->glyphs[i];
+		glyph->u = (float)cellX[i] / font->atlasWidth;
+		glyph->v = (float)cellY[i] / font->atlasHeight;
+		glyph->w = (float)cell->w / font->atlasWidth;
+		glyph->h = (float)cell->h / font->atlasHeight;
+		glyph->width = (float)cell->w;
+		glyph->height = (float)cell->h;
+		SDL_DestroySurface(cell);
+	}
+	return distances;
+}
+
+bool SdfFont_Load(SdfFont* font, UploadScheduler* uploads, const char* fontPath, const char* cachePath)
+{
+	SDL_zerop(font);
+	SDL_PathInfo fontInfo;
+	if (!SDL_GetPathInfo(fontPath, &fontInfo))
+	{
+		SDL_Log("Couldn't find %s: %s", fontPath, SDL_GetError());
+		return false;
+	}
+
+	Uint8* distances = cachePath != NULL ? ReadCache(font, cachePath, &fontInfo) : NULL;
+	if (distances == NULL)
+	{
+		const Uint64 startNS = SDL_GetTicksNS();
+		distances = GenerateAtlas(font, fontPath);
+		if (distances == NULL)
+		{
+			return false;
+		}
+		SDL_Log("Generated %ux%u distance field atlas in %.1fms", font->atlasWidth, font->atlasHeight, (float)(SDL_GetTicksNS() - startNS) / SDL_NS_PER_MS);
+		if (cachePath != NULL)
+		{
+			WriteCache(font, cachePath, &fontInfo, distances);
+		}
+	}
+
+	// White texels, so the instance color tints the text, with the distance as alpha
+	SDL_Surface* atlas = SDL_CreateSurface(font->atlasWidth, font->atlasHeight, SDL_PIXELFORMAT_ABGR8888);
+	if (atlas == NULL)
+	{
+		SDL_free(distances);
+		return false;
+	}
+	for (Uint32 y = 0; y < font->atlasHeight; y += 1)
+	{
+		Uint8* row = (Uint8*)atlas->pixels + y * atlas->pitch;
+		for (Uint32 x = 0; x < font->atlasWidth; x += 1)
+		{
+			row[x * 4 + 0] = 255;
+			row[x * 4 + 1] = 255;
+			row[x * 4 + 2] = 255;
+			row[x * 4 + 3] = distances[y * font->atlasWidth + x];
+		}
+	}
+	SDL_free(distances);
+
+	font->atlas = UploadScheduler_CreateTexture(uploads, atlas, UPLOAD_PRIORITY_VISIBLE);
+	SDL_DestroySurface(atlas);
+	return font->atlas != NULL;
+}
+
+void SdfFont_Release(SdfFont* font, SDL_GPUDevice* device)
+{
+	SDL_ReleaseGPUTexture(device, font->atlas);
+	font->atlas = NULL;
+}
+
+Uint32 SdfFont_Layout(const SdfFont* font, const char* text, float x, float y, float size, SDL_FColor color, SpriteInstance* sprites, Uint32 capacity)
+{
+	const float scale = size / SDF_FONT_RENDER_SIZE;
+	Uint32 count = 0;
+	for (const char* c = text; *c != '\0'; c += 1)
+	{
+		Uint32 ch = (Uint8)*c;
+		if (ch < SDF_FONT_FIRST_CHAR || ch > SDF_FONT_LAST_CHAR)
+		{
+			ch = '?';
+		}
+		const SdfGlyph* glyph = &font->glyphs[ch - SDF_FONT_FIRST_CHAR];
+		if (glyph->width > 0 && count < capacity)
+		{
+			sprites[count] = SpriteInstance{
+				.x = x,
+				.y = y,
+				.w = glyph->width * scale,
+				.h = glyph->height * scale,
+				.tex_u = glyph->u,
+				.tex_v = glyph->v,
+				.tex_w = glyph->w,
+				.tex_h = glyph->h,
+				.r = color.r, .g = color.g, .b = color.b, .a = color.a,
+			};
+			count += 1;
+		}
+		x += glyph->advance * scale;
+	}
+	return count;
+}
@@ -0,0 +1,52 @@
+#pragma once
+#ifndef SDL_SAMPLE_SDF_FONT_H
+#define SDL_SAMPLE_SDF_FONT_H
+
+#include <SDL3/SDL.h>
+#include "sprite_layer.h"
+#include "upload_scheduler.h"
+
+// Printable ASCII, anything else is drawn as '?'
+#define SDF_FONT_FIRST_CHAR 32
+#define SDF_FONT_LAST_CHAR 126
+#define SDF_FONT_GLYPH_COUNT (SDF_FONT_LAST_CHAR - SDF_FONT_FIRST_CHAR + 1)
+// The point size glyphs are rendered at. Distances scale, so text of any size
+// is drawn from this one atlas.
+#define SDF_FONT_RENDER_SIZE 48
+#define SDF_FONT_ATLAS_WIDTH 512
+// Empty texels between glyphs, so filtering never reaches a neighbor
+#define SDF_FONT_PADDING 2
+
+typedef struct SdfGlyph
+{
+	float u, v, w, h;     // in the atlas
+	float width, height;  // in pixels at SDF_FONT_RENDER_SIZE, 0 for glyphs with nothing to draw
+	float advance;
+} SdfGlyph;
+
+// A signed distance field atlas of a font's glyphs, drawn with
+// SPRITE_FEATURE_SDF. SDL_ttf renders each glyph's distance to its outline
+// once, and the atlas is cached on disk, keyed by the font file's size and
+// modification time, so later runs only read it back.
+//
+// Glyphs are laid out as SDL_ttf renders them: cells as tall as the font,
+// with the baseline at its ascent.
+typedef struct SdfFont
+{
+	SDL_GPUTexture* atlas;  // distances in alpha, 0.5 on the outline
+	Uint32 atlasWidth;
+	Uint32 atlasHeight;
+	float lineHeight;       // at SDF_FONT_RENDER_SIZE
+	SdfGlyph glyphs[SDF_FONT_GLYPH_COUNT];
+} SdfFont;
+
+// Reads the atlas from cachePath, or generates it and writes it there if it is
+// missing or stale. cachePath may be NULL to always generate.
+bool SdfFont_Load(SdfFont* font, UploadScheduler* uploads, const char* fontPath, const char* cachePath);
+void SdfFont_Release(SdfFont* font, SDL_GPUDevice* device);
+
+// Writes one sprite per visible glyph of a line of text at `size` points, with
+// its top left at (x, y). Returns the number of sprites written.
+Uint32 SdfFont_Layout(const SdfFont* font, const char* text, float x, float y, float size, SDL_FColor color, SpriteInstance* sprites, Uint32 capacity);
+
+#endif
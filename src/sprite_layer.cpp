@@ -0,0 +1,157 @@
+#include "sprite_layer.h"
+#include <cstddef>
+
+bool SpriteLayer_Init(SpriteLayer* layer, SDL_GPUDevice* device, SpriteLayerUsage usage, Uint32 capacity)
+{
+	return SpriteLayer_InitFormat(layer, device, usage, capacity, sizeof(SpriteInstance), 6);
+}
+
+bool SpriteLayer_InitFormat(
+	SpriteLayer* layer,
+	SDL_GPUDevice* device,
+	SpriteLayerUsage usage,
+	Uint32 capacity,
+	Uint32 instanceSize,
+	Uint32 verticesPerInstance
+) {
+	layer->usage = usage;
+	layer->instanceSize = instanceSize;
+	layer->verticesPerInstance = verticesPerInstance;
+	layer->capacity = capacity;
+	layer->count = 0;
+	layer->dirty = false;
+
+	auto transferBufferCreateInfo = SDL_GPUTransferBufferCreateInfo{
+		.usage = SDL_GPU_TRANSFERBUFFERUSAGE_UPLOAD,
+		.size = capacity * instanceSize
+	};
+	layer->transferBuffer = SDL_CreateGPUTransferBuffer(device, &transferBufferCreateInfo);
+
+	auto bufferCreateInfo = SDL_GPUBufferCreateInfo{
+		// Readable both ways so layers can switch between pulling and instancing at runtime,
+		// and by compute passes such as GpuDepthSort
+		.usage = SDL_GPU_BUFFERUSAGE_GRAPHICS_STORAGE_READ | SDL_GPU_BUFFERUSAGE_VERTEX | SDL_GPU_BUFFERUSAGE_COMPUTE_STORAGE_READ,
+		.size = capacity * instanceSize
+	};
+	layer->buffer = SDL_CreateGPUBuffer(device, &bufferCreateInfo);
+
+	if (layer->transferBuffer == NULL || layer->buffer == NULL)
+	{
+		SDL_Log("Failed to create sprite layer buffers: %s", SDL_GetError());
+		SpriteLayer_Release(layer, device);
+		return false;
+	}
+	return true;
+}
+
+void SpriteLayer_Release(SpriteLayer* layer, SDL_GPUDevice* device)
+{
+	SDL_ReleaseGPUTransferBuffer(device, layer->transferBuffer);
+	SDL_ReleaseGPUBuffer(device, layer->buffer);
+	layer->transferBuffer = NULL;
+	layer->buffer = NULL;
+	layer->count = 0;
+}
+
+SpriteInstance* SpriteLayer_Map(SpriteLayer* layer, SDL_GPUDevice* device)
+{
+	SDL_assert(layer->instanceSize == sizeof(SpriteInstance));
+	return (SpriteInstance*)SpriteLayer_MapInstances(layer, device);
+}
+
+void* SpriteLayer_MapInstances(SpriteLayer* layer, SDL_GPUDevice* device)
+{
+	// Cycling hands us fresh staging memory if the previous contents are
+	// still waiting on an upload, so writers never stall on the GPU.
+	return SDL_MapGPUTransferBuffer(device, layer->transferBuffer, true);
+}
+
+void SpriteLayer_Unmap(SpriteLayer* layer, SDL_GPUDevice* device, Uint32 count)
+{
+	SDL_UnmapGPUTransferBuffer(device, layer->transferBuffer);
+	layer->count = SDL_min(count, layer->capacity);
+	layer->dirty = true;
+}
+
+Uint32 SpriteLayer_Upload(SpriteLayer* layer, UploadScheduler* scheduler)
+{
+	if (layer->count == 0 || (layer->usage == SPRITE_LAYER_STATIC && !layer->dirty))
+	{
+		return 0;
+	}
+
+	// Drawn this frame, so it can't wait. Everything the layer draws is replaced, which allows cycling.
+	const Uint32 size = layer->count * layer->instanceSize;
+	UploadScheduler_QueueBufferFrom(scheduler, layer->transferBuffer, 0, layer->buffer, 0, size, true, UPLOAD_PRIORITY_VISIBLE);
+
+	layer->dirty = false;
+	return size;
+}
+
+void SpriteLayer_Draw(const SpriteLayer* layer, SDL_GPURenderPass* renderPass, SDL_GPUBuffer* frameTable)
+{
+	if (layer->count == 0)
+	{
+		return;
+	}
+
+	SDL_GPUBuffer* vertexStorageBuffers[2] = { layer->buffer, frameTable };
+	SDL_BindGPUVertexStorageBuffers(renderPass, 0, vertexStorageBuffers, frameTable != NULL ? 2 : 1);
+	SDL_DrawGPUPrimitives(renderPass, layer->count * layer->verticesPerInstance, 1, 0, 0);
+}
+
+void SpriteLayer_DrawSorted(const SpriteLayer* layer, SDL_GPURenderPass* renderPass, SDL_GPUBuffer* frameTable, SDL_GPUBuffer* sortKeys)
+{
+	SDL_assert(frameTable != NULL);
+	if (layer->count == 0)
+	{
+		return;
+	}
+
+	SDL_GPUBuffer* vertexStorageBuffers[3] = { layer->buffer, frameTable, sortKeys };
+	SDL_BindGPUVertexStorageBuffers(renderPass, 0, vertexStorageBuffers, 3);
+	SDL_DrawGPUPrimitives(renderPass, layer->count * layer->verticesPerInstance, 1, 0, 0);
+}
+
+void SpriteLayer_DrawInstanced(const SpriteLayer* layer, SDL_GPURenderPass* renderPass, SDL_GPUBuffer* frameTable)
+{
+	SDL_assert(layer->instanceSize == sizeof(SpriteInstance));
+	if (layer->count == 0)
+	{
+		return;
+	}
+
+	SDL_GPUBufferBinding vertexBufferBinding = {
+		.buffer = layer->buffer,
+		.offset = 0
+	};
+	SDL_BindGPUVertexBuffers(renderPass, 0, &vertexBufferBinding, 1);
+	SDL_BindGPUVertexStorageBuffers(renderPass, 0, &frameTable, 1);
+	SDL_DrawGPUPrimitives(renderPass, 4, layer->count, 0, 0);
+}
+
+SDL_GPUVertexInputState SpriteLayer_InstanceVertexInput(void)
+{
+	static const SDL_GPUVertexBufferDescription vertexBufferDescription = {
+		.slot = 0,
+		.pitch = sizeof(SpriteInstance),
+		.input_rate = SDL_GPU_VERTEXINPUTRATE_INSTANCE,
+		.instance_step_rate = 0
+	};
+	static const SDL_GPUVertexAttribute vertexAttributes[] = {
+		{ 0, 0, SDL_GPU_VERTEXELEMENTFORMAT_FLOAT3, offsetof(SpriteInstance, x) },
+		{ 1, 0, SDL_GPU_VERTEXELEMENTFORMAT_FLOAT, offsetof(SpriteInstance, rotation) },
+		{ 2, 0, SDL_GPU_VERTEXELEMENTFORMAT_FLOAT2, offsetof(SpriteInstance, w) },
+		{ 3, 0, SDL_GPU_VERTEXELEMENTFORMAT_UINT, offsetof(SpriteInstance, animation) },
+		{ 4, 0, SDL_GPU_VERTEXELEMENTFORMAT_FLOAT, offsetof(SpriteInstance, animation_start) },
+		{ 5, 0, SDL_GPU_VERTEXELEMENTFORMAT_FLOAT4, offsetof(SpriteInstance, tex_u) },
+		{ 6, 0, SDL_GPU_VERTEXELEMENTFORMAT_FLOAT4, offsetof(SpriteInstance, r) },
+	};
+
+	return SDL_GPUVertexInputState{
+		.vertex_buffer_descriptions = &vertexBufferDescription,
+		.num_vertex_buffers = 1,
+		.vertex_attributes = vertexAttributes,
+		.num_vertex_attributes = SDL_arraysize(vertexAttributes)
+	};
+}
@@ -0,0 +1,81 @@
+#pragma once
+#ifndef SDL_SAMPLE_SPRITE_LAYER_H
+#define SDL_SAMPLE_SPRITE_LAYER_H
+
+#include <SDL3/SDL.h>
+#include "upload_scheduler.h"
+
+// Mirrors SpriteData in PullSpriteBatch.vert.hlsl
+typedef struct SpriteInstance
+{
+	float x, y, z;
+	float rotation;
+	float w, h;
+	Uint32 animation;       // Flipbook_Pack() result, 0 to use the tex_* rect
+	float animation_start;  // seconds, on the same clock as SpriteBatchUniforms::time
+	float tex_u, tex_v, tex_w, tex_h;
+	float r, g, b, a;
+} SpriteInstance;
+
+// Static layers are uploaded only after they were written to, dynamic layers
+// are streamed every frame whether or not anything changed.
+typedef enum SpriteLayerUsage
+{
+	SPRITE_LAYER_STATIC,
+	SPRITE_LAYER_DYNAMIC
+} SpriteLayerUsage;
+
+// A block of sprite instances with its own GPU buffer, drawn with the
+// vertex-pulling pipeline. Several layers can be drawn in one render pass.
+// Layers hold SpriteInstance records unless created with SpriteLayer_InitFormat.
+typedef struct SpriteLayer
+{
+	SpriteLayerUsage usage;
+	Uint32 instanceSize;
+	Uint32 verticesPerInstance;
+	Uint32 capacity;
+	Uint32 count;
+	bool dirty;
+	SDL_GPUBuffer* buffer;
+	SDL_GPUTransferBuffer* transferBuffer;
+} SpriteLayer;
+
+bool SpriteLayer_Init(SpriteLayer* layer, SDL_GPUDevice* device, SpriteLayerUsage usage, Uint32 capacity);
+bool SpriteLayer_InitFormat(
+	SpriteLayer* layer,
+	SDL_GPUDevice* device,
+	SpriteLayerUsage usage,
+	Uint32 capacity,
+	Uint32 instanceSize,
+	Uint32 verticesPerInstance
+);
+void SpriteLayer_Release(SpriteLayer* layer, SDL_GPUDevice* device);
+
+// Maps the layer's staging memory for writing. The whole layer is rewritten:
+// the caller fills the first `count` instances passed to SpriteLayer_Unmap.
+SpriteInstance* SpriteLayer_Map(SpriteLayer* layer, SDL_GPUDevice* device);
+void* SpriteLayer_MapInstances(SpriteLayer* layer, SDL_GPUDevice* device);
+void SpriteLayer_Unmap(SpriteLayer* layer, SDL_GPUDevice* device, Uint32 count);
+
+// Queues the upload, straight from the layer's staging memory, if the layer's
+// policy requires one this frame. Returns the number of bytes queued.
+Uint32 SpriteLayer_Upload(SpriteLayer* layer, UploadScheduler* scheduler);
+
+// Binds the layer's instances (plus the flipbook frame table, if given) and
+// draws them. The matching pipeline and its uniforms must already be bound.
+void SpriteLayer_Draw(const SpriteLayer* layer, SDL_GPURenderPass* renderPass, SDL_GPUBuffer* frameTable);
+
+// Like SpriteLayer_Draw, in the order of a sort buffer of (key, index) pairs
+// as GpuDepthSort_Record leaves it, with a SPRITE_FEATURE_SORTED pipeline bound.
+void SpriteLayer_DrawSorted(const SpriteLayer* layer, SDL_GPURenderPass* renderPass, SDL_GPUBuffer* frameTable, SDL_GPUBuffer* sortKeys);
+
+// The alternative to vertex pulling: the layer's buffer is bound as a
+// per-instance vertex buffer and each sprite is drawn as a 4-vertex strip.
+// Only valid for layers of SpriteInstance, with InstancedSpriteBatch.vert bound.
+void SpriteLayer_DrawInstanced(const SpriteLayer* layer, SDL_GPURenderPass* renderPass, SDL_GPUBuffer* frameTable);
+
+// Describes SpriteInstance as per-instance attributes in vertex buffer slot 0,
+// matching the Input struct of InstancedSpriteBatch.vert.hlsl.
+SDL_GPUVertexInputState SpriteLayer_InstanceVertexInput(void);
+
+#endif
@@ -0,0 +1,188 @@
+#include "sprite_permutations.h"
+#include <array>
+#include "common.h"
+#include "sprite_picking.h"
+
+static constexpr Uint32 VERTEX_FEATURES = SPRITE_FEATURE_ROTATION | SPRITE_FEATURE_TINT | SPRITE_FEATURE_PACKED | SPRITE_FEATURE_PICKING | SPRITE_FEATURE_SORTED | SPRITE_FEATURE_LIT;
+static constexpr Uint32 FRAGMENT_FEATURES = SPRITE_FEATURE_TINT | SPRITE_FEATURE_ALPHA_TEST | SPRITE_FEATURE_VIRTUAL | SPRITE_FEATURE_PICKING | SPRITE_FEATURE_LIT | SPRITE_FEATURE_SDF;
+
+static constexpr std::array<SpritePermutation, SPRITE_PERMUTATION_COUNT> BuildPermutations()
+{
+	std::array<SpritePermutation, SPRITE_PERMUTATION_COUNT> permutations = {};
+	for (Uint32 features = 0; features < SPRITE_PERMUTATION_COUNT; features += 1)
+	{
+		permutations[features] = SpritePermutation{
+			.vertexVariant = features & VERTEX_FEATURES,
+			.fragmentVariant = features & FRAGMENT_FEATURES,
+			// picking adds the layer's id base
+			.vertexUniformBuffers = (features & SPRITE_FEATURE_PICKING) ? 2u : 1u,
+			// sorting adds the sort keys after the instances and the frame table
+			.vertexStorageBuffers = (features & SPRITE_FEATURE_SORTED) ? 3u : 2u,
+			// virtual textures sample a page table before the page cache, sized by a uniform block.
+			// Lighting samples a normal map after the atlas, and reads the lights and tile lists.
+			.fragmentSamplers = (features & (SPRITE_FEATURE_VIRTUAL | SPRITE_FEATURE_LIT)) ? 2u : 1u,
+			.fragmentUniformBuffers = (features & (SPRITE_FEATURE_VIRTUAL | SPRITE_FEATURE_LIT)) ? 1u : 0u,
+			.fragmentStorageBuffers = (features & SPRITE_FEATURE_LIT) ? 2u : 0u,
+			.instanceSize = (features & SPRITE_FEATURE_PACKED) ? (Uint32)sizeof(PackedSpriteInstance) : (Uint32)sizeof(SpriteInstance)
+		};
+	}
+	return permutations;
+}
+
+static constexpr std::array<SpritePermutation, SPRITE_PERMUTATION_COUNT> PERMUTATIONS = BuildPermutations();
+
+// The general shaders are the ones the rest of the sample was written against
+static_assert(PERMUTATIONS[SPRITE_FEATURES_GENERAL].vertexVariant == SPRITE_FEATURES_GENERAL);
+static_assert(sizeof(PackedSpriteInstance) == 36);
+
+const SpritePermutation* SpritePermutation_Get(Uint32 features)
+{
+	SDL_assert(features < SPRITE_PERMUTATION_COUNT);
+	return &PERMUTATIONS[features];
+}
+
+// Float to half conversion, rounding to nearest with ties to even. Values too
+// small for a normal half flush to zero, values too large become infinity,
+// and NaNs stay NaN.
+static Uint16 FloatToHalf(float value)
+{
+	Uint32 bits;
+	SDL_memcpy(&bits, &value, sizeof(bits));
+
+	const Uint32 sign = (bits >> 16) & 0x8000;
+	const Sint32 exponent = (Sint32)((bits >> 23) & 0xFF) - 127 + 15;
+	const Uint32 mantissa = bits & 0x7FFFFF;
+	if (((bits >> 23) & 0xFF) == 0xFF && mantissa != 0)
+	{
+		return (Uint16)(sign | 0x7E00);
+	}
+	if (exponent <= 0)
+	{
+		return (Uint16)sign;
+	}
+	if (exponent >= 31)
+	{
+		return (Uint16)(sign | 0x7C00);
+	}
+
+	Uint32 half = sign | ((Uint32)exponent << 10) | (mantissa >> 13);
+	const Uint32 dropped = mantissa & 0x1FFF;
+	if (dropped > 0x1000 || (dropped == 0x1000 && (half & 1) != 0))
+	{
+		// a carry out of the mantissa correctly bumps the exponent, up to infinity
+		half += 1;
+	}
+	return (Uint16)half;
+}
+
+static Uint32 PackHalf2(float low, float high)
+{
+	return (Uint32)FloatToHalf(low) | ((Uint32)FloatToHalf(high) << 16);
+}
+
+static Uint32 PackUnorm16x2(float low, float high)
+{
+	const Uint32 x = (Uint32)(SDL_clamp(low, 0.0f, 1.0f) * 65535.0f + 0.5f);
+	const Uint32 y = (Uint32)(SDL_clamp(high, 0.0f, 1.0f) * 65535.0f + 0.5f);
+	return x | (y << 16);
+}
+
+static Uint32 PackUnorm8x4(float r, float g, float b, float a)
+{
+	const Uint32 x = (Uint32)(SDL_clamp(r, 0.0f, 1.0f) * 255.0f + 0.5f);
+	const Uint32 y = (Uint32)(SDL_clamp(g, 0.0f, 1.0f) * 255.0f + 0.5f);
+	const Uint32 z = (Uint32)(SDL_clamp(b, 0.0f, 1.0f) * 255.0f + 0.5f);
+	const Uint32 w = (Uint32)(SDL_clamp(a, 0.0f, 1.0f) * 255.0f + 0.5f);
+	return x | (y << 8) | (z << 16) | (w << 24);
+}
+
+void SpriteInstance_Pack(PackedSpriteInstance* packed, const SpriteInstance* sprite)
+{
+	packed->x = sprite->x;
+	packed->y = sprite->y;
+	packed->depth_rotation = PackHalf2(sprite->z, sprite->rotation);
+	packed->size = PackHalf2(sprite->w, sprite->h);
+	packed->animation = sprite->animation;
+	packed->animation_start = sprite->animation_start;
+	packed->tex_position = PackUnorm16x2(sprite->tex_u, sprite->tex_v);
+	packed->tex_size = PackUnorm16x2(sprite->tex_w, sprite->tex_h);
+	packed->color = PackUnorm8x4(sprite->r, sprite->g, sprite->b, sprite->a);
+}
+
+void SpritePipelineCache_Init(
+	SpritePipelineCache* cache,
+	SDL_GPUDevice* device,
+	const char* basePath,
+	SDL_GPUColorTargetDescription colorTarget
+) {
+	cache->device = device;
+	cache->basePath = basePath;
+	cache->colorTarget = colorTarget;
+	SDL_zeroa(cache->pipelines);
+}
+
+void SpritePipelineCache_Release(SpritePipelineCache* cache)
+{
+	for (SDL_GPUGraphicsPipeline*& pipeline : cache->pipelines)
+	{
+		SDL_ReleaseGPUGraphicsPipeline(cache->device, pipeline);
+		pipeline = NULL;
+	}
+}
+
+SDL_GPUGraphicsPipeline* SpritePipelineCache_Get(SpritePipelineCache* cache, Uint32 features)
+{
+	SDL_assert(features < SPRITE_PERMUTATION_COUNT);
+	if (cache->pipelines[features] != NULL)
+	{
+		return cache->pipelines[features];
+	}
+
+	const SpritePermutation* permutation = SpritePermutation_Get(features);
+	SDL_GPUShader* vertShader = LoadShaderVariant(
+		cache->basePath.c_str(),
+		cache->device,
+		"PullSpriteBatch.vert",
+		permutation->vertexVariant,
+		0,
+		permutation->vertexUniformBuffers,
+		permutation->vertexStorageBuffers,
+		0
+	);
+	SDL_GPUShader* fragShader = LoadShaderVariant(
+		cache->basePath.c_str(),
+		cache->device,
+		"TexturedQuadColor.frag",
+		permutation->fragmentVariant,
+		permutation->fragmentSamplers,
+		permutation->fragmentUniformBuffers,
+		permutation->fragmentStorageBuffers,
+		0
+	);
+
+	if (vertShader != NULL && fragShader != NULL)
+	{
+		// Ids are written as they are, blending them would be meaningless
+		const SDL_GPUColorTargetDescription pickTarget = {
+			.format = SPRITE_PICK_FORMAT,
+		};
+		auto graphicsPipelineCreateInfo = SDL_GPUGraphicsPipelineCreateInfo{
+			.vertex_shader = vertShader,
+			.fragment_shader = fragShader,
+			.primitive_type = SDL_GPU_PRIMITIVETYPE_TRIANGLELIST,
+			.target_info = {
+				.color_target_descriptions = (features & SPRITE_FEATURE_PICKING) ? &pickTarget : &cache->colorTarget,
+				.num_color_targets = 1,
+			},
+		};
+		cache->pipelines[features] = SDL_CreateGPUGraphicsPipeline(cache->device, &graphicsPipelineCreateInfo);
+		if (cache->pipelines[features] == NULL)
+		{
+			SDL_Log("Failed to create sprite pipeline %u: %s", features, SDL_GetError());
+		}
+	}
+
+	SDL_ReleaseGPUShader(cache->device, vertShader);
+	SDL_ReleaseGPUShader(cache->device, fragShader);
+	return cache->pipelines[features];
+}
@@ -0,0 +1,84 @@
+#pragma once
+#ifndef SDL_SAMPLE_SPRITE_PERMUTATIONS_H
+#define SDL_SAMPLE_SPRITE_PERMUTATIONS_H
+
+#include <SDL3/SDL.h>
+#include <string>
+#include "sprite_layer.h"
+
+// Optional parts of the sprite shaders. Each combination is compiled into its
+// own variant so batches only pay for what they use.
+// Keep the bits in sync with SPRITE_FEATURES in CMakeLists.txt.
+typedef enum SpriteFeature
+{
+	SPRITE_FEATURE_ROTATION = 1 << 0,    // rotate around the sprite's corner
+	SPRITE_FEATURE_TINT = 1 << 1,        // multiply the texture by the instance color
+	SPRITE_FEATURE_ALPHA_TEST = 1 << 2,  // discard mostly transparent texels
+	SPRITE_FEATURE_PACKED = 1 << 3,      // instances are PackedSpriteInstance
+	SPRITE_FEATURE_VIRTUAL = 1 << 4,     // UVs address a VirtualTexture, see virtual_texture.h
+	SPRITE_FEATURE_PICKING = 1 << 5,     // write sprite ids to an R32_UINT target, see sprite_picking.h
+	SPRITE_FEATURE_SORTED = 1 << 6,      // draw in the order of a GpuDepthSort, see gpu_sort.h
+	SPRITE_FEATURE_LIT = 1 << 7,         // shade with a normal map and the lights of a LightGrid, see lighting.h
+	SPRITE_FEATURE_SDF = 1 << 8          // the texture's alpha is a distance field, see sdf_font.h
+} SpriteFeature;
+
+#define SPRITE_FEATURE_COUNT 9
+#define SPRITE_PERMUTATION_COUNT (1 << SPRITE_FEATURE_COUNT)
+#define SPRITE_FEATURES_GENERAL (SPRITE_FEATURE_ROTATION | SPRITE_FEATURE_TINT)
+
+// Which compiled variants a feature mask maps to. Features that a stage does
+// not look at are masked out, so several masks share each shader.
+typedef struct SpritePermutation
+{
+	Uint32 vertexVariant;    // PullSpriteBatch_<n>.vert
+	Uint32 fragmentVariant;  // TexturedQuadColor_<n>.frag
+	Uint32 vertexUniformBuffers;
+	Uint32 vertexStorageBuffers;
+	Uint32 fragmentSamplers;
+	Uint32 fragmentUniformBuffers;
+	Uint32 fragmentStorageBuffers;
+	Uint32 instanceSize;
+} SpritePermutation;
+
+const SpritePermutation* SpritePermutation_Get(Uint32 features);
+
+// A SpriteInstance in 36 bytes instead of 64, for sprites that fit its ranges:
+// depth, rotation and size as half floats, the UV rect as 16-bit fixed point
+// and the color as 8 bits per channel.
+// Mirrors PackedSpriteData in PullSpriteBatch.vert.hlsl
+typedef struct PackedSpriteInstance
+{
+	float x, y;
+	Uint32 depth_rotation;
+	Uint32 size;
+	Uint32 animation;
+	float animation_start;
+	Uint32 tex_position;
+	Uint32 tex_size;
+	Uint32 color;
+} PackedSpriteInstance;
+
+void SpriteInstance_Pack(PackedSpriteInstance* packed, const SpriteInstance* sprite);
+
+// Creates the pipeline for each feature mask the first time it is asked for.
+// Picking pipelines render to SPRITE_PICK_FORMAT instead of the color target.
+typedef struct SpritePipelineCache
+{
+	SDL_GPUDevice* device;
+	std::string basePath;
+	SDL_GPUColorTargetDescription colorTarget;
+	SDL_GPUGraphicsPipeline* pipelines[SPRITE_PERMUTATION_COUNT];
+} SpritePipelineCache;
+
+void SpritePipelineCache_Init(
+	SpritePipelineCache* cache,
+	SDL_GPUDevice* device,
+	const char* basePath,
+	SDL_GPUColorTargetDescription colorTarget
+);
+void SpritePipelineCache_Release(SpritePipelineCache* cache);
+
+// Returns NULL if the variant's shaders could not be loaded
+SDL_GPUGraphicsPipeline* SpritePipelineCache_Get(SpritePipelineCache* cache, Uint32 features);
+
+#endif
@@ -0,0 +1,207 @@
+#include "sprite_picking.h"
+
+static const Uint32 REGION_SIZE = SPRITE_PICK_RADIUS * 2 + 1;
+
+bool SpritePicker_Init(SpritePicker* picker, SDL_GPUDevice* device, Uint32 width, Uint32 height)
+{
+	SDL_zerop(picker);
+	picker->device = device;
+	picker->width = width;
+	picker->height = height;
+
+	SDL_GPUTextureCreateInfo textureCreateInfo = {
+		.type = SDL_GPU_TEXTURETYPE_2D,
+		.format = SPRITE_PICK_FORMAT,
+		.usage = SDL_GPU_TEXTUREUSAGE_COLOR_TARGET,
+		.width = width,
+		.height = height,
+		.layer_count_or_depth = 1,
+		.num_levels = 1,
+	};
+	picker->target = SDL_CreateGPUTexture(device, &textureCreateInfo);
+	if (picker->target == NULL)
+	{
+		SDL_Log("Failed to create pick target: %s", SDL_GetError());
+		return false;
+	}
+
+	// One download buffer per pick in flight, so none of them is ever cycled or waited on
+	SDL_GPUTransferBufferCreateInfo transferBufferCreateInfo = {
+		.usage = SDL_GPU_TRANSFERBUFFERUSAGE_DOWNLOAD,
+		.size = REGION_SIZE * REGION_SIZE * sizeof(Uint32)
+	};
+	for (SpritePickReadback& readback : picker->readbacks)
+	{
+		readback.buffer = SDL_CreateGPUTransferBuffer(device, &transferBufferCreateInfo);
+		if (readback.buffer == NULL)
+		{
+			SDL_Log("Failed to create pick readback buffer: %s", SDL_GetError());
+			return false;
+		}
+	}
+	return true;
+}
+
+void SpritePicker_Release(SpritePicker* picker)
+{
+	for (SpritePickReadback& readback : picker->readbacks)
+	{
+		SDL_ReleaseGPUTransferBuffer(picker->device, readback.buffer);
+		readback.buffer = NULL;
+		readback.recorded = false;
+		readback.submitted = false;
+	}
+	SDL_ReleaseGPUTexture(picker->device, picker->target);
+	picker->target = NULL;
+	picker->current = NULL;
+}
+
+SDL_GPURenderPass* SpritePicker_Begin(SpritePicker* picker, SDL_GPUCommandBuffer* cmdBuf, float x, float y, Uint64 frame)
+{
+	if (x < 0 || y < 0 || x >= picker->width || y >= picker->height || picker->current != NULL)
+	{
+		return NULL;
+	}
+
+	SpritePickReadback* readback = NULL;
+	for (SpritePickReadback& candidate : picker->readbacks)
+	{
+		if (!candidate.recorded)
+		{
+			readback = &candidate;
+			break;
+		}
+	}
+	if (readback == NULL)
+	{
+		// the GPU is a few frames behind, skip this pick rather than wait
+		return NULL;
+	}
+
+	// The region keeps its full size at the edges of the target, so the cursor isn't always at its center
+	const int px = (int)x;
+	const int py = (int)y;
+	readback->region = SDL_Rect{
+		SDL_clamp(px - SPRITE_PICK_RADIUS, 0, (int)picker->width - (int)REGION_SIZE),
+		SDL_clamp(py - SPRITE_PICK_RADIUS, 0, (int)picker->height - (int)REGION_SIZE),
+		(int)REGION_SIZE,
+		(int)REGION_SIZE
+	};
+	readback->pick = SpritePick{ .frame = frame, .x = x, .y = y };
+	readback->recorded = true;
+	picker->current = readback;
+
+	auto colorTargetInfo = SDL_GPUColorTargetInfo{
+		.texture = picker->target,
+		.clear_color = { 0, 0, 0, 0 },
+		.load_op = SDL_GPU_LOADOP_CLEAR,
+		.store_op = SDL_GPU_STOREOP_STORE,
+	};
+	SDL_GPURenderPass* renderPass = SDL_BeginGPURenderPass(cmdBuf, &colorTargetInfo, 1, NULL);
+	SDL_SetGPUScissor(renderPass, &readback->region);
+	return renderPass;
+}
+
+void SpritePicker_End(SpritePicker* picker, SDL_GPUCommandBuffer* cmdBuf, SDL_GPURenderPass* renderPass)
+{
+	SDL_EndGPURenderPass(renderPass);
+
+	const SpritePickReadback* readback = picker->current;
+	SDL_GPUCopyPass* copyPass = SDL_BeginGPUCopyPass(cmdBuf);
+	const SDL_GPUTextureRegion source = {
+		.texture = picker->target,
+		.x = (Uint32)readback->region.x,
+		.y = (Uint32)readback->region.y,
+		.w = REGION_SIZE,
+		.h = REGION_SIZE,
+		.d = 1,
+	};
+	const SDL_GPUTextureTransferInfo destination = {
+		.transfer_buffer = readback->buffer,
+		.offset = 0,
+		.pixels_per_row = REGION_SIZE,
+		.rows_per_layer = REGION_SIZE,
+	};
+	SDL_DownloadFromGPUTexture(copyPass, &source, &destination);
+	SDL_EndGPUCopyPass(copyPass);
+}
+
+void SpritePicker_Submitted(SpritePicker* picker, bool submitted)
+{
+	if (picker->current == NULL)
+	{
+		return;
+	}
+
+	// A pick that never reached the GPU frees its readback right away
+	picker->current->recorded = submitted;
+	picker->current->submitted = submitted;
+	picker->current = NULL;
+}
+
+// The id at the pick point, or else the one nearest to it in the region
+static Uint32 FindNearestId(const Uint32* ids, int cx, int cy)
+{
+	Uint32 nearest = ids[cy * REGION_SIZE + cx];
+	if (nearest != SPRITE_PICK_NONE)
+	{
+		return nearest;
+	}
+
+	int nearestDistance = SDL_MAX_SINT32;
+	for (int y = 0; y < (int)REGION_SIZE; y += 1)
+	{
+		for (int x = 0; x < (int)REGION_SIZE; x += 1)
+		{
+			const Uint32 id = ids[y * REGION_SIZE + x];
+			const int distance = (x - cx) * (x - cx) + (y - cy) * (y - cy);
+			if (id != SPRITE_PICK_NONE && distance < nearestDistance)
+			{
+				nearest = id;
+				nearestDistance = distance;
+			}
+		}
+	}
+	return nearest;
+}
+
+bool SpritePicker_Poll(SpritePicker* picker, Uint64 completedFrames, SpritePick* pick)
+{
+	bool found = false;
+	for (SpritePickReadback& readback : picker->readbacks)
+	{
+		if (!readback.submitted || readback.pick.frame >= completedFrames)
+		{
+			continue;
+		}
+		readback.submitted = false;
+		readback.recorded = false;
+
+		// Readbacks can finish together, only the newest is worth reporting
+		if (readback.pick.frame < picker->latestFrame || (found && readback.pick.frame < pick->frame))
+		{
+			continue;
+		}
+
+		const Uint32* ids = (const Uint32*)SDL_MapGPUTransferBuffer(picker->device, readback.buffer, false);
+		if (ids == NULL)
+		{
+			SDL_Log("Failed to map pick readback: %s", SDL_GetError());
+			continue;
+		}
+		const Uint32 id = FindNearestId(ids, (int)readback.pick.x - readback.region.x, (int)readback.pick.y - readback.region.y);
+		SDL_UnmapGPUTransferBuffer(picker->device, readback.buffer);
+
+		*pick = readback.pick;
+		pick->hit = id != SPRITE_PICK_NONE;
+		pick->layer = pick->hit ? (id - 1) >> 24 : 0;
+		pick->index = pick->hit ? (id - 1) & 0xFFFFFF : 0;
+		found = true;
+	}
+
+	if (found)
+	{
+		picker->latestFrame = pick->frame;
+	}
+	return found;
+}
@@ -0,0 +1,83 @@
+#pragma once
+#ifndef SDL_SAMPLE_SPRITE_PICKING_H
+#define SDL_SAMPLE_SPRITE_PICKING_H
+
+#include <SDL3/SDL.h>
+
+#define SPRITE_PICK_FORMAT SDL_GPU_TEXTUREFORMAT_R32_UINT
+// Id of pixels no sprite covers
+#define SPRITE_PICK_NONE 0
+// Pixels read back around the cursor in each direction. Misses at the
+// cursor snap to the nearest sprite within this distance.
+#define SPRITE_PICK_RADIUS 4
+// Picks that can be on their way back from the GPU at once
+#define SPRITE_PICK_READBACKS 3
+
+// Mirrors PickBlock in PullSpriteBatch.vert.hlsl
+typedef struct SpritePickUniforms
+{
+	Uint32 base;
+	Uint32 padding[3];
+} SpritePickUniforms;
+
+// Sprites write base + their index in the layer, so an id names both the layer
+// and the sprite. 8 bits of layer, 24 bits of index, and 0 is left for SPRITE_PICK_NONE.
+static inline SpritePickUniforms SpritePick_Uniforms(Uint32 layer)
+{
+	return SpritePickUniforms{ .base = (layer << 24) + 1 };
+}
+
+typedef struct SpritePick
+{
+	Uint64 frame;  // as passed to SpritePicker_Begin
+	float x, y;    // where the pick was taken, in target pixels
+	bool hit;
+	Uint32 layer;
+	Uint32 index;
+} SpritePick;
+
+typedef struct SpritePickReadback
+{
+	SDL_GPUTransferBuffer* buffer;
+	bool recorded;         // the download is in a command buffer
+	bool submitted;        // and that command buffer went to the GPU
+	SDL_Rect region;
+	SpritePick pick;
+} SpritePickReadback;
+
+// Finds the sprite under a point by drawing sprite ids, rather than testing
+// every sprite on the CPU. Each frame's pick pass draws the layers again with
+// SPRITE_FEATURE_PICKING pipelines, scissored to a few pixels around the
+// cursor, and downloads that region. The result is read once the GPU is done
+// with the frame, usually by the next frame, so nothing waits on the GPU.
+typedef struct SpritePicker
+{
+	SDL_GPUDevice* device;
+	SDL_GPUTexture* target;
+	Uint32 width, height;
+	SpritePickReadback readbacks[SPRITE_PICK_READBACKS];
+	SpritePickReadback* current;  // recorded this frame, not yet submitted
+	Uint64 latestFrame;           // of the newest pick handed out by Poll
+} SpritePicker;
+
+bool SpritePicker_Init(SpritePicker* picker, SDL_GPUDevice* device, Uint32 width, Uint32 height);
+// Only once the GPU is done with the frames that picked
+void SpritePicker_Release(SpritePicker* picker);
+
+// Starts a pick pass on the id target, scissored around (x, y) in target
+// pixels. The caller binds picking pipelines and draws the layers to test in
+// the order they appear on screen. Returns NULL, with nothing to draw, if the
+// point is off the target or all readbacks are still in flight.
+SDL_GPURenderPass* SpritePicker_Begin(SpritePicker* picker, SDL_GPUCommandBuffer* cmdBuf, float x, float y, Uint64 frame);
+
+// Ends the pick pass and records the download of the region around the point.
+void SpritePicker_End(SpritePicker* picker, SDL_GPUCommandBuffer* cmdBuf, SDL_GPURenderPass* renderPass);
+
+// Call once the frame's command buffer was submitted, or failed to be
+void SpritePicker_Submitted(SpritePicker* picker, bool submitted);
+
+// Hands out the newest pick the GPU has finished, if there is one that wasn't
+// handed out yet. Frames before `completedFrames` must be done on the GPU.
+bool SpritePicker_Poll(SpritePicker* picker, Uint64 completedFrames, SpritePick* pick);
+
+#endif
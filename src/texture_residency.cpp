@@ -0,0 +1,305 @@
+#include "texture_residency.h"
+#include "cooked_texture.h"
+#include "image_loader.h"
+#include "trace.h"
+
+bool TextureResidency_Init(
+	TextureResidency* residency,
+	SDL_GPUDevice* device,
+	UploadScheduler* uploads,
+	const char* basePath,
+	Uint64 budgetBytes
+) {
+	residency->device = device;
+	residency->uploads = uploads;
+	residency->basePath = basePath;
+	residency->budgetBytes = budgetBytes;
+	residency->residentBytes = 0;
+	residency->frame = 0;
+	residency->pages.clear();
+
+	residency->ioQueue = SDL_CreateAsyncIOQueue();
+	if (residency->ioQueue == NULL)
+	{
+		SDL_Log("Failed to create texture streaming queue: %s", SDL_GetError());
+		return false;
+	}
+
+	// A neutral grey stands in for pages that are still on their way
+	SDL_GPUTextureCreateInfo textureCreateInfo = {
+		.type = SDL_GPU_TEXTURETYPE_2D,
+		.format = SDL_GPU_TEXTUREFORMAT_R8G8B8A8_UNORM,
+		.usage = SDL_GPU_TEXTUREUSAGE_SAMPLER,
+		.width = 1,
+		.height = 1,
+		.layer_count_or_depth = 1,
+		.num_levels = 1,
+	};
+	residency->placeholder = SDL_CreateGPUTexture(device, &textureCreateInfo);
+	if (residency->placeholder == NULL)
+	{
+		SDL_Log("Failed to create placeholder texture: %s", SDL_GetError());
+		return false;
+	}
+	static const Uint8 placeholderPixel[4] = { 128, 128, 128, 255 };
+	void* pixels = UploadScheduler_QueueTexture(uploads, residency->placeholder, SDL_Rect{ 0, 0, 1, 1 }, 4, UPLOAD_PRIORITY_VISIBLE);
+	SDL_memcpy(pixels, placeholderPixel, sizeof(placeholderPixel));
+	return true;
+}
+
+void TextureResidency_Release(TextureResidency* residency)
+{
+	// Destroying the queue would drop the buffers of reads in flight, so wait them out first
+	for (const TexturePage& page : residency->pages)
+	{
+		if (page.state == TEXTURE_PAGE_LOADING)
+		{
+			SDL_AsyncIOOutcome outcome;
+			if (SDL_WaitAsyncIOResult(residency->ioQueue, &outcome, -1))
+			{
+				SDL_free(outcome.buffer);
+			}
+		}
+	}
+	SDL_DestroyAsyncIOQueue(residency->ioQueue);
+	residency->ioQueue = NULL;
+
+	for (TexturePage& page : residency->pages)
+	{
+		SDL_ReleaseGPUTexture(residency->device, page.texture);
+	}
+	residency->pages.clear();
+	residency->residentBytes = 0;
+	SDL_ReleaseGPUTexture(residency->device, residency->placeholder);
+	residency->placeholder = NULL;
+}
+
+Uint32 TextureResidency_AddPage(TextureResidency* residency, const char* filename)
+{
+	residency->pages.push_back(TexturePage{
+		.filename = filename,
+		.state = TEXTURE_PAGE_EVICTED,
+	});
+	return (Uint32)residency->pages.size() - 1;
+}
+
+SDL_GPUTexture* TextureResidency_Use(TextureResidency* residency, Uint32 pageIndex)
+{
+	TexturePage* page = &residency->pages[pageIndex];
+	page->lastUsedFrame = residency->frame;
+	if (page->state == TEXTURE_PAGE_RESIDENT)
+	{
+		return page->texture;
+	}
+
+	if (page->state == TEXTURE_PAGE_EVICTED)
+	{
+		char cookedPath[256];
+		if (!page->cookedChecked)
+		{
+			page->cookedUnusable = !CookedTexture_FindCooked(residency->basePath.c_str(), page->filename.c_str(), cookedPath, sizeof(cookedPath));
+			page->cookedChecked = true;
+		}
+		CookedTexture_GetPath(residency->basePath.c_str(), page->filename.c_str(), cookedPath, sizeof(cookedPath));
+		page->cooked = !page->cookedUnusable;
+		const std::string path = page->cooked ? std::string(cookedPath) : residency->basePath + "Content/Images/" + page->filename;
+		if (SDL_LoadFileAsync(path.c_str(), residency->ioQueue, (void*)(uintptr_t)pageIndex))
+		{
+			page->state = TEXTURE_PAGE_LOADING;
+		}
+		else
+		{
+			SDL_Log("Failed to start loading %s: %s", path.c_str(), SDL_GetError());
+			page->state = TEXTURE_PAGE_FAILED;
+		}
+	}
+	return residency->placeholder;
+}
+
+static bool FinishLoad(TextureResidency* residency, TexturePage* page, SDL_Surface* surface)
+{
+	if (surface == NULL)
+	{
+		return false;
+	}
+
+	// Drawing switches from the placeholder right away, so the upload can't wait
+	page->texture = UploadScheduler_CreateTexture(residency->uploads, surface, UPLOAD_PRIORITY_VISIBLE);
+	page->width = (Uint32)surface->w;
+	page->height = (Uint32)surface->h;
+	page->bytes = (Uint64)surface->w * surface->h * 4;
+	SDL_DestroySurface(surface);
+	if (page->texture == NULL)
+	{
+		return false;
+	}
+
+	residency->residentBytes += page->bytes;
+	return true;
+}
+
+static bool FinishCookedLoad(TextureResidency* residency, TexturePage* page, const void* data, size_t size)
+{
+	// Pages are drawn blending straight alpha
+	SDL_GPUTextureCreateInfo createInfo;
+	Uint32 flags;
+	if (!CookedTexture_Parse(data, size, page->filename.c_str(), &createInfo, &flags))
+	{
+		return false;
+	}
+	if ((flags & COOKED_TEXTURE_PREMULTIPLIED) != 0)
+	{
+		SDL_Log("%s is cooked with premultiplied alpha, which atlas pages don't use", page->filename.c_str());
+		return false;
+	}
+
+	page->texture = CookedTexture_Create(residency->uploads, data, size, page->filename.c_str(), UPLOAD_PRIORITY_VISIBLE, &page->bytes);
+	if (page->texture == NULL)
+	{
+		return false;
+	}
+	page->width = createInfo.width;
+	page->height = createInfo.height;
+	residency->residentBytes += page->bytes;
+	return true;
+}
+
+bool TextureResidency_Load(TextureResidency* residency, Uint32 pageIndex)
+{
+	TexturePage* page = &residency->pages[pageIndex];
+	page->lastUsedFrame = residency->frame;
+	if (page->state == TEXTURE_PAGE_RESIDENT)
+	{
+		return true;
+	}
+
+	char cookedPath[256];
+	page->cookedUnusable = !CookedTexture_FindCooked(residency->basePath.c_str(), page->filename.c_str(), cookedPath, sizeof(cookedPath));
+	page->cookedChecked = true;
+	if (!page->cookedUnusable)
+	{
+		size_t size;
+		void* data = SDL_LoadFile(cookedPath, &size);
+		const bool loaded = data != NULL && FinishCookedLoad(residency, page, data, size);
+		SDL_free(data);
+		if (loaded)
+		{
+			page->state = TEXTURE_PAGE_RESIDENT;
+			return true;
+		}
+		page->cookedUnusable = true;
+	}
+
+	const std::string path = residency->basePath + "Content/Images/" + page->filename;
+	if (!FinishLoad(residency, page, Image_Load(path.c_str())))
+	{
+		page->state = TEXTURE_PAGE_FAILED;
+		return false;
+	}
+	page->state = TEXTURE_PAGE_RESIDENT;
+	return true;
+}
+
+// Releases least recently used pages until the budget is met. Pages used in
+// the last frame are the working set and stay, even if that exceeds the budget.
+static void EvictOverBudget(TextureResidency* residency)
+{
+	while (residency->residentBytes > residency->budgetBytes)
+	{
+		TexturePage* victim = NULL;
+		for (TexturePage& page : residency->pages)
+		{
+			if (page.state == TEXTURE_PAGE_RESIDENT && page.lastUsedFrame + 1 < residency->frame &&
+				(victim == NULL || page.lastUsedFrame < victim->lastUsedFrame))
+			{
+				victim = &page;
+			}
+		}
+		if (victim == NULL)
+		{
+			return;
+		}
+
+		// Its upload may still be queued if it was loaded but never drawn
+		UploadScheduler_CancelTexture(residency->uploads, victim->texture);
+		SDL_ReleaseGPUTexture(residency->device, victim->texture);
+		victim->texture = NULL;
+		victim->state = TEXTURE_PAGE_EVICTED;
+		residency->residentBytes -= victim->bytes;
+	}
+}
+
+bool TextureResidency_BeginFrame(TextureResidency* residency)
+{
+	// Pages that finished reading together are decoded together, in parallel
+	std::vector<SDL_AsyncIOOutcome> outcomes;
+	std::vector<ImageSource> sources;
+	bool changed = false;
+	SDL_AsyncIOOutcome outcome;
+	while (SDL_GetAsyncIOResult(residency->ioQueue, &outcome))
+	{
+		TexturePage* page = &residency->pages[(uintptr_t)outcome.userdata];
+		if (outcome.result != SDL_ASYNCIO_COMPLETE)
+		{
+			SDL_Log("Failed to load %s: %s", page->filename.c_str(), SDL_GetError());
+			page->state = TEXTURE_PAGE_FAILED;
+			SDL_free(outcome.buffer);
+			continue;
+		}
+		if (page->cooked)
+		{
+			// The file is the texture, no decode needed. If it is of no use
+			// here, the next use of the page reads the image instead.
+			Trace_Begin("cooked page load");
+			if (FinishCookedLoad(residency, page, outcome.buffer, (size_t)outcome.bytes_transferred))
+			{
+				page->state = TEXTURE_PAGE_RESIDENT;
+				changed = true;
+			}
+			else
+			{
+				page->cookedUnusable = true;
+				page->state = TEXTURE_PAGE_EVICTED;
+			}
+			Trace_End();
+			SDL_free(outcome.buffer);
+			continue;
+		}
+		outcomes.push_back(outcome);
+		sources.push_back(ImageSource{
+			.data = outcome.buffer,
+			.size = (size_t)outcome.bytes_transferred,
+			.name = page->filename.c_str(),
+		});
+	}
+
+	if (!outcomes.empty())
+	{
+		Trace_Begin("texture page load");
+		std::vector<SDL_Surface*> surfaces(outcomes.size());
+		Image_DecodeBatch(sources.data(), surfaces.data(), (Uint32)outcomes.size(), 0);
+		for (size_t i = 0; i < outcomes.size(); i += 1)
+		{
+			TexturePage* page = &residency->pages[(uintptr_t)outcomes[i].userdata];
+			if (FinishLoad(residency, page, surfaces[i]))
+			{
+				page->state = TEXTURE_PAGE_RESIDENT;
+				changed = true;
+			}
+			else
+			{
+				page->state = TEXTURE_PAGE_FAILED;
+			}
+			SDL_free(outcomes[i].buffer);
+		}
+		Trace_End();
+	}
+
+	EvictOverBudget(residency);
+	return changed;
+}
+
+void TextureResidency_EndFrame(TextureResidency* residency)
+{
+	residency->frame += 1;
+}
@@ -0,0 +1,82 @@
+#pragma once
+#ifndef SDL_SAMPLE_TEXTURE_RESIDENCY_H
+#define SDL_SAMPLE_TEXTURE_RESIDENCY_H
+
+#include <SDL3/SDL.h>
+#include <string>
+#include <vector>
+#include "upload_scheduler.h"
+
+typedef enum TexturePageState
+{
+	TEXTURE_PAGE_EVICTED,   // not in GPU memory, loaded on the next use
+	TEXTURE_PAGE_LOADING,   // being read from disk
+	TEXTURE_PAGE_RESIDENT,
+	TEXTURE_PAGE_FAILED     // could not be loaded, stays on the placeholder
+} TexturePageState;
+
+// One atlas page, backed by an image in Content/Images in any format Image_Decode reads.
+// Its cooked form in Content/Cooked is read instead when there is one.
+typedef struct TexturePage
+{
+	std::string filename;
+	TexturePageState state;
+	bool cooked;          // the read in flight is of the cooked form
+	bool cookedChecked;   // cookedUnusable is known, finding it out reads the whole image
+	bool cookedUnusable;  // no current cooked form or it failed to load, only read the image from now on
+	SDL_GPUTexture* texture;
+	Uint32 width, height;  // of the texture, kept once evicted, 0 until it was first resident
+	Uint64 bytes;
+	Uint64 lastUsedFrame;
+} TexturePage;
+
+// Keeps atlas pages in GPU memory only while they are drawn, within a byte
+// budget. Pages are read asynchronously when first used, pages whose reads
+// finish in the same frame are decoded in parallel, cooked pages skip
+// decoding and go straight to the GPU, and the least
+// recently used ones are released once the budget is exceeded. Until a page
+// is resident, its users get a 1x1 placeholder texture instead.
+typedef struct TextureResidency
+{
+	SDL_GPUDevice* device;
+	UploadScheduler* uploads;
+	std::string basePath;
+	Uint64 budgetBytes;
+	Uint64 residentBytes;
+	Uint64 frame;
+	std::vector<TexturePage> pages;
+	SDL_AsyncIOQueue* ioQueue;
+	SDL_GPUTexture* placeholder;
+} TextureResidency;
+
+bool TextureResidency_Init(
+	TextureResidency* residency,
+	SDL_GPUDevice* device,
+	UploadScheduler* uploads,
+	const char* basePath,
+	Uint64 budgetBytes
+);
+void TextureResidency_Release(TextureResidency* residency);
+
+// Registers a page without loading it. Returns its id.
+Uint32 TextureResidency_AddPage(TextureResidency* residency, const char* filename);
+
+// Reads and uploads a page right away, for pages that have to be there from
+// the start. Returns false after logging why if it can't be loaded. The page
+// is still evicted and streamed back in like any other.
+bool TextureResidency_Load(TextureResidency* residency, Uint32 page);
+
+// Marks the page as used this frame and returns the texture to bind for it:
+// the page itself if resident, otherwise the placeholder while it loads.
+SDL_GPUTexture* TextureResidency_Use(TextureResidency* residency, Uint32 page);
+
+// Call once per frame before any TextureResidency_Use. Finishes completed
+// loads, queueing their uploads, and evicts pages over the budget.
+// Returns true if any page became resident, i.e. the picture will change.
+bool TextureResidency_BeginFrame(TextureResidency* residency);
+
+// Call once a frame has been drawn. Only drawn frames age the pages, so
+// frames skipped while idle don't push the working set out.
+void TextureResidency_EndFrame(TextureResidency* residency);
+
+#endif
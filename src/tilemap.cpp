@@ -0,0 +1,196 @@
+#include "tilemap.h"
+
+static const Uint32 CHUNK_BYTES = TILEMAP_CHUNK_TILES * sizeof(Uint16);
+
+bool Tilemap_Init(
+	Tilemap* tilemap,
+	SDL_GPUDevice* device,
+	Uint32 widthInTiles,
+	Uint32 heightInTiles,
+	float tileWidth,
+	float tileHeight,
+	Uint32 atlasColumns,
+	Uint32 atlasRows
+) {
+	tilemap->chunksX = (widthInTiles + TILEMAP_CHUNK_SIZE - 1) / TILEMAP_CHUNK_SIZE;
+	tilemap->chunksY = (heightInTiles + TILEMAP_CHUNK_SIZE - 1) / TILEMAP_CHUNK_SIZE;
+	tilemap->tileWidth = tileWidth;
+	tilemap->tileHeight = tileHeight;
+	tilemap->atlasColumns = atlasColumns;
+	tilemap->atlasCellU = 1.0f / atlasColumns;
+	tilemap->atlasCellV = 1.0f / atlasRows;
+
+	const Uint32 chunkCount = tilemap->chunksX * tilemap->chunksY;
+	tilemap->tiles.assign((size_t)chunkCount * TILEMAP_CHUNK_TILES, TILEMAP_EMPTY_TILE);
+	tilemap->chunkDirty.assign(chunkCount, true);
+
+	auto bufferCreateInfo = SDL_GPUBufferCreateInfo{
+		.usage = SDL_GPU_BUFFERUSAGE_GRAPHICS_STORAGE_READ,
+		.size = chunkCount * CHUNK_BYTES
+	};
+	tilemap->buffer = SDL_CreateGPUBuffer(device, &bufferCreateInfo);
+	if (tilemap->buffer == NULL)
+	{
+		SDL_Log("Failed to create tilemap buffer: %s", SDL_GetError());
+		return false;
+	}
+	return true;
+}
+
+void Tilemap_Release(Tilemap* tilemap, SDL_GPUDevice* device)
+{
+	SDL_ReleaseGPUBuffer(device, tilemap->buffer);
+	tilemap->buffer = NULL;
+	tilemap->tiles.clear();
+	tilemap->chunkDirty.clear();
+}
+
+static size_t TileOffset(const Tilemap* tilemap, Uint32 x, Uint32 y, Uint32* chunk)
+{
+	*chunk = (y / TILEMAP_CHUNK_SIZE) * tilemap->chunksX + (x / TILEMAP_CHUNK_SIZE);
+	return (size_t)*chunk * TILEMAP_CHUNK_TILES + (y % TILEMAP_CHUNK_SIZE) * TILEMAP_CHUNK_SIZE + (x % TILEMAP_CHUNK_SIZE);
+}
+
+void Tilemap_SetTile(Tilemap* tilemap, Uint32 x, Uint32 y, Uint16 atlasIndex)
+{
+	if (x >= tilemap->chunksX * TILEMAP_CHUNK_SIZE || y >= tilemap->chunksY * TILEMAP_CHUNK_SIZE)
+	{
+		return;
+	}
+
+	Uint32 chunk;
+	Uint16* tile = &tilemap->tiles[TileOffset(tilemap, x, y, &chunk)];
+	if (*tile != atlasIndex)
+	{
+		*tile = atlasIndex;
+		tilemap->chunkDirty[chunk] = true;
+	}
+}
+
+Uint16 Tilemap_GetTile(const Tilemap* tilemap, Uint32 x, Uint32 y)
+{
+	if (x >= tilemap->chunksX * TILEMAP_CHUNK_SIZE || y >= tilemap->chunksY * TILEMAP_CHUNK_SIZE)
+	{
+		return TILEMAP_EMPTY_TILE;
+	}
+
+	Uint32 chunk;
+	return tilemap->tiles[TileOffset(tilemap, x, y, &chunk)];
+}
+
+// Range of chunks overlapping a world-space rectangle, clamped to the map
+static void ChunkRange(const Tilemap* tilemap, SDL_FRect area, SDL_Rect* range)
+{
+	const float chunkWidth = tilemap->tileWidth * TILEMAP_CHUNK_SIZE;
+	const float chunkHeight = tilemap->tileHeight * TILEMAP_CHUNK_SIZE;
+
+	Sint32 firstX = (Sint32)SDL_floorf(area.x / chunkWidth);
+	Sint32 firstY = (Sint32)SDL_floorf(area.y / chunkHeight);
+	Sint32 lastX = (Sint32)SDL_floorf((area.x + area.w) / chunkWidth);
+	Sint32 lastY = (Sint32)SDL_floorf((area.y + area.h) / chunkHeight);
+	firstX = SDL_max(firstX, 0);
+	firstY = SDL_max(firstY, 0);
+	lastX = SDL_min(lastX, (Sint32)tilemap->chunksX - 1);
+	lastY = SDL_min(lastY, (Sint32)tilemap->chunksY - 1);
+
+	range->x = firstX;
+	range->y = firstY;
+	range->w = lastX - firstX + 1;
+	range->h = lastY - firstY + 1;
+}
+
+static bool RangeContains(const SDL_Rect* range, Sint32 x, Sint32 y)
+{
+	return x >= range->x && x < range->x + range->w && y >= range->y && y < range->y + range->h;
+}
+
+Uint32 Tilemap_Upload(Tilemap* tilemap, UploadScheduler* scheduler, SDL_FRect visibleArea)
+{
+	SDL_Rect visible;
+	ChunkRange(tilemap, visibleArea, &visible);
+	const SDL_Rect nearby = { visible.x - 1, visible.y - 1, visible.w + 2, visible.h + 2 };
+
+	Uint32 queuedBytes = 0;
+	for (Uint32 chunk = 0; chunk < (Uint32)tilemap->chunkDirty.size(); chunk += 1)
+	{
+		if (!tilemap->chunkDirty[chunk])
+		{
+			continue;
+		}
+		const Sint32 x = chunk % tilemap->chunksX;
+		const Sint32 y = chunk / tilemap->chunksX;
+		UploadPriority priority = UPLOAD_PRIORITY_BACKGROUND;
+		if (RangeContains(&visible, x, y))
+		{
+			priority = UPLOAD_PRIORITY_VISIBLE;
+		}
+		else if (RangeContains(&nearby, x, y))
+		{
+			priority = UPLOAD_PRIORITY_PREFETCH;
+		}
+
+		void* data = UploadScheduler_QueueBuffer(scheduler, tilemap->buffer, chunk * CHUNK_BYTES, CHUNK_BYTES, priority);
+		SDL_memcpy(data, &tilemap->tiles[(size_t)chunk * TILEMAP_CHUNK_TILES], CHUNK_BYTES);
+		tilemap->chunkDirty[chunk] = false;
+		queuedBytes += CHUNK_BYTES;
+	}
+
+	// Chunks queued earlier may have scrolled closer since, hurry them along
+	if (UploadScheduler_HasPending(scheduler))
+	{
+		for (Sint32 y = nearby.y; y < nearby.y + nearby.h; y += 1)
+		{
+			for (Sint32 x = nearby.x; x < nearby.x + nearby.w; x += 1)
+			{
+				if (x < 0 || y < 0 || x >= (Sint32)tilemap->chunksX || y >= (Sint32)tilemap->chunksY)
+				{
+					continue;
+				}
+				const Uint32 chunk = y * tilemap->chunksX + x;
+				UploadScheduler_Promote(
+					scheduler,
+					tilemap->buffer,
+					chunk * CHUNK_BYTES,
+					RangeContains(&visible, x, y) ? UPLOAD_PRIORITY_VISIBLE : UPLOAD_PRIORITY_PREFETCH
+				);
+			}
+		}
+	}
+	return queuedBytes;
+}
+
+void Tilemap_Draw(
+	const Tilemap* tilemap,
+	SDL_GPUCommandBuffer* cmdBuf,
+	SDL_GPURenderPass* renderPass,
+	const Matrix4x4* viewProjection,
+	SDL_FRect visibleArea
+) {
+	const float chunkWidth = tilemap->tileWidth * TILEMAP_CHUNK_SIZE;
+	const float chunkHeight = tilemap->tileHeight * TILEMAP_CHUNK_SIZE;
+	SDL_Rect visible;
+	ChunkRange(tilemap, visibleArea, &visible);
+
+	SDL_BindGPUVertexStorageBuffers(renderPass, 0, &tilemap->buffer, 1);
+
+	TilemapUniforms uniforms = {
+		.viewProjection = *viewProjection,
+		.tileWidth = tilemap->tileWidth,
+		.tileHeight = tilemap->tileHeight,
+		.atlasColumns = tilemap->atlasColumns,
+		.atlasCellU = tilemap->atlasCellU,
+		.atlasCellV = tilemap->atlasCellV,
+	};
+	for (Sint32 y = visible.y; y < visible.y + visible.h; y += 1)
+	{
+		for (Sint32 x = visible.x; x < visible.x + visible.w; x += 1)
+		{
+			uniforms.originX = x * chunkWidth;
+			uniforms.originY = y * chunkHeight;
+			// Two tiles are packed into each uint of the shader's view of the buffer
+			uniforms.chunkOffset = (y * tilemap->chunksX + x) * (TILEMAP_CHUNK_TILES / 2);
+			SDL_PushGPUVertexUniformData(cmdBuf, 0, &uniforms, sizeof(TilemapUniforms));
+			SDL_DrawGPUPrimitives(renderPass, TILEMAP_CHUNK_TILES * 6, 1, 0, 0);
+		}
+	}
+}
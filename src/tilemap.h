@@ -0,0 +1,72 @@
+#pragma once
+#ifndef SDL_SAMPLE_TILEMAP_H
+#define SDL_SAMPLE_TILEMAP_H
+
+#include <SDL3/SDL.h>
+#include <vector>
+#include "common.h"
+#include "upload_scheduler.h"
+
+// Tiles are stored in square chunks so that only the chunks touching the
+// camera get drawn and a single edited tile only re-uploads its own chunk.
+// Keep in sync with CHUNK_SIZE in TilemapChunk.vert.hlsl.
+#define TILEMAP_CHUNK_SIZE 32
+#define TILEMAP_CHUNK_TILES (TILEMAP_CHUNK_SIZE * TILEMAP_CHUNK_SIZE)
+#define TILEMAP_EMPTY_TILE 0xFFFF
+
+// A layer of tiles, each a 16-bit index into a grid atlas. All chunks live
+// in one storage buffer, chunk c starting at tile c * TILEMAP_CHUNK_TILES.
+typedef struct Tilemap
+{
+	Uint32 chunksX, chunksY;
+	float tileWidth, tileHeight;
+	Uint32 atlasColumns;
+	float atlasCellU, atlasCellV;
+	std::vector<Uint16> tiles;
+	std::vector<bool> chunkDirty;
+	SDL_GPUBuffer* buffer;
+} Tilemap;
+
+// Mirrors UniformBlock in TilemapChunk.vert.hlsl
+typedef struct TilemapUniforms
+{
+	Matrix4x4 viewProjection;
+	float originX, originY;
+	float tileWidth, tileHeight;
+	Uint32 chunkOffset;
+	Uint32 atlasColumns;
+	float atlasCellU, atlasCellV;
+} TilemapUniforms;
+
+// Creates an empty map of at least widthInTiles x heightInTiles tiles, rounded up to whole chunks.
+bool Tilemap_Init(
+	Tilemap* tilemap,
+	SDL_GPUDevice* device,
+	Uint32 widthInTiles,
+	Uint32 heightInTiles,
+	float tileWidth,
+	float tileHeight,
+	Uint32 atlasColumns,
+	Uint32 atlasRows
+);
+void Tilemap_Release(Tilemap* tilemap, SDL_GPUDevice* device);
+
+void Tilemap_SetTile(Tilemap* tilemap, Uint32 x, Uint32 y, Uint16 atlasIndex);
+Uint16 Tilemap_GetTile(const Tilemap* tilemap, Uint32 x, Uint32 y);
+
+// Queues uploads for every chunk modified since the last call: chunks in the
+// visible area right away, their neighbours as prefetch, the rest in the
+// background. Returns the number of bytes queued.
+Uint32 Tilemap_Upload(Tilemap* tilemap, UploadScheduler* scheduler, SDL_FRect visibleArea);
+
+// Draws the chunks overlapping the given world-space rectangle.
+// The tilemap pipeline must already be bound.
+void Tilemap_Draw(
+	const Tilemap* tilemap,
+	SDL_GPUCommandBuffer* cmdBuf,
+	SDL_GPURenderPass* renderPass,
+	const Matrix4x4* viewProjection,
+	SDL_FRect visibleArea
+);
+
+#endif
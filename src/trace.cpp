@@ -0,0 +1,190 @@
+#include "trace.h"
+
+bool TraceEnabled;
+static Uint64 TraceStartNS;
+static SDL_TLSID TraceSlot;
+// Pushed onto without a lock, each buffer is added once by the thread that allocated it
+static TraceBuffer* TraceBuffers;
+// Buffers of exited threads, so threads started per job don't each allocate one
+static TraceBuffer* TraceFreeBuffers;
+static SDL_SpinLock TraceFreeLock;
+
+// Runs as a recording thread exits
+static void SDLCALL ReleaseThreadBuffer(void* value)
+{
+	TraceBuffer* buffer = (TraceBuffer*)value;
+	SDL_LockSpinlock(&TraceFreeLock);
+	buffer->nextFree = TraceFreeBuffers;
+	TraceFreeBuffers = buffer;
+	SDL_UnlockSpinlock(&TraceFreeLock);
+}
+
+static TraceBuffer* GetThreadBuffer(void)
+{
+	TraceBuffer* buffer = (TraceBuffer*)SDL_GetTLS(&TraceSlot);
+	if (buffer != NULL)
+	{
+		return buffer;
+	}
+
+	// A reused buffer carries on after the events of the thread that had it, on its track
+	SDL_LockSpinlock(&TraceFreeLock);
+	buffer = TraceFreeBuffers;
+	if (buffer != NULL)
+	{
+		TraceFreeBuffers = buffer->nextFree;
+	}
+	SDL_UnlockSpinlock(&TraceFreeLock);
+	if (buffer != NULL)
+	{
+		if (!SDL_SetTLS(&TraceSlot, buffer, ReleaseThreadBuffer))
+		{
+			ReleaseThreadBuffer(buffer);
+			return NULL;
+		}
+		return buffer;
+	}
+
+	buffer = (TraceBuffer*)SDL_calloc(1, sizeof(TraceBuffer));
+	if (buffer == NULL)
+	{
+		return NULL;
+	}
+	buffer->threadId = SDL_GetCurrentThreadID();
+	SDL_snprintf(buffer->threadName, sizeof(buffer->threadName), "thread %" SDL_PRIu64, (Uint64)buffer->threadId);
+	if (!SDL_SetTLS(&TraceSlot, buffer, ReleaseThreadBuffer))
+	{
+		SDL_free(buffer);
+		return NULL;
+	}
+	do
+	{
+		buffer->next = (TraceBuffer*)SDL_GetAtomicPointer((void**)&TraceBuffers);
+	} while (!SDL_CompareAndSwapAtomicPointer((void**)&TraceBuffers, buffer->next, buffer));
+	return buffer;
+}
+
+void Trace_Init(void)
+{
+	TraceStartNS = SDL_GetTicksNS();
+	TraceEnabled = true;
+	Trace_SetThreadName("main");
+}
+
+void Trace_Quit(void)
+{
+	TraceEnabled = false;
+	SDL_SetTLS(&TraceSlot, NULL, NULL);
+	TraceBuffer* buffer = TraceBuffers;
+	while (buffer != NULL)
+	{
+		TraceBuffer* next = buffer->next;
+		SDL_free(buffer);
+		buffer = next;
+	}
+	TraceBuffers = NULL;
+	TraceFreeBuffers = NULL;
+}
+
+void Trace_Record(TraceEventType type, const char* name, float value)
+{
+	TraceBuffer* buffer = GetThreadBuffer();
+	if (buffer == NULL)
+	{
+		return;
+	}
+	// Only this thread changes the count, the atomic store publishes the event to Trace_Write
+	const Uint32 count = (Uint32)SDL_GetAtomicInt(&buffer->count);
+	TraceEvent* event = &buffer->events[count % TRACE_BUFFER_EVENTS];
+	event->timeNS = SDL_GetTicksNS();
+	event->name = name;
+	event->value = value;
+	event->type = type;
+	SDL_SetAtomicInt(&buffer->count, (int)(count + 1));
+}
+
+void Trace_SetThreadName(const char* name)
+{
+	TraceBuffer* buffer = TraceEnabled ? GetThreadBuffer() : NULL;
+	if (buffer != NULL)
+	{
+		SDL_strlcpy(buffer->threadName, name, sizeof(buffer->threadName));
+	}
+}
+
+static void WriteBuffer(SDL_IOStream* io, const TraceBuffer* buffer, TraceEvent* snapshot)
+{
+	const Uint64 tid = (Uint64)buffer->threadId;
+	SDL_IOprintf(io, ",\n{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":1,\"tid\":%" SDL_PRIu64 ",\"args\":{\"name\":\"%s\"}}", tid, buffer->threadName);
+
+	// Copy out the ring, then drop whatever the thread may have overwritten meanwhile,
+	// including the slot of the event it may be writing right now, one past the count
+	const Uint32 end = (Uint32)SDL_GetAtomicInt((SDL_AtomicInt*)&buffer->count);
+	Uint32 first = end > TRACE_BUFFER_EVENTS ? end - TRACE_BUFFER_EVENTS : 0;
+	for (Uint32 i = first; i < end; i += 1)
+	{
+		snapshot[i % TRACE_BUFFER_EVENTS] = buffer->events[i % TRACE_BUFFER_EVENTS];
+	}
+	const Uint32 recorded = (Uint32)SDL_GetAtomicInt((SDL_AtomicInt*)&buffer->count);
+	if (recorded + 1 - first > TRACE_BUFFER_EVENTS)
+	{
+		first = recorded + 1 - TRACE_BUFFER_EVENTS;
+	}
+
+	// Spans that began before the oldest event kept have lost their begin, so skip their ends
+	Uint32 depth = 0;
+	for (Uint32 i = first; i < end; i += 1)
+	{
+		const TraceEvent* event = &snapshot[i % TRACE_BUFFER_EVENTS];
+		const double ts = (double)(event->timeNS - TraceStartNS) / 1000.0;
+		switch (event->type)
+		{
+		case TRACE_EVENT_BEGIN:
+			depth += 1;
+			SDL_IOprintf(io, ",\n{\"ph\":\"B\",\"name\":\"%s\",\"pid\":1,\"tid\":%" SDL_PRIu64 ",\"ts\":%.3f}", event->name, tid, ts);
+			break;
+		case TRACE_EVENT_END:
+			if (depth > 0)
+			{
+				depth -= 1;
+				SDL_IOprintf(io, ",\n{\"ph\":\"E\",\"pid\":1,\"tid\":%" SDL_PRIu64 ",\"ts\":%.3f}", tid, ts);
+			}
+			break;
+		case TRACE_EVENT_COUNTER:
+			SDL_IOprintf(io, ",\n{\"ph\":\"C\",\"name\":\"%s\",\"pid\":1,\"tid\":%" SDL_PRIu64 ",\"ts\":%.3f,\"args\":{\"value\":%g}}", event->name, tid, ts, event->value);
+			break;
+		}
+	}
+}
+
+bool Trace_Write(const char* path)
+{
+	TraceEvent* snapshot = (TraceEvent*)SDL_malloc(sizeof(TraceEvent) * TRACE_BUFFER_EVENTS);
+	if (snapshot == NULL)
+	{
+		return false;
+	}
+	SDL_IOStream* io = SDL_IOFromFile(path, "w");
+	if (io == NULL)
+	{
+		SDL_Log("Couldn't open %s for the trace: %s", path, SDL_GetError());
+		SDL_free(snapshot);
+		return false;
+	}
+
+	SDL_IOprintf(io, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n{\"ph\":\"M\",\"name\":\"process_name\",\"pid\":1,\"args\":{\"name\":\"SDL sample\"}}");
+	for (TraceBuffer* buffer = (TraceBuffer*)SDL_GetAtomicPointer((void**)&TraceBuffers); buffer != NULL; buffer = buffer->next)
+	{
+		WriteBuffer(io, buffer, snapshot);
+	}
+	SDL_IOprintf(io, "\n]}\n");
+	SDL_free(snapshot);
+
+	if (!SDL_CloseIO(io))
+	{
+		SDL_Log("Couldn't write the trace to %s: %s", path, SDL_GetError());
+		return false;
+	}
+	SDL_Log("Wrote trace to %s", path);
+	return true;
+}
@@ -0,0 +1,83 @@
+#pragma once
+#ifndef SDL_SAMPLE_TRACE_H
+#define SDL_SAMPLE_TRACE_H
+
+#include <SDL3/SDL.h>
+
+// Events kept per thread. Older ones are overwritten, so a dump always shows
+// the most recent stretch, a few thousand frames on the main thread.
+#define TRACE_BUFFER_EVENTS (1 << 16)
+#define TRACE_THREAD_NAME_LENGTH 32
+
+typedef enum TraceEventType
+{
+	TRACE_EVENT_BEGIN,
+	TRACE_EVENT_END,
+	TRACE_EVENT_COUNTER
+} TraceEventType;
+
+typedef struct TraceEvent
+{
+	Uint64 timeNS;
+	const char* name;
+	float value;
+	TraceEventType type;
+} TraceEvent;
+
+// One per thread recording. Only its thread writes to it, and publishes each
+// event by bumping `count`, so recording takes no lock and a dump can read it
+// while the thread keeps going. Once the thread exits, the buffer goes to the
+// next thread that starts recording, keeping its events and track.
+typedef struct TraceBuffer
+{
+	struct TraceBuffer* next;
+	struct TraceBuffer* nextFree;  // while on the free list, after its thread exited
+	SDL_ThreadID threadId;
+	char threadName[TRACE_THREAD_NAME_LENGTH];
+	SDL_AtomicInt count;  // events ever recorded, the ring holds the last TRACE_BUFFER_EVENTS
+	TraceEvent events[TRACE_BUFFER_EVENTS];
+} TraceBuffer;
+
+// Set by Trace_Init, so disabled tracing costs a branch per event
+extern bool TraceEnabled;
+
+void Trace_Init(void);
+// Only once the threads that recorded have stopped
+void Trace_Quit(void);
+
+void Trace_Record(TraceEventType type, const char* name, float value);
+
+// Names must outlive the trace, string literals in practice. They are
+// written out as they are, so no quotes or backslashes.
+static inline void Trace_Begin(const char* name)
+{
+	if (TraceEnabled)
+	{
+		Trace_Record(TRACE_EVENT_BEGIN, name, 0);
+	}
+}
+
+static inline void Trace_End(void)
+{
+	if (TraceEnabled)
+	{
+		Trace_Record(TRACE_EVENT_END, NULL, 0);
+	}
+}
+
+static inline void Trace_Counter(const char* name, float value)
+{
+	if (TraceEnabled)
+	{
+		Trace_Record(TRACE_EVENT_COUNTER, name, value);
+	}
+}
+
+// Names the calling thread's track in the trace
+void Trace_SetThreadName(const char* name);
+
+// Writes every thread's events as Chrome trace JSON, which chrome://tracing
+// and ui.perfetto.dev open. Recording carries on, so it can be called any time.
+bool Trace_Write(const char* path);
+
+#endif
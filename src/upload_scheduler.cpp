@@ -0,0 +1,361 @@
+#include "upload_scheduler.h"
+
+// Offsets of the copies packed into the staging buffer. Texture copies on
+// D3D12 want 512-byte aligned sources, which also suits everything else.
+static const Uint32 STAGING_ALIGNMENT = 512;
+
+static Uint32 AlignUp(Uint32 value, Uint32 alignment)
+{
+	return (value + alignment - 1) / alignment * alignment;
+}
+
+void UploadScheduler_Init(UploadScheduler* scheduler, SDL_GPUDevice* device, Uint32 budgetBytes)
+{
+	scheduler->device = device;
+	scheduler->budgetBytes = budgetBytes;
+	scheduler->pendingBytes = 0;
+	scheduler->staging = NULL;
+	scheduler->stagingSize = 0;
+}
+
+void UploadScheduler_Release(UploadScheduler* scheduler)
+{
+	for (std::deque<UploadRequest>& queue : scheduler->pending)
+	{
+		queue.clear();
+	}
+	scheduler->pendingBytes = 0;
+	SDL_ReleaseGPUTransferBuffer(scheduler->device, scheduler->staging);
+	scheduler->staging = NULL;
+	scheduler->stagingSize = 0;
+}
+
+static std::deque<UploadRequest>::iterator FindBufferRequest(std::deque<UploadRequest>& queue, SDL_GPUBuffer* buffer, Uint32 offset)
+{
+	auto request = queue.begin();
+	while (request != queue.end() && (request->buffer != buffer || request->bufferOffset != offset))
+	{
+		++request;
+	}
+	return request;
+}
+
+void UploadScheduler_Promote(UploadScheduler* scheduler, SDL_GPUBuffer* buffer, Uint32 offset, UploadPriority priority)
+{
+	for (int lower = priority + 1; lower < UPLOAD_PRIORITY_COUNT; lower += 1)
+	{
+		std::deque<UploadRequest>& queue = scheduler->pending[lower];
+		auto request = FindBufferRequest(queue, buffer, offset);
+		if (request != queue.end())
+		{
+			scheduler->pending[priority].push_back(std::move(*request));
+			queue.erase(request);
+			return;
+		}
+	}
+}
+
+// Returns the pending request for a buffer range, reusing one that is already
+// queued at this priority or more urgent, so only the latest data goes up.
+static UploadRequest* QueueBufferRequest(
+	UploadScheduler* scheduler,
+	SDL_GPUBuffer* buffer,
+	Uint32 offset,
+	Uint32 size,
+	UploadPriority priority
+) {
+	UploadScheduler_Promote(scheduler, buffer, offset, priority);
+	for (int p = 0; p <= priority; p += 1)
+	{
+		std::deque<UploadRequest>& queue = scheduler->pending[p];
+		auto request = FindBufferRequest(queue, buffer, offset);
+		if (request == queue.end())
+		{
+			continue;
+		}
+		if (request->size == size)
+		{
+			return &*request;
+		}
+		scheduler->pendingBytes -= request->size;
+		queue.erase(request);
+		break;
+	}
+
+	scheduler->pending[priority].push_back(UploadRequest{
+		.buffer = buffer,
+		.bufferOffset = offset,
+		.size = size
+	});
+	scheduler->pendingBytes += size;
+	return &scheduler->pending[priority].back();
+}
+
+void* UploadScheduler_QueueBuffer(
+	UploadScheduler* scheduler,
+	SDL_GPUBuffer* buffer,
+	Uint32 offset,
+	Uint32 size,
+	UploadPriority priority
+) {
+	UploadRequest* request = QueueBufferRequest(scheduler, buffer, offset, size, priority);
+	request->source = NULL;
+	request->cycle = false;
+	request->data.resize(size);
+	return request->data.data();
+}
+
+void UploadScheduler_QueueBufferFrom(
+	UploadScheduler* scheduler,
+	SDL_GPUTransferBuffer* source,
+	Uint32 sourceOffset,
+	SDL_GPUBuffer* buffer,
+	Uint32 offset,
+	Uint32 size,
+	bool cycle,
+	UploadPriority priority
+) {
+	UploadRequest* request = QueueBufferRequest(scheduler, buffer, offset, size, priority);
+	request->source = source;
+	request->sourceOffset = sourceOffset;
+	request->cycle = cycle;
+	request->data.clear();
+}
+
+void* UploadScheduler_QueueTexture(
+	UploadScheduler* scheduler,
+	SDL_GPUTexture* texture,
+	SDL_Rect region,
+	Uint32 bytesPerPixel,
+	UploadPriority priority
+) {
+	const Uint32 size = (Uint32)region.w * region.h * bytesPerPixel;
+	scheduler->pending[priority].push_back(UploadRequest{
+		.texture = texture,
+		.textureRegion = region,
+		.size = size
+	});
+	scheduler->pendingBytes += size;
+
+	UploadRequest* request = &scheduler->pending[priority].back();
+	request->data.resize(size);
+	return request->data.data();
+}
+
+void* UploadScheduler_QueueTextureLevel(
+	UploadScheduler* scheduler,
+	SDL_GPUTexture* texture,
+	Uint32 mipLevel,
+	Uint32 width,
+	Uint32 height,
+	Uint32 size,
+	UploadPriority priority
+) {
+	scheduler->pending[priority].push_back(UploadRequest{
+		.texture = texture,
+		.mipLevel = mipLevel,
+		.textureRegion = SDL_Rect{ 0, 0, (int)width, (int)height },
+		.size = size
+	});
+	scheduler->pendingBytes += size;
+
+	UploadRequest* request = &scheduler->pending[priority].back();
+	request->data.resize(size);
+	return request->data.data();
+}
+
+SDL_GPUTexture* UploadScheduler_CreateTexture(UploadScheduler* scheduler, SDL_Surface* surface, UploadPriority priority)
+{
+	SDL_GPUTextureCreateInfo textureCreateInfo = {
+		.type = SDL_GPU_TEXTURETYPE_2D,
+		.format = SDL_GPU_TEXTUREFORMAT_R8G8B8A8_UNORM,
+		.usage = SDL_GPU_TEXTUREUSAGE_SAMPLER,
+		.width = (Uint32)surface->w,
+		.height = (Uint32)surface->h,
+		.layer_count_or_depth = 1,
+		.num_levels = 1,
+	};
+	SDL_GPUTexture* texture = SDL_CreateGPUTexture(scheduler->device, &textureCreateInfo);
+	if (texture == NULL)
+	{
+		SDL_Log("Failed to create texture: %s", SDL_GetError());
+		return NULL;
+	}
+
+	const SDL_Rect region = { 0, 0, surface->w, surface->h };
+	Uint8* pixels = (Uint8*)UploadScheduler_QueueTexture(scheduler, texture, region, 4, priority);
+	for (int y = 0; y < surface->h; y += 1)
+	{
+		SDL_memcpy(pixels + y * surface->w * 4, (const Uint8*)surface->pixels + y * surface->pitch, surface->w * 4);
+	}
+	return texture;
+}
+
+void UploadScheduler_CancelTexture(UploadScheduler* scheduler, SDL_GPUTexture* texture)
+{
+	for (std::deque<UploadRequest>& queue : scheduler->pending)
+	{
+		for (auto request = queue.begin(); request != queue.end();)
+		{
+			if (request->texture == texture)
+			{
+				scheduler->pendingBytes -= request->size;
+				request = queue.erase(request);
+			}
+			else
+			{
+				++request;
+			}
+		}
+	}
+}
+
+static bool ReserveStaging(UploadScheduler* scheduler, Uint32 size)
+{
+	if (size <= scheduler->stagingSize)
+	{
+		return true;
+	}
+
+	// Grow geometrically so a few large frames don't each reallocate
+	const Uint32 newSize = SDL_max(size, scheduler->stagingSize * 2);
+	auto transferBufferCreateInfo = SDL_GPUTransferBufferCreateInfo{
+		.usage = SDL_GPU_TRANSFERBUFFERUSAGE_UPLOAD,
+		.size = newSize
+	};
+	SDL_GPUTransferBuffer* staging = SDL_CreateGPUTransferBuffer(scheduler->device, &transferBufferCreateInfo);
+	if (staging == NULL)
+	{
+		SDL_Log("Failed to create upload staging buffer: %s", SDL_GetError());
+		return false;
+	}
+
+	// The release is deferred by SDL until uploads still using it have completed
+	SDL_ReleaseGPUTransferBuffer(scheduler->device, scheduler->staging);
+	scheduler->staging = staging;
+	scheduler->stagingSize = newSize;
+	return true;
+}
+
+Uint32 UploadScheduler_Flush(UploadScheduler* scheduler, SDL_GPUCommandBuffer* cmdBuf)
+{
+	if (scheduler->pendingBytes == 0)
+	{
+		return 0;
+	}
+
+	// Decide how much of each queue goes out this frame. Queues are taken in
+	// order and in full until the budget runs out, so nothing overtakes a more
+	// urgent upload. One upload always goes, even if it alone exceeds the budget.
+	size_t takeCount[UPLOAD_PRIORITY_COUNT] = {};
+	Uint32 budgetedBytes = 0;
+	Uint32 stagingBytes = 0;
+	bool budgetSpent = false;
+	for (int p = 0; p < UPLOAD_PRIORITY_COUNT && !budgetSpent; p += 1)
+	{
+		for (const UploadRequest& request : scheduler->pending[p])
+		{
+			if (p != UPLOAD_PRIORITY_VISIBLE && scheduler->budgetBytes != 0)
+			{
+				if (budgetedBytes != 0 && budgetedBytes + request.size > scheduler->budgetBytes)
+				{
+					budgetSpent = true;
+					break;
+				}
+				budgetedBytes += request.size;
+			}
+			if (request.source == NULL)
+			{
+				stagingBytes = AlignUp(stagingBytes, STAGING_ALIGNMENT) + request.size;
+			}
+			takeCount[p] += 1;
+		}
+	}
+
+	// Pack the scheduler's own copies of the data into the staging buffer
+	std::vector<Uint32> stagingOffsets;
+	if (stagingBytes != 0)
+	{
+		if (!ReserveStaging(scheduler, stagingBytes))
+		{
+			return 0;
+		}
+		// Cycling leaves last frame's staging memory alone while its copies are in flight
+		Uint8* stagingPtr = (Uint8*)SDL_MapGPUTransferBuffer(scheduler->device, scheduler->staging, true);
+		Uint32 stagingOffset = 0;
+		for (int p = 0; p < UPLOAD_PRIORITY_COUNT; p += 1)
+		{
+			for (size_t i = 0; i < takeCount[p]; i += 1)
+			{
+				const UploadRequest& request = scheduler->pending[p][i];
+				if (request.source == NULL)
+				{
+					stagingOffset = AlignUp(stagingOffset, STAGING_ALIGNMENT);
+					SDL_memcpy(stagingPtr + stagingOffset, request.data.data(), request.size);
+					stagingOffsets.push_back(stagingOffset);
+					stagingOffset += request.size;
+				}
+			}
+		}
+		SDL_UnmapGPUTransferBuffer(scheduler->device, scheduler->staging);
+	}
+
+	SDL_GPUCopyPass* copyPass = SDL_BeginGPUCopyPass(cmdBuf);
+	size_t stagingIndex = 0;
+	Uint32 recordedBytes = 0;
+	for (int p = 0; p < UPLOAD_PRIORITY_COUNT; p += 1)
+	{
+		std::deque<UploadRequest>& queue = scheduler->pending[p];
+		for (size_t i = 0; i < takeCount[p]; i += 1)
+		{
+			const UploadRequest& request = queue.front();
+
+			auto transferBufferLocation = SDL_GPUTransferBufferLocation{
+				.transfer_buffer = request.source,
+				.offset = request.sourceOffset
+			};
+			if (request.source == NULL)
+			{
+				transferBufferLocation.transfer_buffer = scheduler->staging;
+				transferBufferLocation.offset = stagingOffsets[stagingIndex];
+				stagingIndex += 1;
+			}
+
+			if (request.texture != NULL)
+			{
+				auto textureTransferInfo = SDL_GPUTextureTransferInfo{
+					.transfer_buffer = transferBufferLocation.transfer_buffer,
+					.offset = transferBufferLocation.offset,
+					.pixels_per_row = (Uint32)request.textureRegion.w,
+					.rows_per_layer = (Uint32)request.textureRegion.h
+				};
+				auto textureRegion = SDL_GPUTextureRegion{
+					.texture = request.texture,
+					.mip_level = request.mipLevel,
+					.x = (Uint32)request.textureRegion.x,
+					.y = (Uint32)request.textureRegion.y,
+					.w = (Uint32)request.textureRegion.w,
+					.h = (Uint32)request.textureRegion.h,
+					.d = 1
+				};
+				SDL_UploadToGPUTexture(copyPass, &textureTransferInfo, &textureRegion, false);
+			}
+			else
+			{
+				auto bufferRegion = SDL_GPUBufferRegion{
+					.buffer = request.buffer,
+					.offset = request.bufferOffset,
+					.size = request.size
+				};
+				SDL_UploadToGPUBuffer(copyPass, &transferBufferLocation, &bufferRegion, request.cycle);
+			}
+
+			recordedBytes += request.size;
+			scheduler->pendingBytes -= request.size;
+			queue.pop_front();
+		}
+	}
+	SDL_EndGPUCopyPass(copyPass);
+
+	return recordedBytes;
+}
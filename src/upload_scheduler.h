@@ -0,0 +1,118 @@
+#pragma once
+#ifndef SDL_SAMPLE_UPLOAD_SCHEDULER_H
+#define SDL_SAMPLE_UPLOAD_SCHEDULER_H
+
+#include <SDL3/SDL.h>
+#include <deque>
+#include <vector>
+
+// Lower values are uploaded first.
+typedef enum UploadPriority
+{
+	UPLOAD_PRIORITY_VISIBLE,     // drawn this frame, always uploaded regardless of the budget
+	UPLOAD_PRIORITY_PREFETCH,    // likely to be drawn soon
+	UPLOAD_PRIORITY_BACKGROUND,  // everything else
+	UPLOAD_PRIORITY_COUNT
+} UploadPriority;
+
+// A pending copy into a buffer range or a texture region. The source is either
+// the request's own copy of the data, or a transfer buffer owned by the caller.
+typedef struct UploadRequest
+{
+	SDL_GPUBuffer* buffer;
+	Uint32 bufferOffset;
+	SDL_GPUTexture* texture;
+	Uint32 mipLevel;
+	SDL_Rect textureRegion;
+	SDL_GPUTransferBuffer* source;
+	Uint32 sourceOffset;
+	Uint32 size;
+	bool cycle;
+	std::vector<Uint8> data;
+} UploadRequest;
+
+// Collects every upload of a frame and records them into a single copy pass,
+// most urgent first. Beyond the visible uploads, at most budgetBytes go out
+// per frame and the rest waits for the following frames, so a burst of new
+// content is spread out instead of stalling one frame.
+typedef struct UploadScheduler
+{
+	SDL_GPUDevice* device;
+	Uint32 budgetBytes;  // 0 for no limit
+	std::deque<UploadRequest> pending[UPLOAD_PRIORITY_COUNT];
+	Uint64 pendingBytes;
+	SDL_GPUTransferBuffer* staging;
+	Uint32 stagingSize;
+} UploadScheduler;
+
+void UploadScheduler_Init(UploadScheduler* scheduler, SDL_GPUDevice* device, Uint32 budgetBytes);
+void UploadScheduler_Release(UploadScheduler* scheduler);
+
+// Queues an upload of size bytes to a buffer range and returns memory for the
+// caller to fill, valid until the next call into the scheduler. A pending
+// upload to the same range is replaced, keeping the more urgent priority.
+void* UploadScheduler_QueueBuffer(
+	UploadScheduler* scheduler,
+	SDL_GPUBuffer* buffer,
+	Uint32 offset,
+	Uint32 size,
+	UploadPriority priority
+);
+
+// Same, for data the caller already staged in its own transfer buffer. That
+// transfer buffer must not be written again until the scheduler has flushed.
+// Set cycle when the upload replaces everything the buffer's readers use.
+void UploadScheduler_QueueBufferFrom(
+	UploadScheduler* scheduler,
+	SDL_GPUTransferBuffer* source,
+	Uint32 sourceOffset,
+	SDL_GPUBuffer* buffer,
+	Uint32 offset,
+	Uint32 size,
+	bool cycle,
+	UploadPriority priority
+);
+
+// Queues an upload of tightly packed pixels to a region of a texture's first
+// mip and layer, and returns memory for the caller to fill.
+void* UploadScheduler_QueueTexture(
+	UploadScheduler* scheduler,
+	SDL_GPUTexture* texture,
+	SDL_Rect region,
+	Uint32 bytesPerPixel,
+	UploadPriority priority
+);
+
+// Queues an upload of a whole mip level of a texture's first layer, size bytes
+// laid out as SDL_CalculateGPUTextureFormatSize describes, so block
+// compressed formats too, and returns memory for the caller to fill.
+void* UploadScheduler_QueueTextureLevel(
+	UploadScheduler* scheduler,
+	SDL_GPUTexture* texture,
+	Uint32 mipLevel,
+	Uint32 width,
+	Uint32 height,
+	Uint32 size,
+	UploadPriority priority
+);
+
+// Creates an R8G8B8A8 sampler texture for a 4-channel surface and queues its pixels.
+SDL_GPUTexture* UploadScheduler_CreateTexture(UploadScheduler* scheduler, SDL_Surface* surface, UploadPriority priority);
+
+// Moves a pending upload to a buffer range up to a more urgent priority, e.g.
+// because what it holds just became visible. Does nothing if none is pending.
+void UploadScheduler_Promote(UploadScheduler* scheduler, SDL_GPUBuffer* buffer, Uint32 offset, UploadPriority priority);
+
+// Drops pending uploads to a texture that is about to be released.
+void UploadScheduler_CancelTexture(UploadScheduler* scheduler, SDL_GPUTexture* texture);
+
+// Records this frame's share of the pending uploads into one copy pass on
+// cmdBuf. Returns the number of bytes recorded.
+Uint32 UploadScheduler_Flush(UploadScheduler* scheduler, SDL_GPUCommandBuffer* cmdBuf);
+
+inline bool UploadScheduler_HasPending(const UploadScheduler* scheduler)
+{
+	return scheduler->pendingBytes != 0;
+}
+
+#endif
@@ -0,0 +1,211 @@
+#include "virtual_texture.h"
+#include "trace.h"
+
+static SDL_GPUTexture* CreatePageTexture(SDL_GPUDevice* device, Uint32 width, Uint32 height)
+{
+	SDL_GPUTextureCreateInfo textureCreateInfo = {
+		.type = SDL_GPU_TEXTURETYPE_2D,
+		.format = SDL_GPU_TEXTUREFORMAT_R8G8B8A8_UNORM,
+		.usage = SDL_GPU_TEXTUREUSAGE_SAMPLER,
+		.width = width,
+		.height = height,
+		.layer_count_or_depth = 1,
+		.num_levels = 1,
+	};
+	return SDL_CreateGPUTexture(device, &textureCreateInfo);
+}
+
+// Points a virtual page's page table entry at a cache slot
+static void QueuePageTableEntry(VirtualTexture* texture, UploadScheduler* uploads, Uint32 page, Uint32 slot)
+{
+	const SDL_Rect region = { (int)(page % texture->pagesX), (int)(page / texture->pagesX), 1, 1 };
+	Uint8* entry = (Uint8*)UploadScheduler_QueueTexture(uploads, texture->pageTable, region, 4, UPLOAD_PRIORITY_PREFETCH);
+	entry[0] = (Uint8)(slot % texture->cachePagesX);
+	entry[1] = (Uint8)(slot / texture->cachePagesX);
+	entry[2] = 0;
+	entry[3] = 255;
+}
+
+static SDL_Rect SlotRegion(const VirtualTexture* texture, Uint32 slot)
+{
+	return SDL_Rect{
+		(int)(slot % texture->cachePagesX * VIRTUAL_TEXTURE_PAGE_SIZE),
+		(int)(slot / texture->cachePagesX * VIRTUAL_TEXTURE_PAGE_SIZE),
+		VIRTUAL_TEXTURE_PAGE_SIZE,
+		VIRTUAL_TEXTURE_PAGE_SIZE
+	};
+}
+
+bool VirtualTexture_Init(
+	VirtualTexture* texture,
+	SDL_GPUDevice* device,
+	UploadScheduler* uploads,
+	Uint32 width,
+	Uint32 height,
+	Uint32 cacheSize,
+	Uint32 maxLoadsPerFrame,
+	VirtualTextureLoadPage loadPage,
+	void* userdata
+) {
+	texture->pagesX = (width + VIRTUAL_TEXTURE_PAGE_SIZE - 1) / VIRTUAL_TEXTURE_PAGE_SIZE;
+	texture->pagesY = (height + VIRTUAL_TEXTURE_PAGE_SIZE - 1) / VIRTUAL_TEXTURE_PAGE_SIZE;
+	texture->cachePagesX = SDL_min(cacheSize / VIRTUAL_TEXTURE_PAGE_SIZE, 256u);
+	texture->cachePagesY = texture->cachePagesX;
+	texture->maxLoadsPerFrame = maxLoadsPerFrame;
+	texture->loadPage = loadPage;
+	texture->userdata = userdata;
+	texture->frame = 1;
+
+	const Uint32 pageCount = texture->pagesX * texture->pagesY;
+	const Uint32 slotCount = texture->cachePagesX * texture->cachePagesY;
+	texture->pageSlot.assign(pageCount, VIRTUAL_TEXTURE_NO_SLOT);
+	texture->pageRequested.assign(pageCount, 0);
+	texture->slotPage.assign(slotCount, VIRTUAL_TEXTURE_NO_SLOT);
+	texture->slotUsed.assign(slotCount, 0);
+	texture->requests.clear();
+
+	texture->pageTable = CreatePageTexture(device, texture->pagesX, texture->pagesY);
+	texture->cache = CreatePageTexture(device, texture->cachePagesX * VIRTUAL_TEXTURE_PAGE_SIZE, texture->cachePagesY * VIRTUAL_TEXTURE_PAGE_SIZE);
+	if (texture->pageTable == NULL || texture->cache == NULL)
+	{
+		SDL_Log("Failed to create virtual texture: %s", SDL_GetError());
+		VirtualTexture_Release(texture, device);
+		return false;
+	}
+
+	// Every page starts out on the placeholder in slot 0, a dim checkerboard
+	void* entries = UploadScheduler_QueueTexture(uploads, texture->pageTable, SDL_Rect{ 0, 0, (int)texture->pagesX, (int)texture->pagesY }, 4, UPLOAD_PRIORITY_VISIBLE);
+	SDL_memset(entries, 0, (size_t)pageCount * 4);
+
+	Uint8* placeholder = (Uint8*)UploadScheduler_QueueTexture(uploads, texture->cache, SlotRegion(texture, 0), 4, UPLOAD_PRIORITY_VISIBLE);
+	for (Uint32 y = 0; y < VIRTUAL_TEXTURE_PAGE_SIZE; y += 1)
+	{
+		for (Uint32 x = 0; x < VIRTUAL_TEXTURE_PAGE_SIZE; x += 1)
+		{
+			Uint8* texel = &placeholder[(y * VIRTUAL_TEXTURE_PAGE_SIZE + x) * 4];
+			const Uint8 shade = ((x / 16 + y / 16) % 2) ? 96 : 64;
+			texel[0] = shade;
+			texel[1] = shade;
+			texel[2] = shade;
+			texel[3] = 255;
+		}
+	}
+	return true;
+}
+
+void VirtualTexture_Release(VirtualTexture* texture, SDL_GPUDevice* device)
+{
+	SDL_ReleaseGPUTexture(device, texture->pageTable);
+	SDL_ReleaseGPUTexture(device, texture->cache);
+	texture->pageTable = NULL;
+	texture->cache = NULL;
+	texture->pageSlot.clear();
+	texture->pageRequested.clear();
+	texture->slotPage.clear();
+	texture->slotUsed.clear();
+	texture->requests.clear();
+}
+
+void VirtualTexture_RequestRect(VirtualTexture* texture, float u, float v, float w, float h)
+{
+	// The far edge belongs to the last page it touches, not the one after it
+	const Sint32 firstX = SDL_max((Sint32)SDL_floorf(u * texture->pagesX), 0);
+	const Sint32 firstY = SDL_max((Sint32)SDL_floorf(v * texture->pagesY), 0);
+	const Sint32 lastX = SDL_min((Sint32)SDL_ceilf((u + w) * texture->pagesX) - 1, (Sint32)texture->pagesX - 1);
+	const Sint32 lastY = SDL_min((Sint32)SDL_ceilf((v + h) * texture->pagesY) - 1, (Sint32)texture->pagesY - 1);
+
+	for (Sint32 y = firstY; y <= lastY; y += 1)
+	{
+		for (Sint32 x = firstX; x <= lastX; x += 1)
+		{
+			const Uint32 page = y * texture->pagesX + x;
+			if (texture->pageRequested[page] == texture->frame)
+			{
+				continue;
+			}
+			texture->pageRequested[page] = texture->frame;
+			texture->requests.push_back(page);
+			if (texture->pageSlot[page] != VIRTUAL_TEXTURE_NO_SLOT)
+			{
+				texture->slotUsed[texture->pageSlot[page]] = texture->frame;
+			}
+		}
+	}
+}
+
+// A free cache slot, or else the least recently requested one that wasn't
+// requested this frame. Slot 0 is the placeholder and never handed out.
+static Uint32 FindSlot(const VirtualTexture* texture)
+{
+	Uint32 best = VIRTUAL_TEXTURE_NO_SLOT;
+	for (Uint32 slot = 1; slot < (Uint32)texture->slotPage.size(); slot += 1)
+	{
+		if (texture->slotPage[slot] == VIRTUAL_TEXTURE_NO_SLOT)
+		{
+			return slot;
+		}
+		if (texture->slotUsed[slot] < texture->frame &&
+			(best == VIRTUAL_TEXTURE_NO_SLOT || texture->slotUsed[slot] < texture->slotUsed[best]))
+		{
+			best = slot;
+		}
+	}
+	return best;
+}
+
+bool VirtualTexture_Update(VirtualTexture* texture, UploadScheduler* uploads)
+{
+	// Everything below shares one upload priority, so the scheduler keeps it in
+	// order: an evicted page's entry is reset before its slot is overwritten,
+	// and a new entry only goes up after its texels.
+	Uint32 loads = 0;
+	for (Uint32 page : texture->requests)
+	{
+		if (texture->pageSlot[page] != VIRTUAL_TEXTURE_NO_SLOT)
+		{
+			continue;
+		}
+		if (loads == texture->maxLoadsPerFrame)
+		{
+			break;
+		}
+		const Uint32 slot = FindSlot(texture);
+		if (slot == VIRTUAL_TEXTURE_NO_SLOT)
+		{
+			// this frame's pages alone fill the cache
+			break;
+		}
+
+		const Uint32 evicted = texture->slotPage[slot];
+		if (evicted != VIRTUAL_TEXTURE_NO_SLOT)
+		{
+			texture->pageSlot[evicted] = VIRTUAL_TEXTURE_NO_SLOT;
+			QueuePageTableEntry(texture, uploads, evicted, 0);
+		}
+
+		Uint8* pixels = (Uint8*)UploadScheduler_QueueTexture(uploads, texture->cache, SlotRegion(texture, slot), 4, UPLOAD_PRIORITY_PREFETCH);
+		Trace_Begin("virtual page load");
+		texture->loadPage(texture->userdata, page % texture->pagesX, page / texture->pagesX, pixels);
+		Trace_End();
+		QueuePageTableEntry(texture, uploads, page, slot);
+
+		texture->slotPage[slot] = page;
+		texture->slotUsed[slot] = texture->frame;
+		texture->pageSlot[page] = slot;
+		loads += 1;
+	}
+
+	texture->requests.clear();
+	texture->frame += 1;
+	return loads != 0;
+}
+
+VirtualTextureUniforms VirtualTexture_GetUniforms(const VirtualTexture* texture)
+{
+	return VirtualTextureUniforms{
+		.virtualPagesX = (float)texture->pagesX,
+		.virtualPagesY = (float)texture->pagesY,
+		.cachePagesX = (float)texture->cachePagesX,
+		.cachePagesY = (float)texture->cachePagesY
+	};
+}
@@ -0,0 +1,73 @@
+#pragma once
+#ifndef SDL_SAMPLE_VIRTUAL_TEXTURE_H
+#define SDL_SAMPLE_VIRTUAL_TEXTURE_H
+
+#include <SDL3/SDL.h>
+#include <vector>
+#include "upload_scheduler.h"
+
+// Pages are square, in texels. The page table stores physical page positions
+// in 8 bits, so the cache can be at most 256 pages wide and high.
+#define VIRTUAL_TEXTURE_PAGE_SIZE 128
+#define VIRTUAL_TEXTURE_NO_SLOT 0xFFFFFFFF
+
+// Fills one page of RGBA8 texels, VIRTUAL_TEXTURE_PAGE_SIZE squared and tightly packed.
+typedef void (*VirtualTextureLoadPage)(void* userdata, Uint32 pageX, Uint32 pageY, Uint8* pixels);
+
+// Mirrors VirtualTextureBlock in TexturedQuadColor.frag.hlsl
+typedef struct VirtualTextureUniforms
+{
+	float virtualPagesX, virtualPagesY;
+	float cachePagesX, cachePagesY;
+} VirtualTextureUniforms;
+
+// A sprite sheet far larger than GPU memory, addressed with ordinary 0-1 UVs.
+// Only the pages requested recently live in a fixed-size physical cache
+// texture. A small page table texture maps each virtual page to its place in
+// the cache, and the sprite fragment shader goes through it (SPRITE_FEATURE_VIRTUAL).
+//
+// Each frame, the caller requests the UV rects its visible sprites showed in
+// the previous frame. VirtualTexture_Update then loads missing pages, evicting
+// the least recently requested ones. Slot 0 of the cache holds a placeholder
+// that every unloaded page points at.
+typedef struct VirtualTexture
+{
+	Uint32 pagesX, pagesY;
+	Uint32 cachePagesX, cachePagesY;
+	Uint32 maxLoadsPerFrame;
+	VirtualTextureLoadPage loadPage;
+	void* userdata;
+	SDL_GPUTexture* pageTable;
+	SDL_GPUTexture* cache;
+	std::vector<Uint32> pageSlot;        // per virtual page: cache slot, or VIRTUAL_TEXTURE_NO_SLOT
+	std::vector<Uint64> pageRequested;   // per virtual page: frame it was last requested in
+	std::vector<Uint32> slotPage;        // per cache slot: virtual page, or VIRTUAL_TEXTURE_NO_SLOT
+	std::vector<Uint64> slotUsed;        // per cache slot: frame its page was last requested in
+	std::vector<Uint32> requests;        // pages requested this frame, in order
+	Uint64 frame;
+} VirtualTexture;
+
+bool VirtualTexture_Init(
+	VirtualTexture* texture,
+	SDL_GPUDevice* device,
+	UploadScheduler* uploads,
+	Uint32 width,
+	Uint32 height,
+	Uint32 cacheSize,
+	Uint32 maxLoadsPerFrame,
+	VirtualTextureLoadPage loadPage,
+	void* userdata
+);
+void VirtualTexture_Release(VirtualTexture* texture, SDL_GPUDevice* device);
+
+// Marks every page under a rect of virtual UVs as needed.
+void VirtualTexture_RequestRect(VirtualTexture* texture, float u, float v, float w, float h);
+
+// Streams in up to maxLoadsPerFrame missing pages out of this frame's
+// requests, queueing their texels and page table entries.
+// Returns true if any page was loaded, i.e. the picture will change.
+bool VirtualTexture_Update(VirtualTexture* texture, UploadScheduler* uploads);
+
+VirtualTextureUniforms VirtualTexture_GetUniforms(const VirtualTexture* texture);
+
+#endif
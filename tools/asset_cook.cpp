@@ -0,0 +1,396 @@
+// asset-cook: turns images into cooked textures, see src/cooked_texture.h.
+//
+//   asset-cook [--premultiply] [--compress] [--no-mips] -o <directory> <image>...
+//
+// Each image is written to <directory>/<name>.gputex in R8G8B8A8 with its
+// full mip chain, or BC1/BC3 with --compress. The sample finds them in
+// Content/Cooked, where the cook-content target puts them.
+
+#include <SDL3/SDL.h>
+#include <string>
+#include <utility>
+#include <vector>
+#include "cooked_texture.h"
+#include "image_loader.h"
+
+typedef struct CookOptions
+{
+	bool premultiply;     // --premultiply: multiply color by alpha, for pipelines blending with ONE, ONE_MINUS_SRC_ALPHA
+	bool compress;        // --compress: BC1 for opaque images, BC3 for the rest, if they are a multiple of 4 texels in size
+	bool mips;            // off with --no-mips
+	const char* outputDirectory;
+} CookOptions;
+
+// Tightly packed R8G8B8A8 texels
+typedef std::vector<Uint8> Level;
+
+// Halves a level with a 2x2 box filter. Colors are weighted by their alpha,
+// so the color of transparent texels doesn't bleed into their neighbors.
+static Level Downsample(const Level& source, Uint32 width, Uint32 height)
+{
+	const Uint32 destWidth = SDL_max(width / 2, 1u);
+	const Uint32 destHeight = SDL_max(height / 2, 1u);
+	Level dest(destWidth * destHeight * 4);
+	for (Uint32 y = 0; y < destHeight; y += 1)
+	{
+		const Uint32 rows[2] = { SDL_min(y * 2, height - 1), SDL_min(y * 2 + 1, height - 1) };
+		for (Uint32 x = 0; x < destWidth; x += 1)
+		{
+			const Uint32 columns[2] = { SDL_min(x * 2, width - 1), SDL_min(x * 2 + 1, width - 1) };
+			Uint32 alpha = 0;
+			Uint32 color[3] = {};
+			for (Uint32 row : rows)
+			{
+				for (Uint32 column : columns)
+				{
+					const Uint8* texel = &source[(row * width + column) * 4];
+					alpha += texel[3];
+					for (int c = 0; c < 3; c += 1)
+					{
+						color[c] += texel[c] * texel[3];
+					}
+				}
+			}
+			Uint8* texel = &dest[(y * destWidth + x) * 4];
+			for (int c = 0; c < 3; c += 1)
+			{
+				texel[c] = alpha != 0 ? (Uint8)((color[c] + alpha / 2) / alpha) : 0;
+			}
+			texel[3] = (Uint8)((alpha + 2) / 4);
+		}
+	}
+	return dest;
+}
+
+static void Premultiply(Level& level)
+{
+	for (size_t i = 0; i < level.size(); i += 4)
+	{
+		for (int c = 0; c < 3; c += 1)
+		{
+			level[i + c] = (Uint8)((level[i + c] * level[i + 3] + 127) / 255);
+		}
+	}
+}
+
+static Uint16 PackRGB565(const int color[3])
+{
+	return (Uint16)(((color[0] * 31 + 127) / 255) << 11 | ((color[1] * 63 + 127) / 255) << 5 | ((color[2] * 31 + 127) / 255));
+}
+
+static void UnpackRGB565(Uint16 packed, int color[3])
+{
+	const int r = packed >> 11;
+	const int g = (packed >> 5) & 0x3F;
+	const int b = packed & 0x1F;
+	color[0] = (r << 3) | (r >> 2);
+	color[1] = (g << 2) | (g >> 4);
+	color[2] = (b << 3) | (b >> 2);
+}
+
+// The 8-byte BC1 color block, always in its 4-color mode. The endpoints are
+// the corners of the colors' bounding box, pulled in by 1/16 of its size,
+// which is fast and good enough for sprites if not the best fit there is.
+static void CompressColorBlock(const Uint8 block[16][4], Uint8* dest)
+{
+	int low[3] = { 255, 255, 255 };
+	int high[3] = { 0, 0, 0 };
+	for (int i = 0; i < 16; i += 1)
+	{
+		for (int c = 0; c < 3; c += 1)
+		{
+			low[c] = SDL_min(low[c], (int)block[i][c]);
+			high[c] = SDL_max(high[c], (int)block[i][c]);
+		}
+	}
+	for (int c = 0; c < 3; c += 1)
+	{
+		const int inset = (high[c] - low[c]) / 16;
+		low[c] += inset;
+		high[c] -= inset;
+	}
+
+	Uint16 endpoints[2] = { PackRGB565(high), PackRGB565(low) };
+	if (endpoints[0] < endpoints[1])
+	{
+		std::swap(endpoints[0], endpoints[1]);
+	}
+	int palette[4][3];
+	UnpackRGB565(endpoints[0], palette[0]);
+	UnpackRGB565(endpoints[1], palette[1]);
+	for (int c = 0; c < 3; c += 1)
+	{
+		palette[2][c] = (palette[0][c] * 2 + palette[1][c]) / 3;
+		palette[3][c] = (palette[0][c] + palette[1][c] * 2) / 3;
+	}
+
+	// Equal endpoints would switch the block to 3 colors, so all take the first
+	Uint32 indices = 0;
+	for (int i = 0; i < 16 && endpoints[0] != endpoints[1]; i += 1)
+	{
+		int best = 0;
+		int bestDistance = SDL_MAX_SINT32;
+		for (int p = 0; p < 4; p += 1)
+		{
+			int distance = 0;
+			for (int c = 0; c < 3; c += 1)
+			{
+				const int d = block[i][c] - palette[p][c];
+				distance += d * d;
+			}
+			if (distance < bestDistance)
+			{
+				best = p;
+				bestDistance = distance;
+			}
+		}
+		indices |= (Uint32)best << (i * 2);
+	}
+
+	dest[0] = (Uint8)endpoints[0];
+	dest[1] = (Uint8)(endpoints[0] >> 8);
+	dest[2] = (Uint8)endpoints[1];
+	dest[3] = (Uint8)(endpoints[1] >> 8);
+	for (int i = 0; i < 4; i += 1)
+	{
+		dest[4 + i] = (Uint8)(indices >> (i * 8));
+	}
+}
+
+// The 8-byte BC3 alpha block, in its mode with 6 values between the extremes
+static void CompressAlphaBlock(const Uint8 block[16][4], Uint8* dest)
+{
+	int high = 0;
+	int low = 255;
+	for (int i = 0; i < 16; i += 1)
+	{
+		high = SDL_max(high, (int)block[i][3]);
+		low = SDL_min(low, (int)block[i][3]);
+	}
+	int palette[8] = { high, low };
+	for (int p = 2; p < 8; p += 1)
+	{
+		palette[p] = ((8 - p) * high + (p - 1) * low) / 7;
+	}
+
+	Uint64 indices = 0;
+	for (int i = 0; i < 16 && high != low; i += 1)
+	{
+		int best = 0;
+		for (int p = 1; p < 8; p += 1)
+		{
+			if (SDL_abs(block[i][3] - palette[p]) < SDL_abs(block[i][3] - palette[best]))
+			{
+				best = p;
+			}
+		}
+		indices |= (Uint64)best << (i * 3);
+	}
+
+	dest[0] = (Uint8)high;
+	dest[1] = (Uint8)low;
+	for (int i = 0; i < 6; i += 1)
+	{
+		dest[2 + i] = (Uint8)(indices >> (i * 8));
+	}
+}
+
+static Level Compress(const Level& level, Uint32 width, Uint32 height, SDL_GPUTextureFormat format)
+{
+	const Uint32 blocksX = (width + 3) / 4;
+	const Uint32 blocksY = (height + 3) / 4;
+	const Uint32 blockSize = format == SDL_GPU_TEXTUREFORMAT_BC3_RGBA_UNORM ? 16 : 8;
+	Level dest(blocksX * blocksY * blockSize);
+	for (Uint32 by = 0; by < blocksY; by += 1)
+	{
+		for (Uint32 bx = 0; bx < blocksX; bx += 1)
+		{
+			// Blocks hanging over the edge of the small mips repeat the last texels
+			Uint8 block[16][4];
+			for (Uint32 i = 0; i < 16; i += 1)
+			{
+				const Uint32 x = SDL_min(bx * 4 + i % 4, width - 1);
+				const Uint32 y = SDL_min(by * 4 + i / 4, height - 1);
+				SDL_memcpy(block[i], &level[(y * width + x) * 4], 4);
+			}
+			Uint8* blockDest = &dest[(by * blocksX + bx) * blockSize];
+			if (blockSize == 16)
+			{
+				CompressAlphaBlock(block, blockDest);
+				blockDest += 8;
+			}
+			CompressColorBlock(block, blockDest);
+		}
+	}
+	return dest;
+}
+
+static bool IsOpaque(const Level& level)
+{
+	for (size_t i = 3; i < level.size(); i += 4)
+	{
+		if (level[i] != 255)
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+static const char* FormatName(SDL_GPUTextureFormat format)
+{
+	switch (format)
+	{
+	case SDL_GPU_TEXTUREFORMAT_BC1_RGBA_UNORM: return "BC1";
+	case SDL_GPU_TEXTUREFORMAT_BC3_RGBA_UNORM: return "BC3";
+	default: return "R8G8B8A8";
+	}
+}
+
+static bool Cook(const CookOptions* options, const ImageSource* source, SDL_Surface* surface)
+{
+	const Uint32 width = (Uint32)surface->w;
+	const Uint32 height = (Uint32)surface->h;
+	std::vector<Level> levels(1, Level(width * height * 4));
+	for (Uint32 y = 0; y < height; y += 1)
+	{
+		SDL_memcpy(&levels[0][y * width * 4], (const Uint8*)surface->pixels + y * surface->pitch, width * 4);
+	}
+	// The chain is filtered from straight alpha, premultiplying comes after
+	while (options->mips && (SDL_max(width, height) >> levels.size()) != 0)
+	{
+		const Uint32 level = (Uint32)levels.size() - 1;
+		levels.push_back(Downsample(levels[level], SDL_max(width >> level, 1u), SDL_max(height >> level, 1u)));
+	}
+	if (options->premultiply)
+	{
+		for (Level& level : levels)
+		{
+			Premultiply(level);
+		}
+	}
+
+	SDL_GPUTextureFormat format = SDL_GPU_TEXTUREFORMAT_R8G8B8A8_UNORM;
+	if (options->compress)
+	{
+		if (width % 4 != 0 || height % 4 != 0)
+		{
+			SDL_Log("%s is %ux%u, not whole blocks, left uncompressed", source->name, width, height);
+		}
+		else
+		{
+			format = IsOpaque(levels[0]) ? SDL_GPU_TEXTUREFORMAT_BC1_RGBA_UNORM : SDL_GPU_TEXTUREFORMAT_BC3_RGBA_UNORM;
+			for (size_t i = 0; i < levels.size(); i += 1)
+			{
+				levels[i] = Compress(levels[i], SDL_max(width >> i, 1u), SDL_max(height >> i, 1u), format);
+			}
+		}
+	}
+
+	const CookedTextureHeader header = {
+		.magic = COOKED_TEXTURE_MAGIC,
+		.version = COOKED_TEXTURE_VERSION,
+		.type = SDL_GPU_TEXTURETYPE_2D,
+		.format = (Uint32)format,
+		.usage = SDL_GPU_TEXTUREUSAGE_SAMPLER,
+		.width = width,
+		.height = height,
+		.layer_count_or_depth = 1,
+		.num_levels = (Uint32)levels.size(),
+		.sample_count = SDL_GPU_SAMPLECOUNT_1,
+		.flags = options->premultiply ? (Uint32)COOKED_TEXTURE_PREMULTIPLIED : 0u,
+		// Stamped with the image it came from, so a changed image isn't shadowed by its old cooked form
+		.source_crc32 = SDL_crc32(0, source->data, source->size),
+		.source_size = source->size,
+	};
+	std::vector<Uint8> file((const Uint8*)&header, (const Uint8*)&header + sizeof(header));
+	for (const Level& level : levels)
+	{
+		file.insert(file.end(), level.begin(), level.end());
+	}
+
+	// <directory>/<name>.gputex, whichever directory the image came from
+	std::string name = source->name;
+	const size_t slash = name.find_last_of("/\\");
+	if (slash != std::string::npos)
+	{
+		name.erase(0, slash + 1);
+	}
+	const size_t dot = name.find_last_of('.');
+	if (dot != std::string::npos)
+	{
+		name.erase(dot);
+	}
+	const std::string outputPath = std::string(options->outputDirectory) + "/" + name + COOKED_TEXTURE_EXTENSION;
+	if (!SDL_SaveFile(outputPath.c_str(), file.data(), file.size()))
+	{
+		SDL_Log("Failed to write %s: %s", outputPath.c_str(), SDL_GetError());
+		return false;
+	}
+	SDL_Log("%s: %ux%u %s, %u levels, %zu bytes", outputPath.c_str(), width, height, FormatName(format), header.num_levels, file.size());
+	return true;
+}
+
+int main(int argc, char* argv[])
+{
+	CookOptions options = {
+		.mips = true,
+	};
+	std::vector<const char*> inputs;
+	for (int i = 1; i < argc; i += 1)
+	{
+		if (SDL_strcmp(argv[i], "--premultiply") == 0)
+		{
+			options.premultiply = true;
+		}
+		else if (SDL_strcmp(argv[i], "--compress") == 0)
+		{
+			options.compress = true;
+		}
+		else if (SDL_strcmp(argv[i], "--no-mips") == 0)
+		{
+			options.mips = false;
+		}
+		else if (SDL_strcmp(argv[i], "-o") == 0 && i + 1 < argc)
+		{
+			options.outputDirectory = argv[++i];
+		}
+		else
+		{
+			inputs.push_back(argv[i]);
+		}
+	}
+	if (options.outputDirectory == NULL || inputs.empty())
+	{
+		SDL_Log("Usage: asset-cook [--premultiply] [--compress] [--no-mips] -o <directory> <image>...");
+		return 1;
+	}
+	if (!SDL_CreateDirectory(options.outputDirectory))
+	{
+		SDL_Log("Failed to create %s: %s", options.outputDirectory, SDL_GetError());
+		return 1;
+	}
+
+	// Read everything, then decode it all in parallel like the sample does
+	std::vector<ImageSource> sources(inputs.size());
+	for (size_t i = 0; i < inputs.size(); i += 1)
+	{
+		sources[i].name = inputs[i];
+		sources[i].data = SDL_LoadFile(inputs[i], &sources[i].size);
+		if (sources[i].data == NULL)
+		{
+			SDL_Log("Failed to read %s: %s", inputs[i], SDL_GetError());
+		}
+	}
+	std::vector<SDL_Surface*> surfaces(inputs.size());
+	Image_DecodeBatch(sources.data(), surfaces.data(), (Uint32)inputs.size(), 0);
+
+	bool succeeded = true;
+	for (size_t i = 0; i < inputs.size(); i += 1)
+	{
+		succeeded = surfaces[i] != NULL && Cook(&options, &sources[i], surfaces[i]) && succeeded;
+		SDL_DestroySurface(surfaces[i]);
+		SDL_free((void*)sources[i].data);
+	}
+	return succeeded ? 0 : 1;
+}